@@ -7,9 +7,32 @@ if(NOT TARGET cinder-sprite)
 
     # Make a list of source files and define that to be ${SOURCE_LIST}.
     file(GLOB SOURCE_LIST CONFIGURE_DEPENDS
+            "${cinder-sprite_PROJECT_ROOT}/src/archive.cpp"
+            "${cinder-sprite_PROJECT_ROOT}/src/array.cpp"
+            "${cinder-sprite_PROJECT_ROOT}/src/batch.cpp"
+            "${cinder-sprite_PROJECT_ROOT}/src/buffer.cpp"
+            "${cinder-sprite_PROJECT_ROOT}/src/cache.cpp"
+            "${cinder-sprite_PROJECT_ROOT}/src/cluster.cpp"
+            "${cinder-sprite_PROJECT_ROOT}/src/color.cpp"
+            "${cinder-sprite_PROJECT_ROOT}/src/context.cpp"
+            "${cinder-sprite_PROJECT_ROOT}/src/dirty.cpp"
+            "${cinder-sprite_PROJECT_ROOT}/src/display.cpp"
+            "${cinder-sprite_PROJECT_ROOT}/src/flipbook.cpp"
+            "${cinder-sprite_PROJECT_ROOT}/src/jobs.cpp"
+            "${cinder-sprite_PROJECT_ROOT}/src/memory.cpp"
+            "${cinder-sprite_PROJECT_ROOT}/src/offline.cpp"
+            "${cinder-sprite_PROJECT_ROOT}/src/pool.cpp"
+            "${cinder-sprite_PROJECT_ROOT}/src/preload.cpp"
+            "${cinder-sprite_PROJECT_ROOT}/src/profiler.cpp"
             "${cinder-sprite_PROJECT_ROOT}/src/provider.cpp"
             "${cinder-sprite_PROJECT_ROOT}/src/resizer.cpp"
+            "${cinder-sprite_PROJECT_ROOT}/src/saliency.cpp"
+            "${cinder-sprite_PROJECT_ROOT}/src/scene.cpp"
+            "${cinder-sprite_PROJECT_ROOT}/src/scheduler.cpp"
+            "${cinder-sprite_PROJECT_ROOT}/src/shader.cpp"
             "${cinder-sprite_PROJECT_ROOT}/src/sprite.cpp"
+            "${cinder-sprite_PROJECT_ROOT}/src/text.cpp"
+            "${cinder-sprite_PROJECT_ROOT}/src/tiled.cpp"
             )
 
     # Create the library!
@@ -21,6 +44,13 @@ if(NOT TARGET cinder-sprite)
     target_include_directories(cinder-sprite PUBLIC "${cinder-sprite_PROJECT_ROOT}/src" )
     target_include_directories(cinder-sprite SYSTEM BEFORE PUBLIC "${CINDER_PATH}/include" )
 
+    # Scoped timers, gpu timer queries and allocation counters, see src/profiler.h.
+    # Off by default, in which case the instrumentation compiles out entirely.
+    option(CINDER_SPRITE_PROFILING "Build cinder-sprite with performance instrumentation" OFF)
+    if(CINDER_SPRITE_PROFILING)
+        target_compile_definitions(cinder-sprite PUBLIC CINDER_SPRITE_PROFILING)
+    endif()
+
 
     # If your Cinder block has no source code but instead pre-build libraries,
     # you can specify all of them here (uncomment the below line and adjust to your needs).
@@ -0,0 +1,171 @@
+#include "cinder/app/App.h"
+#include "cinder/app/RendererGl.h"
+#include "cinder/gl/gl.h"
+#include "cinder/ImageIo.h"
+#include "cinder/Log.h"
+#include "cinder/Timer.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+#if defined( CINDER_LINUX ) || defined( CINDER_MAC )
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "archive.h"
+#include "color.h"
+
+using namespace ci;
+using namespace ci::app;
+using namespace std;
+
+// Usage:
+//   ArchiveBuilder --build <asset dir> <archive>
+//   ArchiveBuilder --bench <asset dir> <archive>
+//
+// --build packs every png and jpg under the asset dir, named by their
+// path relative to it. --bench uploads every asset from loose files and
+// then from the archive, first with the files evicted from the page
+// cache (cold) and then again (warm), then checks each archived asset
+// draws the same as its loose file.
+
+class ArchiveBuilderApp : public App {
+public:
+  void setup() override;
+  vector<string> find_assets(const fs::path & root);
+  void evict(const fs::path & path);
+  double load_loose(const fs::path & root, const vector<string> & names);
+  double load_archive(const fs::path & archive, const vector<string> & names);
+  size_t compare(const fs::path & root, const fs::path & archive, const vector<string> & names);
+};
+
+vector<string> ArchiveBuilderApp::find_assets(const fs::path & root) {
+  vector<string> names;
+  for(fs::recursive_directory_iterator it(root), end; it != end; ++it) {
+    string ext = it->path().extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+    if(ext == ".png" || ext == ".jpg" || ext == ".jpeg") {
+      string name = it->path().string().substr(root.string().size() + 1);
+      std::replace(name.begin(), name.end(), '\\', '/');
+      names.push_back(name);
+    }
+  }
+  std::sort(names.begin(), names.end());
+  return names;
+}
+
+/**
+ * Drop a file from the page cache so the next read comes from disk
+ */
+void ArchiveBuilderApp::evict(const fs::path & path) {
+#if defined( CINDER_LINUX )
+  int fd = ::open(path.string().c_str(), O_RDONLY);
+  if(fd >= 0) {
+    fdatasync(fd);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    ::close(fd);
+  }
+#endif
+}
+
+double ArchiveBuilderApp::load_loose(const fs::path & root, const vector<string> & names) {
+  Timer timer(true);
+  vector<gl::TextureRef> textures;
+  for(auto & name : names) {
+    textures.push_back(gl::Texture::create(loadImage(loadFile(root / name))));
+  }
+  glFinish();
+  return timer.getSeconds();
+}
+
+double ArchiveBuilderApp::load_archive(const fs::path & archive, const vector<string> & names) {
+  Timer timer(true);
+  asset_archive_ref packed = asset_archive::open(archive);
+  vector<gl::TextureRef> textures;
+  asset_archive::entry e;
+  for(auto & name : names) {
+    if(packed->find(name, e)) textures.push_back(asset_archive::create_texture(e));
+  }
+  glFinish();
+  return timer.getSeconds();
+}
+
+/**
+ * Draw each asset from its loose file and from the archive into the
+ * same fbo and compare the pixels, so orientation and channel order
+ * match the loose path; returns the assets that differ
+ */
+size_t ArchiveBuilderApp::compare(const fs::path & root, const fs::path & archive, const vector<string> & names) {
+  asset_archive_ref packed = asset_archive::open(archive);
+  size_t mismatched = 0;
+  asset_archive::entry e;
+  for(auto & name : names) {
+    if(!packed->find(name, e)) {
+      CI_LOG_W(name << " is missing from the archive");
+      mismatched++;
+      continue;
+    }
+    gl::TextureRef loose = gl::Texture::create(loadImage(loadFile(root / name)), color_policy::get_texture_format());
+    gl::TextureRef archived = asset_archive::create_texture(e);
+
+    auto render = [](const gl::TextureRef & texture) {
+      gl::FboRef fbo = gl::Fbo::create(texture->getWidth(), texture->getHeight(), gl::Fbo::Format().disableDepth());
+      gl::ScopedFramebuffer scoped_fbo(fbo);
+      gl::ScopedViewport scoped_viewport(ivec2(0), fbo->getSize());
+      gl::ScopedMatrices scoped_matrices;
+      gl::setMatricesWindow(fbo->getSize());
+      gl::clear(ColorA(0, 0, 0, 0));
+      gl::draw(texture, Rectf(fbo->getBounds()));
+      return fbo->readPixels8u(fbo->getBounds());
+    };
+    Surface8u a = render(loose);
+    Surface8u b = render(archived);
+
+    // decoders may round a level differently, a flipped or swizzled image differs by far more
+    bool same = a.getSize() == b.getSize();
+    for(int y = 0; same && y < a.getHeight(); y++) {
+      for(int x = 0; same && x < a.getWidth(); x++) {
+        ColorA8u p = a.getPixel(ivec2(x, y)), q = b.getPixel(ivec2(x, y));
+        same = std::abs(p.r - q.r) <= 2 && std::abs(p.g - q.g) <= 2 && std::abs(p.b - q.b) <= 2 && std::abs(p.a - q.a) <= 2;
+      }
+    }
+    if(!same) {
+      CI_LOG_W(name << " draws differently from the archive");
+      mismatched++;
+    }
+  }
+  return mismatched;
+}
+
+void ArchiveBuilderApp::setup() {
+  auto args = getCommandLineArgs();
+  if(args.size() < 4) {
+    CI_LOG_E("Usage: ArchiveBuilder --build|--bench <asset dir> <archive>");
+    quit();
+    return;
+  }
+
+  fs::path root = args[2];
+  fs::path archive = args[3];
+  vector<string> names = find_assets(root);
+
+  if(args[1] == "--build") {
+    asset_archive::build(root, names, archive);
+  } else if(args[1] == "--bench") {
+    for(auto & name : names) evict(root / name);
+    evict(archive);
+    double cold_loose = load_loose(root, names);
+    double cold_archive = load_archive(archive, names);
+    double warm_loose = load_loose(root, names);
+    double warm_archive = load_archive(archive, names);
+
+    CI_LOG_I(names.size() << " assets");
+    CI_LOG_I("cold: loose " << cold_loose << "s, archive " << cold_archive << "s");
+    CI_LOG_I("warm: loose " << warm_loose << "s, archive " << warm_archive << "s");
+    CI_LOG_I("mismatched: " << compare(root, archive, names) << " of " << names.size());
+  }
+  quit();
+}
+
+CINDER_APP(ArchiveBuilderApp, RendererGl)
@@ -0,0 +1,203 @@
+#include "cinder/app/App.h"
+#include "cinder/app/RendererGl.h"
+#include "cinder/gl/gl.h"
+#include "cinder/Log.h"
+#include "cinder/Rand.h"
+
+#include "cluster.h"
+#include "display.h"
+#include "provider.h"
+#include "scheduler.h"
+#include "sprite.h"
+
+using namespace ci;
+using namespace ci::app;
+using namespace std;
+
+// Usage:
+//   ClusterDemo --master <nodes> [port]
+//   ClusterDemo --node <id> <master host> <nodes> [port]
+//
+// Every process shows one column of a canvas nodes + 1 windows wide, the
+// master the first. To try it on one machine over loopback:
+//
+//   ClusterDemo --master 2 &
+//   ClusterDemo --node 1 127.0.0.1 2 &
+//   ClusterDemo --node 2 127.0.0.1 2 &
+//
+// The master shuffles the sprites every few seconds and logs the skew
+// between the nodes once a second, space shuffles now.
+
+class stripes : public graphics_provider {
+public:
+  stripes(cluster_sync_ref sync, Font label_font) : graphics_provider(vec2(512, 512)) {
+    cluster = sync;
+    font = label_font;
+    phase = 0;
+  }
+
+  // from the synced time, so nodes that joined late show the same phase
+  void update() override {
+    phase = (int)(cluster->get_time() * 15.0);
+    graphics_provider::update();
+  }
+
+  // a frame counter you can read across the seam, so stepping is visible
+  void draw() override {
+    gl::clear(Color(0.1f, 0.1f, 0.1f));
+    for(int i = 0; i < 8; i++) {
+      gl::color(Color(CM_HSV, ((phase + i) % 8) / 8.0f, 0.8f, 1.0f));
+      gl::drawSolidRect(Rectf(i * 64.0f, 0, i * 64.0f + 64.0f, 512));
+    }
+    gl::color(Color::white());
+    gl::drawString(to_string(phase), vec2(16, 16), Color::white(), font);
+  }
+
+  cluster_sync_ref cluster;
+  Font font;
+  int phase;
+};
+
+class ClusterDemoApp : public App {
+public:
+  void setup() override;
+  void update() override;
+  void draw() override;
+  void keyDown(KeyEvent e) override;
+  void shuffle(uint32_t seed);
+
+  cluster_sync_ref cluster;
+  display_wall_ref wall;
+  display_view_ref view;
+  vector<sprite_ref> sprites;
+  vector<gl::TextureRef> textures;
+  vec2 canvas;
+  double last_shuffle;
+  double last_report;
+  uint32_t seed;
+};
+
+void ClusterDemoApp::setup() {
+  last_shuffle = 0.0;
+  last_report = 0.0;
+  seed = 1;
+
+  auto args = getCommandLineArgs();
+  int nodes = 0;
+  int column = 0;
+  if(args.size() >= 3 && args[1] == "--master") {
+    nodes = stoi(args[2]);
+    uint16_t port = args.size() >= 4 ? (uint16_t)stoi(args[3]) : 9100;
+    cluster = cluster_sync::create_master(port, nodes);
+  } else if(args.size() >= 5 && args[1] == "--node") {
+    column = stoi(args[2]);
+    nodes = stoi(args[4]);
+    uint16_t port = args.size() >= 6 ? (uint16_t)stoi(args[5]) : 9100;
+    cluster = cluster_sync::create_node(args[3], port, column);
+  } else {
+    CI_LOG_E("Usage: ClusterDemo --master <nodes> [port] | --node <id> <master host> <nodes> [port]");
+    quit();
+    return;
+  }
+  getWindow()->setTitle(cluster->is_master() ? "master" : "node " + to_string(column));
+
+  vec2 size = getWindowSize();
+  canvas = vec2(size.x * (nodes + 1), size.y);
+  wall = display_wall::create();
+  view = display_view::create(getWindow(), Rectf(vec2(size.x * column, 0), vec2(size.x * (column + 1), size.y)));
+  wall->add_view(view);
+
+  // the same layout everywhere, from the same seed
+  Rand rand(7);
+  for(int i = 0; i < 8; i++) {
+    Surface8u surface(128, 128, true);
+    Color c(CM_HSV, i / 8.0f, 0.6f, 1.0f);
+    auto it = surface.getIter();
+    while(it.line()) {
+      while(it.pixel()) {
+        bool check = ((it.x() / 16) + (it.y() / 16)) % 2 == 0;
+        it.r() = check ? (uint8_t)(c.r * 255) : 32;
+        it.g() = check ? (uint8_t)(c.g * 255) : 32;
+        it.b() = check ? (uint8_t)(c.b * 255) : 32;
+        it.a() = 255;
+      }
+    }
+    textures.push_back(gl::Texture::create(surface));
+  }
+  for(int i = 0; i < 200; i++) {
+    auto sp = sprite::create(image_provider::create(textures[i % textures.size()]));
+    sp->set_coordinates(vec2(rand.nextFloat(canvas.x - 128), rand.nextFloat(canvas.y - 128)));
+    wall->add(sp);
+    sprites.push_back(sp);
+  }
+
+  // stepped on the master's clock, so every node shows the same phase
+  Font font("Arial", 64);
+  for(int i = 0; i < nodes; i++) {
+    auto panel = make_shared<stripes>(cluster, font);
+    provider_scheduler::add(panel, 15.0);
+    auto sp = sprite::create(panel);
+    sp->set_origin(sprite::origin_point::Center);
+    sp->set_coordinates(vec2(size.x * (i + 1), size.y * 0.5f));
+    wall->add(sp);
+  }
+
+  cluster->on("shuffle", [this](const string & payload) {
+    shuffle((uint32_t)stoul(payload));
+  });
+}
+
+/**
+ * Runs on every process in the same frame, so the tweens line up
+ */
+void ClusterDemoApp::shuffle(uint32_t shuffle_seed) {
+  Rand rand(shuffle_seed);
+  for(size_t i = 0; i < sprites.size(); i++) {
+    vec2 target(rand.nextFloat(canvas.x - 128), rand.nextFloat(canvas.y - 128));
+    sprites[i]->move_to(target, 1.5f, rand.nextFloat(0.5f));
+  }
+}
+
+void ClusterDemoApp::keyDown(KeyEvent e) {
+  if(e.getCode() == KeyEvent::KEY_SPACE && cluster && cluster->is_master()) {
+    cluster->send("shuffle", to_string(seed++));
+  }
+}
+
+void ClusterDemoApp::update() {
+  if(!cluster) return;
+  cluster->begin_frame();
+  wall->update(cluster->get_time());
+  if(!cluster->is_master() || !cluster->is_connected()) return;
+
+  double t = cluster->get_time();
+  if(t - last_shuffle > 4.0) {
+    last_shuffle = t;
+    cluster->send("shuffle", to_string(seed++));
+  }
+  if(t - last_report >= 1.0) {
+    last_report = t;
+    auto stats = cluster->get_stats();
+    CI_LOG_I("frame=" << cluster->get_frame()
+      << " nodes=" << cluster->get_node_count()
+      << " skew=" << stats.last_skew_ms << "ms"
+      << " mean_skew=" << stats.mean_skew_ms << "ms"
+      << " max_skew=" << stats.max_skew_ms << "ms"
+      << " wait=" << stats.mean_wait_ms << "ms"
+      << " timeouts=" << stats.timeouts);
+  }
+}
+
+void ClusterDemoApp::draw() {
+  gl::clear(Color(0, 0, 0));
+  if(!cluster) return;
+  wall->draw(view);
+  if(cluster->is_master() && !cluster->is_connected()) {
+    gl::drawString("Waiting for nodes, " + to_string(cluster->get_node_count()) + " joined", vec2(30, 30));
+  }
+  cluster->end_frame();
+}
+
+CINDER_APP(ClusterDemoApp, RendererGl, [](App::Settings * settings) {
+  settings->setWindowSize(960, 540);
+})
@@ -5,6 +5,7 @@
 // cinder-sprite
 #include "sprite.h"
 #include "provider.h"
+#include "scheduler.h"
 
 using namespace ci;
 using namespace ci::app;
@@ -51,6 +52,7 @@ class GraphicsSpriteDemoApp : public App {
 void GraphicsSpriteDemoApp::setup() {
   graphics = std::make_shared<custom_graphics>(vec2(512, 512));
   sp = sprite::create(graphics);
+  provider_scheduler::add(graphics, 60);
   loop();
 }
 
@@ -63,7 +65,7 @@ void GraphicsSpriteDemoApp::loop() {
 }
 
 void GraphicsSpriteDemoApp::update() {
-  graphics->update();
+  provider_scheduler::update();
 }
 
 void GraphicsSpriteDemoApp::draw() {
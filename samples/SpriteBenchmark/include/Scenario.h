@@ -0,0 +1,81 @@
+#pragma once
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "cinder/Rand.h"
+#include "cinder/Surface.h"
+#include "cinder/gl/Texture.h"
+
+/////////////////////////////////////////////////
+//
+//  scenario
+//  One benchmark workload, driven a frame at a
+//  time by SpriteBenchmarkApp into a 1920x1080
+//  offscreen target
+//
+/////////////////////////////////////////////////
+class scenario {
+public:
+  virtual ~scenario() {}
+
+  // build the workload, count is the --count argument (ie. number of sprites)
+  virtual void setup(int count) = 0;
+
+  // advance one frame, t is seconds since setup
+  virtual void update(double t) {}
+
+  virtual void draw() = 0;
+
+  // extra values to report alongside the frame timings
+  virtual std::map<std::string, double> get_metrics() { return {}; }
+
+  // number of elements the scenario ended up using
+  int count = 0;
+};
+
+typedef std::shared_ptr<scenario> scenario_ref;
+typedef std::function<scenario_ref()> scenario_factory;
+
+// scenarios in the order they run
+std::vector<std::pair<std::string, scenario_factory>> & get_scenarios();
+
+class scenario_registration {
+public:
+  scenario_registration(const std::string & name, scenario_factory factory) {
+    get_scenarios().push_back({ name, factory });
+  }
+};
+
+#define REGISTER_SCENARIO(name, type) \
+  static scenario_registration type##_registration(name, [] { return std::make_shared<type>(); })
+
+// the benchmark's render target size
+const ci::ivec2 benchmark_size(1920, 1080);
+
+// a deterministic test pattern, so runs are comparable
+inline ci::Surface8u make_test_surface(ci::ivec2 size, uint32_t seed) {
+  ci::Rand rand(seed);
+  ci::Color a(rand.nextFloat(), rand.nextFloat(), rand.nextFloat());
+  ci::Color b(rand.nextFloat(), rand.nextFloat(), rand.nextFloat());
+  ci::Surface8u surface(size.x, size.y, true);
+  auto it = surface.getIter();
+  while(it.line()) {
+    while(it.pixel()) {
+      bool check = ((it.x() / 16) + (it.y() / 16)) % 2 == 0;
+      ci::Color c = check ? a : b;
+      it.r() = (uint8_t)(c.r * 255);
+      it.g() = (uint8_t)(c.g * 255);
+      it.b() = (uint8_t)(c.b * 255);
+      it.a() = 255;
+    }
+  }
+  return surface;
+}
+
+inline ci::gl::TextureRef make_test_texture(ci::ivec2 size, uint32_t seed) {
+  return ci::gl::Texture::create(make_test_surface(size, seed));
+}
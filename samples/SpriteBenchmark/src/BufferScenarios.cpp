@@ -0,0 +1,91 @@
+#include <atomic>
+#include <cstring>
+#include <thread>
+
+#include "cinder/app/App.h"
+#include "cinder/gl/gl.h"
+
+#include "Scenario.h"
+#include "buffer.h"
+#include "sprite.h"
+
+using namespace ci;
+using namespace ci::app;
+using namespace std;
+
+/////////////////////////////////////////////////
+//  a producer thread writing frames into a
+//  buffer_provider as fast as it can, reports
+//  upload throughput for one frame size
+/////////////////////////////////////////////////
+class buffer_streaming : public scenario {
+public:
+  buffer_streaming(ivec2 size) : frame_size(size) {}
+
+  ~buffer_streaming() {
+    running = false;
+    if(producer.joinable()) producer.join();
+  }
+
+  void setup(int n) override {
+    count = 1;
+    provider = buffer_provider::create(frame_size);
+    sp = sprite::create(provider);
+    sp->set_scale(vec2(benchmark_size) / vec2(frame_size));
+
+    running = true;
+    producer = std::thread([this] {
+      uint8_t value = 0;
+      size_t bytes = provider->get_row_bytes() * frame_size.y;
+      while(running) {
+        uint8_t * pixels = provider->begin_frame();
+        if(!pixels) {
+          std::this_thread::yield();
+          continue;
+        }
+        std::memset(pixels, value++, bytes);
+        provider->end_frame();
+      }
+    });
+  }
+
+  void update(double t) override {
+    elapsed = t;
+    provider->update();
+  }
+
+  void draw() override {
+    sp->draw();
+  }
+
+  map<string, double> get_metrics() override {
+    double seconds = std::max(elapsed, 0.001);
+    double frame_mb = (double)provider->get_row_bytes() * frame_size.y / (1024.0 * 1024.0);
+    return {
+      { "width", (double)frame_size.x },
+      { "height", (double)frame_size.y },
+      { "persistent", provider->is_persistent() ? 1.0 : 0.0 },
+      { "produced_fps", provider->get_published_frames() / seconds },
+      { "uploaded_fps", provider->get_uploaded_frames() / seconds },
+      { "upload_mb_per_second", provider->get_uploaded_frames() * frame_mb / seconds },
+      { "dropped_frames", (double)provider->get_dropped_frames() }
+    };
+  }
+
+  ivec2 frame_size;
+  double elapsed = 0.0;
+  buffer_provider_ref provider;
+  sprite_ref sp;
+  std::thread producer;
+  std::atomic<bool> running;
+};
+
+static scenario_registration buffer_streaming_720p("buffer_streaming_720p", [] {
+  return std::make_shared<buffer_streaming>(ivec2(1280, 720));
+});
+static scenario_registration buffer_streaming_1080p("buffer_streaming_1080p", [] {
+  return std::make_shared<buffer_streaming>(ivec2(1920, 1080));
+});
+static scenario_registration buffer_streaming_4k("buffer_streaming_4k", [] {
+  return std::make_shared<buffer_streaming>(ivec2(3840, 2160));
+});
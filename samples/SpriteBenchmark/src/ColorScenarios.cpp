@@ -0,0 +1,95 @@
+#include <algorithm>
+
+#include "cinder/app/App.h"
+#include "cinder/gl/gl.h"
+
+#include "Scenario.h"
+#include "color.h"
+#include "memory.h"
+#include "provider.h"
+#include "sprite.h"
+
+using namespace ci;
+using namespace ci::app;
+using namespace std;
+
+namespace {
+  // a flat color fading from transparent on the left to opaque on the right
+  Surface8u make_gradient_surface(ivec2 size, uint32_t seed) {
+    Surface8u surface = make_test_surface(size, seed);
+    auto it = surface.getIter();
+    while(it.line()) {
+      while(it.pixel()) {
+        it.a() = (uint8_t)(it.x() * 255 / std::max(size.x - 1, 1));
+      }
+    }
+    return surface;
+  }
+}
+
+/////////////////////////////////////////////////
+//  N alpha gradients drawn over a checkerboard
+//  with linear blending, reads the result back
+//  and reports how far it is from the cpu
+//  reference blend, in 8 bit steps
+/////////////////////////////////////////////////
+class linear_blend : public scenario {
+public:
+  ~linear_blend() {
+    color_policy::set_linear_blending(false);
+  }
+
+  void setup(int n) override {
+    count = std::min(n, 16);
+    color_policy::set_linear_blending(true);
+
+    background_surface = make_test_surface(ivec2(512), 1400);
+    background = sprite::create(image_provider::create(
+      gl::Texture::create(background_surface, color_policy::get_texture_format())));
+    for(int i = 0; i < count; i++) {
+      overlay_surfaces.push_back(make_gradient_surface(ivec2(256), 1401 + i));
+      auto sp = sprite::create(image_provider::create(
+        gl::Texture::create(overlay_surfaces.back(), color_policy::get_texture_format())));
+      sp->set_coordinates(vec2(i * 16, i * 12));
+      sp->set_alpha(0.75f);
+      overlays.push_back(sp);
+    }
+
+    target = gl::Fbo::create(512, 512, sprite::get_fbo_format());
+  }
+
+  void draw() override {
+    {
+      gl::ScopedFramebuffer scoped_fbo(target);
+      gl::ScopedViewport scoped_viewport(ivec2(0), target->getSize());
+      gl::ScopedMatrices scoped_matrices;
+      gl::setMatricesWindow(target->getSize());
+      gl::clear(ColorA(0, 0, 0, 0));
+      background->draw();
+      for(auto & sp : overlays) sp->draw();
+    }
+    gl::draw(target->getColorTexture());
+  }
+
+  map<string, double> get_metrics() override {
+    Surface8u expected = background_surface;
+    for(size_t i = 0; i < overlays.size(); i++) {
+      expected = blend_reference::composite(expected, overlay_surfaces[i], ivec2(i * 16, i * 12), 0.75f, true);
+    }
+    vec2 error = blend_reference::compare(target->readPixels8u(target->getBounds()), expected);
+    GLint format = target->getColorTexture()->getInternalFormat();
+    return {
+      { "max_error", error.x },
+      { "mean_error", error.y },
+      { "srgb_target", color_policy::is_srgb(color_policy::get_format(format)) ? 1.0 : 0.0 },
+      { "bytes_per_pixel", gpu_memory::get_bytes_per_pixel(format) }
+    };
+  }
+
+  Surface8u background_surface;
+  vector<Surface8u> overlay_surfaces;
+  sprite_ref background;
+  vector<sprite_ref> overlays;
+  gl::FboRef target;
+};
+REGISTER_SCENARIO("linear_blend", linear_blend);
@@ -0,0 +1,698 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <thread>
+
+#include "cinder/app/App.h"
+#include "cinder/gl/gl.h"
+#include "cinder/Rand.h"
+#include "cinder/Timer.h"
+#include "cinder/ip/Fill.h"
+
+#include "Scenario.h"
+#include "array.h"
+#include "batch.h"
+#include "flipbook.h"
+#include "jobs.h"
+#include "provider.h"
+#include "resizer.h"
+#include "saliency.h"
+#include "scheduler.h"
+#include "sprite.h"
+
+using namespace ci;
+using namespace ci::app;
+using namespace std;
+
+/////////////////////////////////////////////////
+//  N static sprites sharing one texture
+/////////////////////////////////////////////////
+class static_sprites : public scenario {
+public:
+  void setup(int n) override {
+    count = n;
+    Rand rand(1);
+    auto texture = make_test_texture(ivec2(64), 1);
+    for(int i = 0; i < n; i++) {
+      auto sp = sprite::create(image_provider::create(texture));
+      sp->set_coordinates(vec2(rand.nextFloat(benchmark_size.x), rand.nextFloat(benchmark_size.y)));
+      sprites.push_back(sp);
+    }
+  }
+
+  void draw() override {
+    for(auto & sp : sprites) sp->draw();
+  }
+
+  vector<sprite_ref> sprites;
+};
+REGISTER_SCENARIO("static_sprites", static_sprites);
+
+/////////////////////////////////////////////////
+//  N sprites moving, fading and scaling
+/////////////////////////////////////////////////
+class tweening_sprites : public scenario {
+public:
+  void setup(int n) override {
+    count = n;
+    auto texture = make_test_texture(ivec2(64), 2);
+    for(int i = 0; i < n; i++) {
+      sprites.push_back(sprite::create(image_provider::create(texture)));
+      tweens.push_back(nullptr);
+    }
+  }
+
+  void update(double t) override {
+    for(size_t i = 0; i < sprites.size(); i++) {
+      if(!tweens[i] || tweens[i]->isComplete()) {
+        vec2 target(rand.nextFloat(benchmark_size.x), rand.nextFloat(benchmark_size.y));
+        float duration = rand.nextFloat(0.5f, 2.0f);
+        tweens[i] = sprites[i]->move_to(target, duration);
+        sprites[i]->alpha_to(rand.nextFloat(0.2f, 1.0f), duration);
+        sprites[i]->scale_to(rand.nextFloat(0.5f, 2.0f), duration);
+      }
+    }
+  }
+
+  void draw() override {
+    for(auto & sp : sprites) sp->draw();
+  }
+
+  Rand rand = Rand(2);
+  vector<sprite_ref> sprites;
+  vector<TweenRef<vec2>> tweens;
+};
+REGISTER_SCENARIO("tweening_sprites", tweening_sprites);
+
+/////////////////////////////////////////////////
+//  sprites zooming every frame, each zoom
+//  step recomposites the sprite's fbo
+/////////////////////////////////////////////////
+class zoom_animation : public scenario {
+public:
+  void setup(int n) override {
+    count = std::min(n, 64);
+    for(int i = 0; i < count; i++) {
+      auto sp = sprite::create(image_provider::create(make_test_texture(ivec2(256), 100 + i)));
+      sp->set_coordinates(vec2((i % 8) * 240, (i / 8) * 135));
+      sprites.push_back(sp);
+    }
+  }
+
+  void update(double t) override {
+    for(size_t i = 0; i < sprites.size(); i++) {
+      sprites[i]->set_zoom(0.45f + 0.45f * (float)sin(t * 2.0 + i));
+    }
+  }
+
+  void draw() override {
+    for(auto & sp : sprites) sp->draw();
+  }
+
+  vector<sprite_ref> sprites;
+};
+REGISTER_SCENARIO("zoom_animation", zoom_animation);
+
+/////////////////////////////////////////////////
+//  sprites revealing and hiding with masks
+/////////////////////////////////////////////////
+class mask_animation : public scenario {
+public:
+  void setup(int n) override {
+    count = n;
+    Rand rand(4);
+    auto texture = make_test_texture(ivec2(128), 4);
+    for(int i = 0; i < n; i++) {
+      auto sp = sprite::create(image_provider::create(texture));
+      sp->set_coordinates(vec2(rand.nextFloat(benchmark_size.x), rand.nextFloat(benchmark_size.y)));
+      sprites.push_back(sp);
+      tweens.push_back(nullptr);
+      revealed.push_back(true);
+    }
+  }
+
+  void update(double t) override {
+    for(size_t i = 0; i < sprites.size(); i++) {
+      if(!tweens[i] || tweens[i]->isComplete()) {
+        auto type = (i % 2) ? sprite::mask_type::LeftToRight : sprite::mask_type::RightToLeft;
+        tweens[i] = revealed[i]
+          ? sprites[i]->mask_hide(type, 1.0f)
+          : sprites[i]->mask_reveal(type, 1.0f);
+        revealed[i] = !revealed[i];
+      }
+    }
+  }
+
+  void draw() override {
+    for(auto & sp : sprites) sp->draw();
+  }
+
+  vector<sprite_ref> sprites;
+  vector<TweenRef<Rectf>> tweens;
+  vector<bool> revealed;
+};
+REGISTER_SCENARIO("mask_animation", mask_animation);
+
+/////////////////////////////////////////////////
+//  a tenth of the sprites get a new provider
+//  every frame, like a paging gallery
+/////////////////////////////////////////////////
+class provider_churn : public scenario {
+public:
+  void setup(int n) override {
+    count = n;
+    Rand rand(5);
+    for(int i = 0; i < 16; i++) {
+      textures.push_back(make_test_texture(ivec2(128), 500 + i));
+    }
+    for(int i = 0; i < n; i++) {
+      auto sp = sprite::create(image_provider::create(textures[i % textures.size()]));
+      sp->set_coordinates(vec2(rand.nextFloat(benchmark_size.x), rand.nextFloat(benchmark_size.y)));
+      sprites.push_back(sp);
+    }
+  }
+
+  void update(double t) override {
+    int changes = std::max(1, count / 10);
+    for(int i = 0; i < changes; i++) {
+      size_t index = (next + i) % sprites.size();
+      sprites[index]->set_provider(image_provider::create(textures[(next + i * 7) % textures.size()]));
+    }
+    next += changes;
+  }
+
+  void draw() override {
+    for(auto & sp : sprites) sp->draw();
+  }
+
+  int next = 0;
+  vector<gl::TextureRef> textures;
+  vector<sprite_ref> sprites;
+};
+REGISTER_SCENARIO("provider_churn", provider_churn);
+
+/////////////////////////////////////////////////
+//  texture_resizer over a batch of images
+/////////////////////////////////////////////////
+class resizer_batch : public scenario {
+public:
+  void setup(int n) override {
+    count = std::min(n, 32);
+    for(int i = 0; i < count; i++) {
+      ivec2 size = (i % 2) ? ivec2(1600, 900) : ivec2(900, 1600);
+      textures.push_back(make_test_texture(size, 600 + i));
+    }
+  }
+
+  void draw() override {
+    float top_left[2] = { 0.0f, 0.0f };
+    float bottom_right[2] = { -0.75f, -0.75f };
+    for(int i = 0; i < count; i++) {
+      auto fit = (i % 2) ? texture_resizer::options::Crop : texture_resizer::options::Scale;
+      auto result = texture_resizer::process(
+        textures[i], benchmark_size, top_left, bottom_right, texture_resizer::options(fit, vec2(1.0f)));
+      Rectf dst = result.get_bounds() + vec2((i % 4) * 480, (i / 4 % 4) * 270);
+      gl::draw(result.get_texture(), dst);
+    }
+  }
+
+  vector<gl::TextureRef> textures;
+};
+REGISTER_SCENARIO("resizer_batch", resizer_batch);
+
+/////////////////////////////////////////////////
+//  smart crops for a batch import, N images a
+//  frame on the cpu, each with a subject placed
+//  away from the center; reports throughput and
+//  how often the crop kept the subject, then the
+//  same batch again from the crop cache
+/////////////////////////////////////////////////
+class smart_crop_import : public scenario {
+public:
+  void setup(int n) override {
+    count = std::min(n, 256);
+    saliency::clear_cache();
+    saliency::reset_stats();
+    Rand rand(700);
+    for(int i = 0; i < count; i++) {
+      ivec2 size = (i % 2) ? ivec2(1024, 683) : ivec2(683, 1024);
+      Surface8u image(size.x, size.y, false);
+      ip::fill(&image, Color8u(96 + rand.nextInt(64), 96 + rand.nextInt(64), 96 + rand.nextInt(64)));
+
+      // a busy, colorful subject a fifth of the image across
+      Surface8u subject = make_test_surface(size / 5, 800 + i);
+      ivec2 at(rand.nextInt(size.x - subject.getWidth()), rand.nextInt(size.y - subject.getHeight()));
+      image.copyFrom(subject, subject.getBounds(), at);
+      subjects.push_back(Rectf(at, at + subject.getSize()).getCenter());
+      images.push_back(image);
+    }
+  }
+
+  void update(double t) override {
+    bool cached = frame % 2 == 1;
+    for(int i = 0; i < count; i++) {
+      float aspect = (i % 2) ? 9.0f / 16.0f : 16.0f / 9.0f;
+      Rectf crop = cached
+        ? saliency::find_crop("import/" + std::to_string(i), images[i], aspect)
+        : saliency::find_crop(images[i], aspect);
+      if(cached) continue;
+      kept += crop.contains(subjects[i]) ? 1 : 0;
+      measured++;
+      // prime the cache for the next frame
+      saliency::put_cached("import/" + std::to_string(i), aspect, crop.scaled(1.0f / vec2(images[i].getSize())));
+    }
+    frame++;
+  }
+
+  void draw() override {}
+
+  map<string, double> get_metrics() override {
+    auto stats = saliency::get_stats();
+    double ms = stats.computed ? stats.compute_ms / stats.computed : 0.0;
+    return {
+      { "ms_per_image", ms },
+      { "images_per_second", ms > 0.0 ? 1000.0 / ms : 0.0 },
+      { "subject_kept", measured ? kept / measured : 0.0 },
+      { "cache_hits", (double)stats.cache_hits }
+    };
+  }
+
+  int64_t frame = 0;
+  double kept = 0.0;
+  double measured = 0.0;
+  vector<Surface8u> images;
+  vector<vec2> subjects;
+};
+REGISTER_SCENARIO("smart_crop_import", smart_crop_import);
+
+/////////////////////////////////////////////////
+//  video-like streams, a full texture upload
+//  per stream per frame
+/////////////////////////////////////////////////
+class streaming_provider : public texture_provider {
+public:
+  streaming_provider(ivec2 size, uint32_t seed) : surface(size.x, size.y, true), frame(0) {
+    Rand rand(seed);
+    auto it = surface.getIter();
+    while(it.line()) {
+      while(it.pixel()) {
+        it.r() = (uint8_t)rand.nextUint(256);
+        it.g() = (uint8_t)rand.nextUint(256);
+        it.b() = (uint8_t)rand.nextUint(256);
+        it.a() = 255;
+      }
+    }
+    texture_is_new = false;
+    set_texture(gl::Texture::create(surface));
+  }
+
+  vec2 get_size() override { return surface.getSize(); }
+
+  bool is_ready() override { return true; }
+
+  void set_source(std::string path) override {}
+
+  void update() override {
+    // touch a row so every frame's contents differ
+    frame++;
+    uint8_t * row = surface.getData(ivec2(0, frame % surface.getHeight()));
+    row[0] = (uint8_t)frame;
+    texture->update(surface);
+    set_texture(texture);
+  }
+
+  Surface8u surface;
+  int frame;
+};
+
+class video_streaming : public scenario {
+public:
+  void setup(int n) override {
+    count = std::min(n, 8);
+    for(int i = 0; i < count; i++) {
+      auto stream = std::make_shared<streaming_provider>(ivec2(1280, 720), 700 + i);
+      auto sp = sprite::create(stream);
+      sp->set_scale(0.25f);
+      sp->set_coordinates(vec2((i % 4) * 480, (i / 4) * 270));
+      streams.push_back(stream);
+      sprites.push_back(sp);
+    }
+  }
+
+  void update(double t) override {
+    for(auto & stream : streams) stream->update();
+  }
+
+  void draw() override {
+    for(auto & sp : sprites) sp->draw();
+  }
+
+  map<string, double> get_metrics() override {
+    return { { "upload_bytes_per_frame", (double)count * 1280 * 720 * 4 } };
+  }
+
+  vector<std::shared_ptr<streaming_provider>> streams;
+  vector<sprite_ref> sprites;
+};
+REGISTER_SCENARIO("video_streaming", video_streaming);
+
+/////////////////////////////////////////////////
+//  streams at 24, 30 and 60 fps paced by the
+//  provider_scheduler under a 4ms update cap
+/////////////////////////////////////////////////
+class paced_streams : public scenario {
+public:
+  void setup(int n) override {
+    count = std::min(n, 12);
+    provider_scheduler::clear();
+    provider_scheduler::set_time_cap(4.0);
+    const double rates[] = { 24.0, 30.0, 60.0 };
+    for(int i = 0; i < count; i++) {
+      auto stream = std::make_shared<streaming_provider>(ivec2(640, 360), 800 + i);
+      provider_scheduler::add(stream, rates[i % 3], i % 3);
+      auto sp = sprite::create(stream);
+      sp->set_scale(0.75f);
+      sp->set_coordinates(vec2((i % 4) * 480, (i / 4) * 270));
+      streams.push_back(stream);
+      sprites.push_back(sp);
+    }
+    provider_scheduler::reset_stats();
+  }
+
+  void update(double t) override {
+    provider_scheduler::update();
+  }
+
+  void draw() override {
+    for(auto & sp : sprites) sp->draw();
+  }
+
+  map<string, double> get_metrics() override {
+    auto stats = provider_scheduler::get_stats();
+    return {
+      { "updates", (double)stats.updates },
+      { "skipped", (double)stats.skipped },
+      { "deferred", (double)stats.deferred },
+      { "mean_jitter_ms", stats.mean_jitter_ms },
+      { "max_jitter_ms", stats.max_jitter_ms },
+      { "display_rate", provider_scheduler::get_display_rate() }
+    };
+  }
+
+  vector<std::shared_ptr<streaming_provider>> streams;
+  vector<sprite_ref> sprites;
+};
+REGISTER_SCENARIO("paced_streams", paced_streams);
+
+/////////////////////////////////////////////////
+//  a large cpu generated image where only a
+//  small block changes each frame
+/////////////////////////////////////////////////
+class region_updates : public scenario {
+public:
+  void setup(int n) override {
+    count = std::min(n, 16);
+    surface = Surface8u(2048, 2048, true);
+    std::memset(surface.getData(), 0, surface.getRowBytes() * surface.getHeight());
+    for(int i = 0; i < count; i++) {
+      auto provider = image_provider::create(gl::Texture::create(surface));
+      auto sp = sprite::create(provider);
+      sp->set_scale(0.125f);
+      sp->set_coordinates(vec2((i % 8) * 256, (i / 8) * 256));
+      providers.push_back(provider);
+      sprites.push_back(sp);
+    }
+  }
+
+  void update(double t) override {
+    frame++;
+    for(size_t i = 0; i < providers.size(); i++) {
+      int x = (int)((frame * 64 + i * 320) % 2048) / block * block;
+      int y = (int)((frame / 32 * 64 + i * 128) % 2048) / block * block;
+      Area area(x, y, x + block, y + block);
+      uint8_t value = (uint8_t)(frame * 8);
+      for(int row = area.y1; row < area.y2; row++) {
+        std::memset(surface.getData(ivec2(area.x1, row)), value, block * 4);
+      }
+      providers[i]->update_region(surface, area);
+    }
+  }
+
+  void draw() override {
+    for(auto & sp : sprites) sp->draw();
+  }
+
+  map<string, double> get_metrics() override {
+    return { { "upload_bytes_per_frame", (double)count * block * block * 4 } };
+  }
+
+  const int block = 64;
+  int frame = 0;
+  Surface8u surface;
+  vector<image_provider_ref> providers;
+  vector<sprite_ref> sprites;
+};
+REGISTER_SCENARIO("region_updates", region_updates);
+
+/////////////////////////////////////////////////
+//  one image shown by N sprites, half of them
+//  zoomed, with three small regions written each
+//  frame; the updates reach the sprites as one
+//  notification and each group composites once
+/////////////////////////////////////////////////
+class shared_provider : public scenario {
+public:
+  void setup(int n) override {
+    count = std::min(n, 200);
+    surface = make_test_surface(ivec2(512), 1400);
+    provider = image_provider::create(gl::Texture::create(surface));
+    for(int i = 0; i < count; i++) {
+      auto sp = sprite::create(provider);
+      sp->set_scale(0.25f);
+      sp->set_coordinates(vec2((i % 15) * 128, (i / 15 % 8) * 128));
+      if(i % 2) sp->set_zoom(0.5f);
+      sprites.push_back(sp);
+    }
+    texture_provider::reset_update_stats();
+    sprite::reset_fbo_stats();
+  }
+
+  void update(double t) override {
+    for(int i = 0; i < 3; i++) {
+      int x = (int)((frame * 3 + i) * 32 % 512);
+      Area area(x, i * 64, x + 32, i * 64 + 32);
+      for(int row = area.y1; row < area.y2; row++) {
+        std::memset(surface.getData(ivec2(area.x1, row)), (uint8_t)(frame * 8), 32 * 4);
+      }
+      provider->update_region(surface, area);
+    }
+    frame++;
+  }
+
+  void draw() override {
+    for(auto & sp : sprites) sp->draw();
+  }
+
+  map<string, double> get_metrics() override {
+    double frames = (double)std::max(frame, 1);
+    return {
+      { "texture_updates_per_frame", texture_provider::get_update_count() / frames },
+      { "notifications_per_frame", texture_provider::get_notify_count() / frames },
+      { "fbo_renders_per_frame", sprite::get_fbo_render_count() / frames },
+      { "fbo_renders_shared_per_frame", sprite::get_fbo_shared_count() / frames }
+    };
+  }
+
+  int frame = 0;
+  Surface8u surface;
+  image_provider_ref provider;
+  vector<sprite_ref> sprites;
+};
+REGISTER_SCENARIO("shared_provider", shared_provider);
+
+/////////////////////////////////////////////////
+//  flipbooks playing from one shared sheet,
+//  a frame change is a recomposite, no upload
+/////////////////////////////////////////////////
+class flipbooks : public scenario {
+public:
+  void setup(int n) override {
+    count = std::min(n, 500);
+
+    // an 8 x 8 sheet of numbered-looking frames
+    ivec2 frame_size(128);
+    Surface8u sheet(frame_size.x * 8, frame_size.y * 8, true);
+    auto it = sheet.getIter();
+    while(it.line()) {
+      while(it.pixel()) {
+        int index = (it.y() / frame_size.y) * 8 + it.x() / frame_size.x;
+        bool bar = (it.x() % frame_size.x) < index * 2;
+        it.r() = bar ? 255 : 32;
+        it.g() = (uint8_t)(index * 4);
+        it.b() = 96;
+        it.a() = 255;
+      }
+    }
+    auto texture = gl::Texture::create(sheet);
+
+    Rand rand(8);
+    for(int i = 0; i < count; i++) {
+      auto book = flipbook_provider::create(texture, frame_size, 64, rand.nextFloat(12.0f, 60.0f));
+      book->set_frame(rand.nextInt(64));
+      book->play();
+      auto sp = sprite::create(book);
+      sp->set_scale(0.5f);
+      sp->set_coordinates(vec2(rand.nextFloat(benchmark_size.x - 64), rand.nextFloat(benchmark_size.y - 64)));
+      books.push_back(book);
+      sprites.push_back(sp);
+    }
+  }
+
+  void draw() override {
+    for(auto & sp : sprites) sp->draw();
+  }
+
+  vector<flipbook_provider_ref> books;
+  vector<sprite_ref> sprites;
+};
+REGISTER_SCENARIO("flipbooks", flipbooks);
+
+/////////////////////////////////////////////////
+//  a grid of thumbnails in one texture array,
+//  drawn with one call, a few swapped per frame
+/////////////////////////////////////////////////
+class thumbnail_grid : public scenario {
+public:
+  void setup(int n) override {
+    count = n;
+    ivec2 thumb_size(96);
+    pool = texture_array_pool::create(thumb_size, n + swaps_per_frame);
+    batch = sprite_batch::create(pool);
+    for(int i = 0; i < 16; i++) {
+      images.push_back(std::make_shared<Surface8u>(make_test_surface(thumb_size, i)));
+    }
+
+    int columns = std::max(1, (int)std::ceil(std::sqrt(n * benchmark_size.x / (float)benchmark_size.y)));
+    vec2 cell = vec2(benchmark_size) / (float)columns;
+    for(int i = 0; i < n; i++) {
+      auto provider = array_provider::create(pool);
+      provider->set_surface(images[i % images.size()]);
+      auto sp = sprite::create(provider);
+      sp->set_scale(cell.x / thumb_size.x * 0.9f);
+      sp->set_coordinates(vec2(i % columns, i / columns) * cell);
+      batch->add(sp);
+      sprites.push_back(sp);
+    }
+  }
+
+  void update(double t) override {
+    // swapping a provider returns its layer to the free list for the next one
+    for(int i = 0; i < swaps_per_frame && !sprites.empty(); i++) {
+      auto provider = array_provider::create(pool);
+      provider->set_surface(images[(next + i) % images.size()]);
+      sprites[(next * 7 + i) % sprites.size()]->set_provider(provider);
+    }
+    next += swaps_per_frame;
+  }
+
+  void draw() override {
+    batch->draw();
+  }
+
+  map<string, double> get_metrics() override {
+    return {
+      { "layers", (double)pool->get_layer_count() },
+      { "free_layers", (double)pool->get_free_layers() },
+      { "drawn", (double)batch->get_drawn() }
+    };
+  }
+
+  const int swaps_per_frame = 4;
+  int next = 0;
+  texture_array_pool_ref pool;
+  sprite_batch_ref batch;
+  vector<Surface8uRef> images;
+  vector<sprite_ref> sprites;
+};
+REGISTER_SCENARIO("thumbnail_grid", thumbnail_grid);
+
+/////////////////////////////////////////////////
+//  N moving sprites in one batch, their quads
+//  built on 1, 2, 4... threads up to one per
+//  core in turn; reports the build time for
+//  each thread count and its speedup over one
+/////////////////////////////////////////////////
+class parallel_prepare : public scenario {
+public:
+  ~parallel_prepare() {
+    job_system::set_thread_count(0);
+  }
+
+  void setup(int n) override {
+    count = n;
+    unsigned cores = std::max(std::thread::hardware_concurrency(), 1u);
+    for(unsigned threads = 1; threads < cores; threads *= 2) thread_counts.push_back(threads);
+    thread_counts.push_back(cores);
+
+    // sprites share a few layers, a pool cannot have a layer each
+    ivec2 thumb_size(32);
+    pool = texture_array_pool::create(thumb_size, 16);
+    batch = sprite_batch::create(pool);
+    for(int i = 0; i < 16; i++) {
+      auto provider = array_provider::create(pool);
+      provider->set_surface(std::make_shared<Surface8u>(make_test_surface(thumb_size, 1600 + i)));
+      providers.push_back(provider);
+    }
+    Rand rand(1601);
+    for(int i = 0; i < n; i++) {
+      auto sp = sprite::create(providers[i % providers.size()]);
+      homes.push_back(vec2(rand.nextFloat(benchmark_size.x), rand.nextFloat(benchmark_size.y)));
+      batch->add(sp);
+      sprites.push_back(sp);
+    }
+  }
+
+  void update(double t) override {
+    for(size_t i = 0; i < sprites.size(); i++) {
+      sprites[i]->set_coordinates(homes[i] + vec2(std::cos(t + i), std::sin(t + i)) * 20.0f);
+    }
+
+    unsigned threads = thread_counts[frame % thread_counts.size()];
+    job_system::set_thread_count(threads);
+    Timer timer(true);
+    batch->prepare(Rectf(vec2(0), vec2(benchmark_size)));
+    prepare_ms[threads] += timer.getSeconds() * 1000.0;
+    prepares[threads]++;
+    frame++;
+  }
+
+  void draw() override {
+    batch->submit();
+  }
+
+  map<string, double> get_metrics() override {
+    map<string, double> metrics;
+    double one = prepares[1] ? prepare_ms[1] / prepares[1] : 0.0;
+    for(unsigned threads : thread_counts) {
+      if(!prepares[threads]) continue;
+      double ms = prepare_ms[threads] / prepares[threads];
+      metrics["prepare_ms_" + std::to_string(threads)] = ms;
+      metrics["speedup_" + std::to_string(threads)] = ms > 0.0 ? one / ms : 0.0;
+    }
+    auto stats = job_system::get_stats();
+    metrics["stolen_fraction"] = stats.jobs ? (double)stats.steals / stats.jobs : 0.0;
+    metrics["drawn"] = (double)batch->get_drawn();
+    return metrics;
+  }
+
+  int64_t frame = 0;
+  vector<unsigned> thread_counts;
+  map<unsigned, double> prepare_ms;
+  map<unsigned, int> prepares;
+  texture_array_pool_ref pool;
+  sprite_batch_ref batch;
+  vector<array_provider_ref> providers;
+  vector<sprite_ref> sprites;
+  vector<vec2> homes;
+};
+REGISTER_SCENARIO("parallel_prepare", parallel_prepare);
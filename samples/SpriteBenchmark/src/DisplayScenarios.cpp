@@ -0,0 +1,291 @@
+#include <cstring>
+#include <map>
+
+#include "cinder/app/App.h"
+#include "cinder/gl/gl.h"
+#include "cinder/Rand.h"
+
+#include "Scenario.h"
+#include "dirty.h"
+#include "display.h"
+#include "provider.h"
+#include "scheduler.h"
+#include "sprite.h"
+
+using namespace ci;
+using namespace ci::app;
+using namespace std;
+
+namespace {
+  class spinner : public graphics_provider {
+  public:
+    spinner(float turn) : graphics_provider(vec2(512, 512)) {
+      angle = turn;
+    }
+
+    void update() override {
+      angle += 0.02f;
+      graphics_provider::update();
+    }
+
+    void draw() override {
+      gl::ScopedModelMatrix scoped_model;
+      gl::translate(vec2(256));
+      gl::rotate(angle);
+      gl::color(Color(CM_HSV, fmodf(angle * 0.1f, 1.0f), 0.8f, 1.0f));
+      gl::drawSolidRect(Rectf(-160, -160, 160, 160));
+      gl::color(Color::white());
+    }
+
+    float angle;
+  };
+}
+
+/////////////////////////////////////////////////
+//  a 3840x2160 canvas shown by four offscreen
+//  views, one per quadrant, standing in for the
+//  outputs of a video wall; graphics panels that
+//  straddle the views render once per frame
+/////////////////////////////////////////////////
+class multi_view : public scenario {
+public:
+  void setup(int n) override {
+    count = n;
+    ivec2 canvas = benchmark_size * 2;
+    wall = display_wall::create();
+    for(int i = 0; i < 4; i++) {
+      vec2 ul((i % 2) * benchmark_size.x, (i / 2) * benchmark_size.y);
+      wall->add_view(display_view::create(benchmark_size / 2, Rectf(ul, ul + vec2(benchmark_size))));
+    }
+
+    for(int i = 0; i < 16; i++) {
+      thumbs.push_back(make_test_texture(ivec2(128), 1200 + i));
+    }
+    Rand rand(43);
+    for(int i = 0; i < n; i++) {
+      auto sp = sprite::create(image_provider::create(thumbs[i % thumbs.size()]));
+      sp->set_coordinates(vec2(rand.nextFloat(canvas.x - 128), rand.nextFloat(canvas.y - 128)));
+      wall->add(sp);
+    }
+
+    // centred on the seams, so each is seen by two or four views
+    provider_scheduler::clear();
+    const vec2 seams[] = {
+      vec2(canvas) * 0.5f,
+      vec2(canvas.x * 0.25f, canvas.y * 0.5f),
+      vec2(canvas.x * 0.75f, canvas.y * 0.5f),
+      vec2(canvas.x * 0.5f, canvas.y * 0.25f),
+      vec2(canvas.x * 0.5f, canvas.y * 0.75f)
+    };
+    for(size_t i = 0; i < 5; i++) {
+      auto panel = make_shared<spinner>(i * 0.5f);
+      provider_scheduler::add(panel, 1000.0);
+      auto sp = sprite::create(panel);
+      sp->set_origin(sprite::origin_point::Center);
+      sp->set_coordinates(seams[i]);
+      wall->add(sp);
+      panels.push_back(panel);
+    }
+    graphics_provider::reset_resolve_stats();
+  }
+
+  void update(double t) override {
+    wall->update();
+    frames++;
+  }
+
+  void draw() override {
+    wall->draw_offscreen();
+    auto & views = wall->get_views();
+    for(size_t i = 0; i < views.size(); i++) {
+      vec2 ul((i % 2) * benchmark_size.x / 2, (i / 2) * benchmark_size.y / 2);
+      gl::draw(views[i]->get_texture(), Rectf(ul, ul + vec2(benchmark_size) * 0.5f));
+      drawn += views[i]->get_drawn();
+      culled += views[i]->get_culled();
+    }
+  }
+
+  map<string, double> get_metrics() override {
+    double n = (double)std::max<uint64_t>(frames, 1);
+    return {
+      { "views", (double)wall->get_views().size() },
+      { "drawn_per_view", drawn / n / wall->get_views().size() },
+      { "culled_per_view", culled / n / wall->get_views().size() },
+      { "panel_renders_per_frame", graphics_provider::get_resolve_count() / n },
+      { "panels", (double)panels.size() }
+    };
+  }
+
+  uint64_t frames = 0;
+  double drawn = 0.0;
+  double culled = 0.0;
+  display_wall_ref wall;
+  vector<gl::TextureRef> thumbs;
+  vector<std::shared_ptr<spinner>> panels;
+};
+REGISTER_SCENARIO("multi_view", multi_view);
+
+/////////////////////////////////////////////////
+//  the same canvas shown by an offscreen view in
+//  the resource context and one in a second
+//  context sharing its objects; spinning panels
+//  render and composite in the resource context
+//  each frame and both views must show the same
+/////////////////////////////////////////////////
+class shared_context : public scenario {
+public:
+  void setup(int n) override {
+    count = n;
+    wall = display_wall::create();
+    other = gl::Context::create(gl::context());
+    Rectf area(vec2(0), vec2(benchmark_size));
+    local = display_view::create(benchmark_size / 2, area);
+    shared = display_view::create(other, benchmark_size / 2, area);
+    wall->add_view(local);
+    wall->add_view(shared);
+
+    for(int i = 0; i < 16; i++) {
+      thumbs.push_back(make_test_texture(ivec2(128), 1600 + i));
+    }
+    Rand rand(44);
+    for(int i = 0; i < n; i++) {
+      auto sp = sprite::create(image_provider::create(thumbs[i % thumbs.size()]));
+      sp->set_coordinates(vec2(rand.nextFloat(benchmark_size.x - 128), rand.nextFloat(benchmark_size.y - 128)));
+      wall->add(sp);
+    }
+
+    provider_scheduler::clear();
+    for(int i = 0; i < 4; i++) {
+      auto panel = make_shared<spinner>(i * 0.5f);
+      provider_scheduler::add(panel, 0.0);
+      auto sp = sprite::create(panel);
+      sp->set_origin(sprite::origin_point::Center);
+      sp->set_coordinates(vec2(benchmark_size) * vec2(0.2f + i * 0.2f, 0.5f));
+      wall->add(sp);
+      panels.push_back(panel);
+    }
+  }
+
+  void update(double t) override {
+    wall->update();
+  }
+
+  void draw() override {
+    wall->draw_offscreen();
+    gl::draw(local->get_texture(), Rectf(vec2(0), vec2(benchmark_size) * vec2(0.5f, 1.0f)));
+    gl::draw(shared->get_texture(), Rectf(vec2(benchmark_size) * vec2(0.5f, 0.0f), vec2(benchmark_size)));
+
+    // compare now and then, the second context finishes its frame first
+    if(frame++ % 30 == 0) {
+      gl::Context * previous = gl::Context::getCurrent();
+      other->makeCurrent();
+      glFinish();
+      previous->makeCurrent();
+      Surface8u a(local->get_texture()->createSource());
+      Surface8u b(shared->get_texture()->createSource());
+      size_t bytes = a.getRowBytes() * a.getHeight();
+      compared++;
+      if(b.getRowBytes() * b.getHeight() == bytes && std::memcmp(a.getData(), b.getData(), bytes) == 0) matched++;
+    }
+  }
+
+  map<string, double> get_metrics() override {
+    return {
+      { "frames_compared", compared },
+      { "frames_matched", matched },
+      { "views_match", compared > 0 && matched == compared ? 1.0 : 0.0 }
+    };
+  }
+
+  uint64_t frame = 0;
+  double compared = 0.0;
+  double matched = 0.0;
+  display_wall_ref wall;
+  gl::ContextRef other;
+  display_view_ref local;
+  display_view_ref shared;
+  vector<gl::TextureRef> thumbs;
+  vector<std::shared_ptr<spinner>> panels;
+};
+REGISTER_SCENARIO("shared_context", shared_context);
+
+/////////////////////////////////////////////////
+//  a kiosk at rest: N thumbnails that stay put,
+//  one fading in and out every two seconds and
+//  a marker hopping every half second; frames
+//  with nothing changed are skipped, the rest
+//  redraw only the damage into a canvas that
+//  keeps its contents
+/////////////////////////////////////////////////
+class idle_kiosk : public scenario {
+public:
+  ~idle_kiosk() {
+    dirty_tracker::set_enabled(false);
+    dirty_tracker::set_buffer_count(2);
+  }
+
+  void setup(int n) override {
+    count = n;
+    dirty_tracker::set_buffer_count(1);
+    dirty_tracker::set_enabled(true);
+    dirty_tracker::reset_stats();
+    canvas = gl::Fbo::create(benchmark_size.x, benchmark_size.y, gl::Fbo::Format().disableDepth());
+
+    for(int i = 0; i < 16; i++) {
+      thumbs.push_back(make_test_texture(ivec2(96), 1500 + i));
+    }
+    for(int i = 0; i < n; i++) {
+      auto sp = sprite::create(image_provider::create(thumbs[i % thumbs.size()]));
+      sp->set_coordinates(vec2((i % 19) * 100 + 10, (i / 19 % 10) * 106 + 10));
+      sprites.push_back(sp);
+    }
+    marker = sprite::create(image_provider::create(make_test_texture(ivec2(24), 1520)));
+    sprites.push_back(marker);
+  }
+
+  void update(double t) override {
+    if(frame % 120 == 0 && sprites.size() > 1) {
+      auto & sp = sprites[(frame / 120) % (sprites.size() - 1)];
+      sp->alpha_to(0.25f, 0.5f);
+      sp->alpha_to(1.0f, 0.5f, 0.0f, easeInOutQuad, true);
+    }
+    if(frame % 30 == 0) {
+      marker->set_coordinates(vec2((frame / 30 % 40) * 48, benchmark_size.y - 40));
+    }
+    frame++;
+  }
+
+  void draw() override {
+    if(dirty_tracker::begin_frame(benchmark_size)) {
+      gl::ScopedFramebuffer scoped_fbo(canvas);
+      dirty_tracker::scoped_damage scoped_damage(canvas->getSize());
+      gl::clear(Color::black());
+      Rectf damage(dirty_tracker::get_frame_damage());
+      for(auto & sp : sprites) {
+        if(!sp->get_bounds().intersects(damage)) continue;
+        sp->draw();
+        drawn++;
+      }
+    }
+    gl::draw(canvas->getColorTexture());
+  }
+
+  map<string, double> get_metrics() override {
+    auto stats = dirty_tracker::get_stats();
+    double frames = (double)std::max<uint64_t>(stats.frames, 1);
+    return {
+      { "skipped_fraction", dirty_tracker::get_skipped_fraction() },
+      { "damaged_fraction", dirty_tracker::get_damaged_fraction() },
+      { "damaged_pixels_per_frame", stats.damaged_pixels / frames },
+      { "sprites_drawn_per_frame", drawn / frames }
+    };
+  }
+
+  int64_t frame = 0;
+  double drawn = 0.0;
+  gl::FboRef canvas;
+  vector<gl::TextureRef> thumbs;
+  vector<sprite_ref> sprites;
+  sprite_ref marker;
+};
+REGISTER_SCENARIO("idle_kiosk", idle_kiosk);
@@ -0,0 +1,124 @@
+#include <map>
+
+#include "cinder/app/App.h"
+#include "cinder/gl/gl.h"
+#include "cinder/ImageIo.h"
+#include "cinder/Rand.h"
+
+#include "Scenario.h"
+#include "offline.h"
+#include "provider.h"
+#include "sprite.h"
+#include "tiled.h"
+
+using namespace ci;
+using namespace ci::app;
+using namespace std;
+
+namespace {
+  // keeps a hash of each frame instead of the frame
+  class hash_sink : public frame_sink {
+  public:
+    void write(const Surface8u & frame, int index) override {
+      uint64_t hash = 14695981039346656037ull;
+      size_t row_bytes = frame.getWidth() * frame.getPixelInc();
+      for(int y = 0; y < frame.getHeight(); y++) {
+        const uint8_t * row = frame.getData(ivec2(0, y));
+        for(size_t i = 0; i < row_bytes; i++) {
+          hash = (hash ^ row[i]) * 1099511628211ull;
+        }
+      }
+      if(hashes.size() <= (size_t)index) hashes.resize(index + 1);
+      hashes[index] = hash;
+    }
+
+    vector<uint64_t> hashes;
+  };
+}
+
+/////////////////////////////////////////////////
+//  the same tweening scene, with a tiled image
+//  that decodes on worker threads, rendered
+//  offline twice, the frames of both renders
+//  must match (run with --count 200)
+/////////////////////////////////////////////////
+class offline_render : public scenario {
+public:
+  void setup(int n) override {
+    count = std::min(n, 500);
+    for(int i = 0; i < 16; i++) {
+      textures.push_back(make_test_texture(ivec2(128), 1200 + i));
+    }
+
+    fs::path image = fs::temp_directory_path() / "sprite_benchmark_offline.png";
+    pyramid = fs::temp_directory_path() / "sprite_benchmark_offline";
+    writeImage(image, make_test_surface(ivec2(4096, 2048), 1300));
+    tiled_image_provider::generate(image, pyramid, 256, "png");
+    fs::remove(image);
+
+    vector<uint64_t> first = render();
+    vector<uint64_t> second = render();
+    frames = (double)first.size();
+    deterministic = !first.empty() && first == second ? 1.0 : 0.0;
+    fs::remove_all(pyramid);
+  }
+
+  void draw() override {
+    for(auto & sp : sprites) sp->draw();
+  }
+
+  map<string, double> get_metrics() override {
+    return {
+      { "frames", frames },
+      { "render_fps", render_fps },
+      { "deterministic", deterministic }
+    };
+  }
+
+  /**
+   * Build the scene on a new renderer's timeline and render it,
+   * returning the hash of each frame
+   */
+  vector<uint64_t> render() {
+    auto sink = make_shared<hash_sink>();
+    auto renderer = offline_renderer::create(benchmark_size / 2, 30.0, sink);
+    sprites.clear();
+
+    auto tiled = tiled_image_provider::create(pyramid, ivec2(1024, 512));
+    renderer->wait_for(tiled);
+    auto panorama = sprite::create(tiled);
+    panorama->set_timeline(renderer->get_timeline());
+    panorama->zoom_to(0.75f, 2.0f);
+    sprites.push_back(panorama);
+
+    Rand rand(42);
+    vec2 size(benchmark_size / 2);
+    for(int i = 0; i < count; i++) {
+      auto sp = sprite::create(image_provider::create(textures[i % textures.size()]));
+      sp->set_timeline(renderer->get_timeline());
+      sp->set_coordinates(vec2(rand.nextFloat(size.x), rand.nextFloat(size.y)));
+      sp->set_origin(sprite::origin_point::Center);
+      sp->set_scale(0.5f);
+      sp->set_alpha(0.0f);
+      sp->alpha_to(1.0f, 0.5f, (i % 30) * 0.02f);
+      sp->move_to(vec2(rand.nextFloat(size.x), rand.nextFloat(size.y)), 1.5f, 0.25f);
+      sprites.push_back(sp);
+    }
+
+    renderer->set_draw_fn([this] {
+      for(auto & sp : sprites) sp->draw();
+    });
+    renderer->render_seconds(2.0);
+    renderer->finish();
+    render_fps = renderer->get_render_fps();
+    return sink->hashes;
+  }
+
+  fs::path pyramid;
+  double frames = 0.0;
+  double render_fps = 0.0;
+  double deterministic = 0.0;
+  vector<gl::TextureRef> textures;
+  vector<sprite_ref> sprites;
+};
+REGISTER_SCENARIO("offline_render", offline_render);
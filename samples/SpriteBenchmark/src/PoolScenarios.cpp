@@ -0,0 +1,96 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "cinder/app/App.h"
+#include "cinder/gl/gl.h"
+
+#include "Scenario.h"
+#include "provider.h"
+#include "sprite.h"
+
+using namespace ci;
+using namespace ci::app;
+using namespace std;
+
+// every heap allocation the benchmark makes, so scenarios can count their own
+namespace {
+  std::atomic<uint64_t> heap_allocations(0);
+}
+
+void * operator new(size_t bytes) {
+  heap_allocations++;
+  void * p = std::malloc(bytes ? bytes : 1);
+  if(!p) throw std::bad_alloc();
+  return p;
+}
+
+void operator delete(void * p) noexcept {
+  std::free(p);
+}
+
+void operator delete(void * p, size_t) noexcept {
+  std::free(p);
+}
+
+/////////////////////////////////////////////////
+//  a gallery turning a page of N sprites every
+//  frame, reports heap allocations made turning
+//  pages once the pools have warmed up, which
+//  should be none
+/////////////////////////////////////////////////
+class paging : public scenario {
+public:
+  void setup(int n) override {
+    count = n;
+    for(int i = 0; i < 32; i++) {
+      textures.push_back(make_test_texture(ivec2(256), 1300 + i));
+    }
+    page.reserve(n);
+  }
+
+  void update(double t) override {
+    uint64_t before = heap_allocations;
+    page.clear();
+    for(int i = 0; i < count; i++) {
+      auto sp = sprite::create(image_provider::create(textures[(frame * count + i) % textures.size()]));
+      sp->set_coordinates(vec2((i % 40) * 48, (i / 40 % 22) * 48));
+      sp->set_scale(0.1875f);
+      page.push_back(sp);
+    }
+
+    // the first pages fill the pools and the fbo pool
+    if(frame >= warmup) turn_allocations += heap_allocations - before;
+    frame++;
+  }
+
+  void draw() override {
+    uint64_t before = heap_allocations;
+    for(auto & sp : page) sp->draw();
+    if(frame > warmup) draw_allocations += heap_allocations - before;
+  }
+
+  map<string, double> get_metrics() override {
+    double pages = (double)std::max<int64_t>(frame - warmup, 1);
+    auto sprites = sprite::get_pool_stats();
+    auto providers = image_provider::get_pool_stats();
+    return {
+      { "heap_allocations_per_page", turn_allocations / pages },
+      { "draw_heap_allocations_per_frame", draw_allocations / pages },
+      { "sprite_slabs", (double)sprites.slabs },
+      { "sprite_block_bytes", (double)sprites.block_size },
+      { "sprites_recycled", (double)sprites.recycled },
+      { "provider_slabs", (double)providers.slabs },
+      { "provider_heap_fallbacks", (double)providers.heap_fallbacks }
+    };
+  }
+
+  const int64_t warmup = 4;
+  int64_t frame = 0;
+  double turn_allocations = 0.0;
+  double draw_allocations = 0.0;
+  vector<gl::TextureRef> textures;
+  vector<sprite_ref> page;
+};
+REGISTER_SCENARIO("paging", paging);
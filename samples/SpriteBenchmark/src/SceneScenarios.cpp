@@ -0,0 +1,108 @@
+#include <map>
+#include <sstream>
+
+#include "cinder/app/App.h"
+#include "cinder/gl/gl.h"
+#include "cinder/Rand.h"
+#include "cinder/Timer.h"
+
+#include "Scenario.h"
+#include "provider.h"
+#include "scene.h"
+#include "sprite.h"
+
+using namespace ci;
+using namespace ci::app;
+using namespace std;
+
+/////////////////////////////////////////////////
+//  building a scene of N sprites from its text
+//  and binary forms, against building the same
+//  sprites in code (run with --count 10000)
+/////////////////////////////////////////////////
+class scene_load : public scenario {
+public:
+  void setup(int n) override {
+    count = n;
+    for(int i = 0; i < 16; i++) {
+      textures["thumb_" + to_string(i)] = make_test_texture(ivec2(128), 1100 + i);
+    }
+
+    Rand rand(42);
+    ostringstream text;
+    vector<vec2> positions;
+    for(int i = 0; i < n; i++) {
+      vec2 p(rand.nextFloat(benchmark_size.x), rand.nextFloat(benchmark_size.y));
+      positions.push_back(p);
+      text << "sprite image thumb_" << i % 16 << "\n"
+           << "  at " << p.x << " " << p.y << "\n"
+           << "  origin center\n"
+           << "  scale 0.25\n"
+           << "  alpha 0\n"
+           << "  alpha_to 1 0.5 delay " << (i % 100) * 0.01f << " ease out_quad\n";
+    }
+    string source = text.str();
+    text_bytes = (double)source.size();
+
+    auto provider = [this](provider_type type, const string & name) -> texture_provider_ref {
+      return image_provider::create(textures[name]);
+    };
+
+    // the same sprites in code, as layouts are built today
+    Timer timer(true);
+    for(int i = 0; i < n; i++) {
+      auto sp = sprite::create(image_provider::create(textures["thumb_" + to_string(i % 16)]));
+      sp->set_coordinates(positions[i]);
+      sp->set_origin(sprite::origin_point::Center);
+      sp->set_scale(0.25f);
+      sp->set_alpha(0.0f);
+      sp->alpha_to(1.0f, 0.5f, (i % 100) * 0.01f, easeOutQuad);
+      imperative.push_back(sp);
+    }
+    imperative_ms = timer.getSeconds() * 1000.0;
+    imperative.clear();
+
+    timer.start();
+    auto parsed = scene::parse(source);
+    parse_ms = timer.getSeconds() * 1000.0;
+
+    fs::path path = fs::temp_directory_path() / "sprite_benchmark_scene.bin";
+    parsed->save(path);
+    binary_bytes = (double)fs::file_size(path);
+
+    timer.start();
+    auto loaded = scene::load(path);
+    load_ms = timer.getSeconds() * 1000.0;
+
+    timer.start();
+    sprites = loaded->instantiate(provider);
+    instantiate_ms = timer.getSeconds() * 1000.0;
+    fs::remove(path);
+  }
+
+  void draw() override {
+    for(auto & sp : sprites) sp->draw();
+  }
+
+  map<string, double> get_metrics() override {
+    return {
+      { "imperative_ms", imperative_ms },
+      { "parse_text_ms", parse_ms },
+      { "load_binary_ms", load_ms },
+      { "instantiate_ms", instantiate_ms },
+      { "text_bytes", text_bytes },
+      { "binary_bytes", binary_bytes }
+    };
+  }
+
+  double imperative_ms = 0.0;
+  double parse_ms = 0.0;
+  double load_ms = 0.0;
+  double instantiate_ms = 0.0;
+  double text_bytes = 0.0;
+  double binary_bytes = 0.0;
+  map<string, gl::TextureRef> textures;
+  vector<sprite_ref> imperative;
+  vector<sprite_ref> sprites;
+};
+REGISTER_SCENARIO("scene_load", scene_load);
@@ -0,0 +1,203 @@
+#include "cinder/app/App.h"
+#include "cinder/app/RendererGl.h"
+#include "cinder/gl/gl.h"
+#include "cinder/Log.h"
+#include "cinder/Timer.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include "Scenario.h"
+#include "memory.h"
+#include "profiler.h"
+#include "shader.h"
+#include "sprite.h"
+
+using namespace ci;
+using namespace ci::app;
+using namespace std;
+
+// Usage:
+//   SpriteBenchmark [--count N] [--frames N] [--warmup N] [--scenario name] [--out results.json]
+//
+// Every scenario renders into a 1920x1080 fbo, so the window can be hidden and
+// the benchmark runs offscreen, ie. under Mesa with LIBGL_ALWAYS_SOFTWARE=1
+// (llvmpipe) or with Cinder built for headless EGL. Results are written as
+// JSON, one object per scenario, to --out or stdout.
+
+std::vector<std::pair<std::string, scenario_factory>> & get_scenarios() {
+  static std::vector<std::pair<std::string, scenario_factory>> scenarios;
+  return scenarios;
+}
+
+class SpriteBenchmarkApp : public App {
+public:
+  void setup() override;
+  void update() override;
+  void draw() override;
+  void start_next();
+  void finish_current();
+  void write_results();
+
+  int count;
+  int frames;
+  int warmup;
+  string filter;
+  string out_path;
+
+  gl::FboRef target;
+  size_t next_scenario;
+  scenario_ref current;
+  string current_name;
+  int frame;
+  double start_time;
+  uint64_t draw_calls_start;
+  uint64_t gpu_bytes_start;
+  vector<double> frame_ms;
+  vector<string> results;
+};
+
+namespace {
+  double percentile(vector<double> values, double p) {
+    if(values.empty()) return 0.0;
+    std::sort(values.begin(), values.end());
+    size_t index = std::min(values.size() - 1, (size_t)(p * (values.size() - 1) + 0.5));
+    return values[index];
+  }
+}
+
+void SpriteBenchmarkApp::setup() {
+  count = 1000;
+  frames = 600;
+  warmup = 60;
+  out_path = "";
+
+  auto args = getCommandLineArgs();
+  for(size_t i = 1; i + 1 < args.size(); i += 2) {
+    if(args[i] == "--count") count = stoi(args[i + 1]);
+    else if(args[i] == "--frames") frames = stoi(args[i + 1]);
+    else if(args[i] == "--warmup") warmup = std::max(stoi(args[i + 1]), 0);
+    else if(args[i] == "--scenario") filter = args[i + 1];
+    else if(args[i] == "--out") out_path = args[i + 1];
+  }
+
+  gl::enableVerticalSync(false);
+  disableFrameRate();
+
+  target = gl::Fbo::create(benchmark_size.x, benchmark_size.y, gl::Fbo::Format().disableDepth());
+  sprite::init();
+
+  next_scenario = 0;
+  start_next();
+}
+
+void SpriteBenchmarkApp::start_next() {
+  current.reset();
+  auto & scenarios = get_scenarios();
+  while(next_scenario < scenarios.size()) {
+    auto & entry = scenarios[next_scenario++];
+    if(!filter.empty() && entry.first != filter) continue;
+
+    current_name = entry.first;
+    gpu_bytes_start = gpu_memory::get_bytes();
+    current = entry.second();
+    current->setup(count);
+    frame = 0;
+    frame_ms.clear();
+    draw_calls_start = sprite_shader::get_draw_calls();
+    start_time = getElapsedSeconds();
+    CI_LOG_I("Running " << current_name);
+    return;
+  }
+
+  write_results();
+  quit();
+}
+
+void SpriteBenchmarkApp::finish_current() {
+  std::stringstream json;
+  json << "    {\n"
+       << "      \"name\": \"" << current_name << "\",\n"
+       << "      \"count\": " << current->count << ",\n"
+       << "      \"frames\": " << frame_ms.size() << ",\n";
+#if ! defined( CINDER_SPRITE_PROFILING )
+  // a profiled build times its own instrumentation, so only counts are written
+  double total_ms = 0.0;
+  for(auto ms : frame_ms) total_ms += ms;
+  json << "      \"fps\": " << (total_ms > 0.0 ? frame_ms.size() * 1000.0 / total_ms : 0.0) << ",\n"
+       << "      \"frame_ms_p50\": " << percentile(frame_ms, 0.5) << ",\n"
+       << "      \"frame_ms_p99\": " << percentile(frame_ms, 0.99) << ",\n";
+#endif
+  json << "      \"draw_calls_per_frame\": " << (double)(sprite_shader::get_draw_calls() - draw_calls_start) / std::max<size_t>(frame_ms.size(), 1) << ",\n"
+       << "      \"gpu_bytes_allocated\": " << (int64_t)gpu_memory::get_bytes() - (int64_t)gpu_bytes_start;
+  for(auto & metric : current->get_metrics()) {
+    json << ",\n      \"" << metric.first << "\": " << metric.second;
+  }
+  json << "\n    }";
+  results.push_back(json.str());
+}
+
+void SpriteBenchmarkApp::write_results() {
+  std::stringstream json;
+  json << "{\n"
+       << "  \"renderer\": \"" << (const char *)glGetString(GL_RENDERER) << "\",\n"
+       << "  \"profiling\": "
+#if defined( CINDER_SPRITE_PROFILING )
+       << "true"
+#else
+       << "false"
+#endif
+       << ",\n  \"scenarios\": [\n";
+  for(size_t i = 0; i < results.size(); i++) {
+    json << results[i] << (i + 1 < results.size() ? ",\n" : "\n");
+  }
+  json << "  ]\n}\n";
+
+  if(out_path.empty()) {
+    std::cout << json.str();
+  } else {
+    std::ofstream(out_path) << json.str();
+  }
+}
+
+void SpriteBenchmarkApp::update() {
+  if(!current) return;
+
+  // the timed frame: scenario update and draw, plus waiting for the gpu
+  Timer timer(true);
+  current->update(getElapsedSeconds() - start_time);
+  {
+    gl::ScopedFramebuffer scoped_fbo(target);
+    gl::ScopedViewport scoped_viewport(ivec2(0), target->getSize());
+    gl::ScopedMatrices scoped_matrices;
+    gl::setMatricesWindow(target->getSize());
+    gl::clear(Color::black());
+    current->draw();
+  }
+  glFinish();
+  double ms = timer.getSeconds() * 1000.0;
+
+#if defined( CINDER_SPRITE_PROFILING )
+  sprite_profiler::frame();
+#endif
+
+  frame++;
+  if(frame == warmup) draw_calls_start = sprite_shader::get_draw_calls();
+  if(frame > warmup) frame_ms.push_back(ms);
+  if(frame >= warmup + frames) {
+    finish_current();
+    start_next();
+  }
+}
+
+void SpriteBenchmarkApp::draw() {
+  gl::clear(Color::black());
+  if(target) gl::draw(target->getColorTexture(), Rectf(getWindowBounds()));
+}
+
+CINDER_APP(SpriteBenchmarkApp, RendererGl, [](App::Settings * settings) {
+  settings->setWindowSize(480, 270);
+  settings->setTitle("SpriteBenchmark");
+})
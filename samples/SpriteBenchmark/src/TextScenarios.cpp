@@ -0,0 +1,132 @@
+#include <string>
+
+#include "cinder/app/App.h"
+#include "cinder/gl/gl.h"
+#include "cinder/Rand.h"
+
+#include "Scenario.h"
+#include "provider.h"
+#include "sprite.h"
+#include "text.h"
+
+using namespace ci;
+using namespace ci::app;
+using namespace std;
+
+namespace {
+  // a changing share of the labels, 5% per frame
+  const float changed_share = 0.05f;
+
+  string label_text(int index, int frame) {
+    return "Gallery " + to_string(index % 40) + " / object " + to_string(index * 7919 % 10000 + frame);
+  }
+}
+
+/////////////////////////////////////////////////
+//  labels drawn the old way, a graphics_provider
+//  per label calling gl::drawString into its fbo
+//  (run with --count 2000 to match text_labels)
+/////////////////////////////////////////////////
+class string_label : public graphics_provider {
+public:
+  string_label(const string & label) : graphics_provider(vec2(240, 32)) {
+    text = label;
+  }
+
+  void draw() override {
+    gl::drawString(text, vec2(4, 8), Color::white(), font);
+  }
+
+  static Font font;
+  string text;
+};
+Font string_label::font;
+
+class fbo_labels : public scenario {
+public:
+  void setup(int n) override {
+    count = n;
+    string_label::font = Font("Arial", 24.0f);
+    Rand rand(39);
+    for(int i = 0; i < n; i++) {
+      auto label = make_shared<string_label>(label_text(i, 0));
+      auto sp = sprite::create(label);
+      sp->set_coordinates(vec2(rand.nextFloat(benchmark_size.x - 240), rand.nextFloat(benchmark_size.y - 32)));
+      labels.push_back(label);
+      sprites.push_back(sp);
+    }
+  }
+
+  void update(double t) override {
+    frame++;
+    int changed = (int)(labels.size() * changed_share);
+    for(int i = 0; i < changed; i++) {
+      size_t index = (frame * changed + i) % labels.size();
+      labels[index]->text = label_text((int)index, frame);
+      labels[index]->update();
+    }
+  }
+
+  void draw() override {
+    for(auto & sp : sprites) sp->draw();
+  }
+
+  map<string, double> get_metrics() override {
+    return { { "changed_per_frame", (double)(int)(labels.size() * changed_share) } };
+  }
+
+  int frame = 0;
+  vector<shared_ptr<string_label>> labels;
+  vector<sprite_ref> sprites;
+};
+REGISTER_SCENARIO("fbo_labels", fbo_labels);
+
+/////////////////////////////////////////////////
+//  the same labels as text_providers sharing one
+//  glyph atlas, drawn by a text_batch
+/////////////////////////////////////////////////
+class text_labels : public scenario {
+public:
+  void setup(int n) override {
+    count = n;
+    auto font = text_provider::get_font("Arial", 24.0f);
+    batch = text_batch::create(font);
+    Rand rand(39);
+    for(int i = 0; i < n; i++) {
+      auto label = text_provider::create(label_text(i, 0), font);
+      auto sp = sprite::create(label);
+      sp->set_coordinates(vec2(rand.nextFloat(benchmark_size.x - 240), rand.nextFloat(benchmark_size.y - 32)));
+      labels.push_back(label);
+      batch->add(sp);
+      sprites.push_back(sp);
+    }
+  }
+
+  void update(double t) override {
+    frame++;
+    int changed = (int)(labels.size() * changed_share);
+    for(int i = 0; i < changed; i++) {
+      size_t index = (frame * changed + i) % labels.size();
+      labels[index]->set_text(label_text((int)index, frame));
+    }
+  }
+
+  void draw() override {
+    batch->draw();
+  }
+
+  map<string, double> get_metrics() override {
+    return {
+      { "changed_per_frame", (double)(int)(labels.size() * changed_share) },
+      { "glyphs", (double)batch->get_glyph_count() },
+      { "glyphs_rewritten", (double)batch->get_rewritten() },
+      { "batch_draw_calls", (double)batch->get_draw_calls() }
+    };
+  }
+
+  int frame = 0;
+  text_batch_ref batch;
+  vector<text_provider_ref> labels;
+  vector<sprite_ref> sprites;
+};
+REGISTER_SCENARIO("text_labels", text_labels);
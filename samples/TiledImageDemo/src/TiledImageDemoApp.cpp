@@ -0,0 +1,136 @@
+#include "cinder/app/App.h"
+#include "cinder/app/RendererGl.h"
+#include "cinder/gl/gl.h"
+#include "cinder/Log.h"
+
+#include <fstream>
+
+#include "sprite.h"
+#include "tiled.h"
+
+using namespace ci;
+using namespace ci::app;
+using namespace std;
+
+// Usage:
+//   TiledImageDemo --generate <image> <pyramid dir> [tile size]
+//   TiledImageDemo <pyramid dir> [--benchmark]
+//
+// Drop a pyramid directory on the window to view it, scroll to zoom.
+// With --benchmark the sprite zooms in and out of the image while
+// tile cache and process memory are logged once a second.
+
+class TiledImageDemoApp : public App {
+public:
+  void setup() override;
+  void update() override;
+  void draw() override;
+  void fileDrop(FileDropEvent e) override;
+  void mouseWheel(MouseEvent e) override;
+  void mouseMove(MouseEvent e) override;
+  void load(fs::path pyramid);
+  void benchmark_step();
+  size_t get_resident_bytes();
+
+  sprite_ref sp;
+  tiled_image_provider_ref tiles;
+  float zoom;
+  bool benchmarking;
+  double last_report;
+  size_t peak_cache_bytes;
+  size_t peak_resident_bytes;
+};
+
+void TiledImageDemoApp::setup() {
+  zoom = 0.0f;
+  benchmarking = false;
+  last_report = 0.0;
+  peak_cache_bytes = 0;
+  peak_resident_bytes = 0;
+
+  auto args = getCommandLineArgs();
+  if(args.size() >= 4 && args[1] == "--generate") {
+    int tile_size = args.size() >= 5 ? stoi(args[4]) : 512;
+    tiled_image_provider::generate(args[2], args[3], tile_size);
+    quit();
+    return;
+  }
+
+  if(args.size() >= 2) load(args[1]);
+  benchmarking = tiles && args.size() >= 3 && args[2] == "--benchmark";
+}
+
+void TiledImageDemoApp::load(fs::path pyramid) {
+  tiles = tiled_image_provider::create(pyramid, getWindowSize());
+  sp = sprite::create(tiles);
+}
+
+void TiledImageDemoApp::fileDrop(FileDropEvent e) {
+  if(e.getNumFiles() > 0) load(e.getFile(0));
+}
+
+void TiledImageDemoApp::mouseWheel(MouseEvent e) {
+  if(!sp) return;
+  zoom = glm::clamp(zoom + e.getWheelIncrement() * 0.02f, 0.0f, 0.999f);
+  sp->set_zoom(zoom);
+}
+
+void TiledImageDemoApp::mouseMove(MouseEvent e) {
+  if(sp && !benchmarking) sp->set_zoom_center(e.getPos());
+}
+
+/**
+ * Zoom in and out of a slowly orbiting point, reporting memory once a second
+ */
+void TiledImageDemoApp::benchmark_step() {
+  double t = getElapsedSeconds();
+  vec2 center = vec2(getWindowSize()) * (0.5f + 0.3f * vec2(cos(t * 0.2), sin(t * 0.3)));
+  sp->set_zoom_center(center);
+  sp->set_zoom(0.5f - 0.5f * (float)cos(t * 0.5));
+
+  peak_cache_bytes = std::max(peak_cache_bytes, tiles->get_cache_bytes());
+  peak_resident_bytes = std::max(peak_resident_bytes, get_resident_bytes());
+
+  if(t - last_report >= 1.0) {
+    last_report = t;
+    CI_LOG_I("t=" << (int)t << "s"
+      << " fps=" << getAverageFps()
+      << " tiles=" << tiles->get_resident_tiles()
+      << " cache=" << tiles->get_cache_bytes() / (1024 * 1024) << "MB"
+      << " peak_cache=" << peak_cache_bytes / (1024 * 1024) << "MB"
+      << " rss=" << get_resident_bytes() / (1024 * 1024) << "MB"
+      << " peak_rss=" << peak_resident_bytes / (1024 * 1024) << "MB");
+  }
+
+  if(t > 60.0) quit();
+}
+
+size_t TiledImageDemoApp::get_resident_bytes() {
+#if defined( CINDER_LINUX )
+  std::ifstream statm("/proc/self/statm");
+  size_t pages = 0, resident = 0;
+  statm >> pages >> resident;
+  return resident * 4096;
+#else
+  return 0;
+#endif
+}
+
+void TiledImageDemoApp::update() {
+  if(!tiles) return;
+  if(benchmarking) benchmark_step();
+  tiles->update();
+}
+
+void TiledImageDemoApp::draw() {
+  gl::clear(Color(0, 0, 0));
+  if(sp && tiles->is_ready()) {
+    sp->draw();
+  } else {
+    gl::drawString("Drop a tile pyramid directory here", vec2(30, 30));
+  }
+}
+
+CINDER_APP(TiledImageDemoApp, RendererGl, [](App::Settings * settings) {
+  settings->setWindowSize(1280, 720);
+})
@@ -2,6 +2,7 @@
 #include "cinder/app/RendererGl.h"
 #include "cinder/gl/gl.h"
 #include "cinder/Log.h"
+#include "scheduler.h"
 #include "sprite.h"
 
 using namespace ci;
@@ -21,10 +22,11 @@ class VideoSpriteDemoApp : public App {
 void VideoSpriteDemoApp::setup() {
   video = video_provider::create();
   sprite = sprite::create(video);
+  provider_scheduler::add(video, 0);
 }
 
 void VideoSpriteDemoApp::update() {
-  sprite->get_provider()->update();
+  provider_scheduler::update();
 }
 
 void VideoSpriteDemoApp::fileDrop(FileDropEvent e) {
@@ -34,6 +36,8 @@ void VideoSpriteDemoApp::fileDrop(FileDropEvent e) {
       sprite->get_provider()->set_source(p.string());
       if(video->get_movie()) {
         video->get_movie()->setLoop(true);
+        // poll for frames at the movie's own rate rather than the display's
+        provider_scheduler::add(video, video->get_movie()->getFramerate());
       }
     }
   } catch(exception e) {
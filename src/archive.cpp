@@ -0,0 +1,272 @@
+// std
+#include <cstring>
+#include <fstream>
+
+// platform
+#if defined( CINDER_MSW )
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// cinder
+#include "cinder/Exception.h"
+#include "cinder/ImageIo.h"
+#include "cinder/Log.h"
+#include "cinder/Surface.h"
+
+// sfmoma
+#include "archive.h"
+#include "color.h"
+
+using namespace ci;
+
+namespace {
+  const char archive_magic[4] = { 'C', 'S', 'P', 'A' };
+  const uint32_t archive_version = 1;
+  const uint64_t page_alignment = 4096;
+  const uint32_t max_dimension = 65536;
+
+#pragma pack(push, 1)
+  struct file_header {
+    char magic[4];
+    uint32_t version;
+    uint32_t entry_count;
+    uint32_t names_size;
+  };
+
+  struct file_entry {
+    uint32_t name_offset;
+    uint32_t name_length;
+    uint64_t data_offset;
+    uint64_t data_size;
+    uint32_t width;
+    uint32_t height;
+    uint32_t format;
+    uint32_t reserved;
+  };
+#pragma pack(pop)
+
+  std::vector<asset_archive_ref> mounted;
+
+  // whether [offset, offset + size) lies within [0, limit), without overflowing
+  bool in_range(uint64_t offset, uint64_t size, uint64_t limit) {
+    return offset <= limit && size <= limit - offset;
+  }
+
+  uint64_t align(uint64_t offset) {
+    return (offset + page_alignment - 1) / page_alignment * page_alignment;
+  }
+}
+
+////////////////////////////////////////////////////
+//  static
+////////////////////////////////////////////////////
+asset_archive_ref asset_archive::open(const fs::path & path) {
+  return std::make_shared<asset_archive>(path);
+}
+
+void asset_archive::build(const fs::path & root, const std::vector<std::string> & names, const fs::path & output) {
+  std::vector<file_entry> index(names.size());
+  std::string name_table;
+  for(size_t i = 0; i < names.size(); i++) {
+    index[i].name_offset = (uint32_t)name_table.size();
+    index[i].name_length = (uint32_t)names[i].size();
+    name_table += names[i];
+  }
+
+  std::ofstream out(output.string(), std::ios::binary | std::ios::trunc);
+  if(!out) throw Exception("Can not write asset archive " + output.string());
+
+  // payloads go first, the index is written once their offsets are known
+  uint64_t offset = align(sizeof(file_header) + sizeof(file_entry) * index.size() + name_table.size());
+  for(size_t i = 0; i < names.size(); i++) {
+    Surface8u loaded(loadImage(loadFile(root / names[i])));
+    bool alpha = loaded.hasAlpha();
+
+    // normalize the channel order so the payload uploads as is
+    Surface8u surface(loaded.getWidth(), loaded.getHeight(), alpha,
+      alpha ? SurfaceChannelOrder::RGBA : SurfaceChannelOrder::RGB);
+    surface.copyFrom(loaded, loaded.getBounds());
+
+    size_t packed_row_bytes = surface.getWidth() * (alpha ? 4 : 3);
+    index[i].data_offset = offset;
+    index[i].data_size = packed_row_bytes * surface.getHeight();
+    index[i].width = surface.getWidth();
+    index[i].height = surface.getHeight();
+    index[i].format = alpha ? RGBA8 : RGB8;
+    index[i].reserved = 0;
+
+    out.seekp(offset);
+    for(int y = 0; y < surface.getHeight(); y++) {
+      out.write((const char *)surface.getData(ivec2(0, y)), packed_row_bytes);
+    }
+    offset = align(offset + index[i].data_size);
+  }
+
+  file_header header;
+  std::memcpy(header.magic, archive_magic, 4);
+  header.version = archive_version;
+  header.entry_count = (uint32_t)index.size();
+  header.names_size = (uint32_t)name_table.size();
+
+  out.seekp(0);
+  out.write((const char *)&header, sizeof(header));
+  out.write((const char *)index.data(), sizeof(file_entry) * index.size());
+  out.write(name_table.data(), name_table.size());
+
+  // pad the file out to the end of the last payload
+  out.seekp(offset - 1);
+  out.put(0);
+
+  CI_LOG_I("Packed " << names.size() << " assets into " << output << " (" << offset / (1024 * 1024) << "MB)");
+}
+
+void asset_archive::mount(const asset_archive_ref & archive) {
+  if(archive) mounted.push_back(archive);
+}
+
+void asset_archive::unmount_all() {
+  mounted.clear();
+}
+
+bool asset_archive::find_mounted(const std::string & name, entry & result) {
+  // later mounts override earlier ones
+  for(auto it = mounted.rbegin(); it != mounted.rend(); ++it) {
+    if((*it)->find(name, result)) return true;
+  }
+  return false;
+}
+
+gl::TextureRef asset_archive::create_texture(const entry & e) {
+  GLenum data_format = e.format == RGBA8 ? GL_RGBA : GL_RGB;
+  gl::Texture::Format format = color_policy::get_texture_format();
+  if(e.format == RGB8) format.setInternalFormat(color_policy::is_linear_blending() ? GL_SRGB8 : GL_RGB8);
+
+  // rows are tightly packed
+  GLint unpack_alignment;
+  glGetIntegerv(GL_UNPACK_ALIGNMENT, &unpack_alignment);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  gl::TextureRef texture = gl::Texture::create(e.data, data_format, e.width, e.height, format);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, unpack_alignment);
+
+  // payloads are written top row first, as surfaces are
+  texture->setTopDown(true);
+  return texture;
+}
+
+//////////////////////////////////////////////////////
+// ctr(s) / dctr(s)
+//////////////////////////////////////////////////////
+asset_archive::asset_archive(const fs::path & path) {
+  mapping = nullptr;
+  mapping_size = 0;
+
+#if defined( CINDER_MSW )
+  mapping_handle = nullptr;
+  file_handle = CreateFileW(path.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ,
+    nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if(file_handle == INVALID_HANDLE_VALUE) throw Exception("Can not open asset archive " + path.string());
+  LARGE_INTEGER size;
+  GetFileSizeEx(file_handle, &size);
+  mapping_size = (size_t)size.QuadPart;
+  mapping_handle = CreateFileMapping(file_handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if(mapping_handle) mapping = (const uint8_t *)MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0);
+#else
+  file_descriptor = ::open(path.string().c_str(), O_RDONLY);
+  if(file_descriptor < 0) throw Exception("Can not open asset archive " + path.string());
+  struct stat info;
+  fstat(file_descriptor, &info);
+  mapping_size = (size_t)info.st_size;
+  void * mapped = mmap(nullptr, mapping_size, PROT_READ, MAP_PRIVATE, file_descriptor, 0);
+  if(mapped != MAP_FAILED) mapping = (const uint8_t *)mapped;
+#endif
+
+  if(!mapping) {
+    close();
+    throw Exception("Can not map asset archive " + path.string());
+  }
+
+  const file_header * header = (const file_header *)mapping;
+  if(mapping_size < sizeof(file_header) || std::memcmp(header->magic, archive_magic, 4) != 0) {
+    close();
+    throw Exception(path.string() + " is not an asset archive");
+  }
+  if(header->version != archive_version) {
+    uint32_t found = header->version;
+    close();
+    throw Exception(path.string() + " has unsupported archive version " + std::to_string(found));
+  }
+
+  uint64_t index_size = (uint64_t)header->entry_count * sizeof(file_entry);
+  if(!in_range(sizeof(file_header), index_size, mapping_size)
+    || !in_range(sizeof(file_header) + index_size, header->names_size, mapping_size)) {
+    close();
+    throw Exception(path.string() + " is a truncated or corrupt asset archive");
+  }
+
+  const file_entry * index = (const file_entry *)(mapping + sizeof(file_header));
+  const char * names = (const char *)(index + header->entry_count);
+  entries.reserve(header->entry_count);
+  for(uint32_t i = 0; i < header->entry_count; i++) {
+    const file_entry & f = index[i];
+    if(!in_range(f.name_offset, f.name_length, header->names_size)) {
+      CI_LOG_W("Skipping archive entry " << i << " with a corrupt name");
+      continue;
+    }
+    uint64_t channels = f.format == RGBA8 ? 4 : 3;
+    bool sized = f.width > 0 && f.height > 0 && f.width <= max_dimension && f.height <= max_dimension;
+    if(f.format > RGB8 || !sized || !in_range(f.data_offset, f.data_size, mapping_size)
+      || (uint64_t)f.width * f.height * channels > f.data_size) {
+      CI_LOG_W("Skipping truncated archive entry " << std::string(names + f.name_offset, f.name_length));
+      continue;
+    }
+    entry e;
+    e.data = mapping + f.data_offset;
+    e.size = (size_t)f.data_size;
+    e.width = (int)f.width;
+    e.height = (int)f.height;
+    e.format = (pixel_format)f.format;
+    entries[std::string(names + f.name_offset, f.name_length)] = e;
+  }
+}
+
+asset_archive::~asset_archive() {
+  close();
+}
+
+//////////////////////////////////////////////////////
+// methods
+//////////////////////////////////////////////////////
+void asset_archive::close() {
+#if defined( CINDER_MSW )
+  if(mapping) UnmapViewOfFile(mapping);
+  if(mapping_handle) CloseHandle(mapping_handle);
+  if(file_handle != INVALID_HANDLE_VALUE) CloseHandle(file_handle);
+  mapping_handle = nullptr;
+  file_handle = INVALID_HANDLE_VALUE;
+#else
+  if(mapping) munmap((void *)mapping, mapping_size);
+  if(file_descriptor >= 0) ::close(file_descriptor);
+  file_descriptor = -1;
+#endif
+  mapping = nullptr;
+  entries.clear();
+}
+
+//////////////////////////////////////////////////////
+// getters
+//////////////////////////////////////////////////////
+bool asset_archive::find(const std::string & name, entry & result) {
+  auto it = entries.find(name);
+  if(it == entries.end()) return false;
+  result = it->second;
+  return true;
+}
+
+size_t asset_archive::get_entry_count() {
+  return entries.size();
+}
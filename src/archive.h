@@ -0,0 +1,105 @@
+#pragma once
+
+// std
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// cinder
+#include "cinder/Filesystem.h"
+#include "cinder/gl/Texture.h"
+
+/////////////////////////////////////////////////
+//
+//  asset_archive
+//  A packed, memory-mapped file of pre-decoded
+//  images, uploaded straight from mapped pages
+//
+//  Layout: header, index, name table, then one
+//  page aligned payload per entry
+//
+/////////////////////////////////////////////////
+class asset_archive {
+public:
+  //////////////////////////////////////////////////////
+  // enums
+  //////////////////////////////////////////////////////
+  enum pixel_format : uint32_t {
+    RGBA8 = 0,
+    RGB8 = 1
+  };
+
+  class entry {
+  public:
+    const uint8_t * data;
+    size_t size;
+    int width;
+    int height;
+    pixel_format format;
+  };
+
+  //////////////////////////////////////////////////////
+  // static
+  //////////////////////////////////////////////////////
+  typedef std::shared_ptr<asset_archive> asset_archive_ref;
+
+  // map an archive, throws if it can not be opened or is not an archive
+  static asset_archive_ref open(const ci::fs::path & path);
+
+  // decode images under root and pack them, names are kept relative to root
+  // and should match the paths given to image_provider::set_source
+  static void build(const ci::fs::path & root, const std::vector<std::string> & names, const ci::fs::path & output);
+
+  // mounted archives are searched by image_provider::set_source,
+  // keep an archive mounted for as long as textures may be uploaded from it
+  static void mount(const asset_archive_ref & archive);
+
+  static void unmount_all();
+
+  static bool find_mounted(const std::string & name, entry & result);
+
+  //////////////////////////////////////////////////////
+  // ctr(s) / dctr(s)
+  //////////////////////////////////////////////////////
+  asset_archive(const ci::fs::path & path);
+
+  ~asset_archive();
+
+  //////////////////////////////////////////////////////
+  // getters
+  //////////////////////////////////////////////////////
+  bool find(const std::string & name, entry & result);
+
+  size_t get_entry_count();
+
+  //////////////////////////////////////////////////////
+  // methods
+  //////////////////////////////////////////////////////
+  // upload an entry, reading directly from the mapping
+  static ci::gl::TextureRef create_texture(const entry & e);
+
+protected:
+  //////////////////////////////////////////////////////
+  // properties
+  //////////////////////////////////////////////////////
+  const uint8_t * mapping;
+  size_t mapping_size;
+#if defined( CINDER_MSW )
+  void * file_handle;
+  void * mapping_handle;
+#else
+  int file_descriptor;
+#endif
+  std::unordered_map<std::string, entry> entries;
+
+  //////////////////////////////////////////////////////
+  // methods
+  //////////////////////////////////////////////////////
+  void close();
+};
+
+//////////////////////////////////////////////////////
+// typedefs
+//////////////////////////////////////////////////////
+typedef asset_archive::asset_archive_ref asset_archive_ref;
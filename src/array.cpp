@@ -0,0 +1,146 @@
+// std
+#include <algorithm>
+
+// cinder
+#include "cinder/app/App.h"
+#include "cinder/ImageIo.h"
+#include "cinder/Log.h"
+#include "cinder/ip/Resize.h"
+
+// sfmoma
+#include "array.h"
+#include "memory.h"
+
+using namespace ci;
+using namespace ci::app;
+
+/////////////////////////////////////////////////
+//
+//  texture_array_pool
+//
+/////////////////////////////////////////////////
+texture_array_pool_ref texture_array_pool::create(ivec2 size, int layers, GLint internal_format) {
+  return std::make_shared<texture_array_pool>(size, layers, internal_format);
+}
+
+texture_array_pool::texture_array_pool(ivec2 layer_size, int layers, GLint internal_format) {
+  size = glm::max(layer_size, ivec2(1));
+
+  GLint max_layers = 256;
+  glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &max_layers);
+  layer_count = glm::clamp(layers, 1, (int)max_layers);
+  if(layer_count < layers) {
+    CI_LOG_W("Texture array limited to " << layer_count << " layers");
+  }
+
+  size_t bytes = gpu_memory::get_texture_bytes(size, internal_format, false, 0, layer_count);
+  gpu_memory::reserve(bytes);
+  texture = gl::Texture3d::create(size.x, size.y, layer_count, gl::Texture3d::Format()
+    .target(GL_TEXTURE_2D_ARRAY).internalFormat(internal_format)
+    .minFilter(GL_LINEAR).magFilter(GL_LINEAR).wrap(GL_CLAMP_TO_EDGE));
+  gpu_memory::track(texture, "texture", "texture_array_pool", bytes);
+
+  // lowest layers are handed out first
+  for(int layer = layer_count - 1; layer >= 0; layer--) {
+    free_layers.push_back(layer);
+  }
+}
+
+gl::Texture3dRef texture_array_pool::get_texture() {
+  return texture;
+}
+
+ivec2 texture_array_pool::get_size() {
+  return size;
+}
+
+int texture_array_pool::get_layer_count() {
+  return layer_count;
+}
+
+int texture_array_pool::get_free_layers() {
+  return (int)free_layers.size();
+}
+
+int texture_array_pool::acquire() {
+  if(free_layers.empty()) return -1;
+  int layer = free_layers.back();
+  free_layers.pop_back();
+  return layer;
+}
+
+void texture_array_pool::release(int layer) {
+  if(layer >= 0 && layer < layer_count) free_layers.push_back(layer);
+}
+
+void texture_array_pool::upload(int layer, const Surface8u & surface) {
+  if(layer < 0 || layer >= layer_count) return;
+  if(surface.getSize() == size) {
+    texture->update(surface, layer);
+  } else {
+    texture->update(ip::resize(surface, size, FilterTriangle()), layer);
+  }
+}
+
+/////////////////////////////////////////////////
+//
+//  array_provider
+//
+/////////////////////////////////////////////////
+array_provider_ref array_provider::create(texture_array_pool_ref pool, std::string path) {
+  auto provider = std::make_shared<array_provider>(pool);
+  if(!path.empty()) provider->set_source(path);
+  return provider;
+}
+
+array_provider::array_provider(texture_array_pool_ref array_pool) {
+  pool = array_pool;
+  layer = -1;
+  loaded = false;
+  texture_is_new = false;
+}
+
+array_provider::~array_provider() {
+  if(pool) pool->release(layer);
+}
+
+vec2 array_provider::get_size() {
+  return pool->get_size();
+}
+
+bool array_provider::is_ready() {
+  return loaded;
+}
+
+texture_array_pool_ref array_provider::get_pool() {
+  return pool;
+}
+
+int array_provider::get_layer() {
+  return layer;
+}
+
+void array_provider::set_source(std::string path) {
+  source = path;
+  try {
+    set_surface(Surface8u::create(loadImage(loadAsset(path))));
+  } catch(const std::exception & e) {
+    CI_LOG_E("Error loading " << path << ": " << e.what());
+  }
+}
+
+void array_provider::set_surface(const Surface8uRef & surface) {
+  if(layer < 0) layer = pool->acquire();
+  if(layer < 0) {
+    CI_LOG_W("Texture array pool is full, " << source << " is not shown");
+    return;
+  }
+
+  size_t bytes = (size_t)pool->get_size().x * pool->get_size().y * 4;
+  schedule(bytes, [=] {
+    pool->upload(layer, *surface);
+    loaded = true;
+    set_texture_changed(Area(ivec2(0), pool->get_size()));
+    return bytes;
+  });
+}
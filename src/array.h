@@ -0,0 +1,137 @@
+#pragma once
+
+// std
+#include <vector>
+
+// cinder
+#include "cinder/Surface.h"
+#include "cinder/gl/Texture.h"
+
+// sfmoma
+#include "provider.h"
+
+/////////////////////////////////////////////////
+//
+//  texture_array_pool
+//  A GL_TEXTURE_2D_ARRAY of same-sized layers
+//  handed out from a free list, so collections
+//  of same-sized images share one texture
+//
+/////////////////////////////////////////////////
+class texture_array_pool {
+public:
+  //////////////////////////////////////////////////////
+  // static
+  //////////////////////////////////////////////////////
+  typedef std::shared_ptr<texture_array_pool> texture_array_pool_ref;
+
+  static texture_array_pool_ref create(ci::ivec2 size, int layers, GLint internal_format = GL_RGBA8);
+
+  //////////////////////////////////////////////////////
+  // ctr(s) / dctr(s)
+  //////////////////////////////////////////////////////
+  texture_array_pool(ci::ivec2 size, int layers, GLint internal_format = GL_RGBA8);
+
+  //////////////////////////////////////////////////////
+  // getters
+  //////////////////////////////////////////////////////
+  ci::gl::Texture3dRef get_texture();
+
+  ci::ivec2 get_size();
+
+  int get_layer_count();
+
+  int get_free_layers();
+
+  //////////////////////////////////////////////////////
+  // methods
+  //////////////////////////////////////////////////////
+  // take a layer from the free list, -1 when every layer is in use
+  int acquire();
+
+  void release(int layer);
+
+  // upload an image into a layer, resized to the layer size if it differs
+  void upload(int layer, const ci::Surface8u & surface);
+
+protected:
+  //////////////////////////////////////////////////////
+  // properties
+  //////////////////////////////////////////////////////
+  ci::gl::Texture3dRef texture;
+  ci::ivec2 size;
+  int layer_count;
+  std::vector<int> free_layers;
+};
+
+//////////////////////////////////////////////////////
+// typedefs
+//////////////////////////////////////////////////////
+typedef texture_array_pool::texture_array_pool_ref texture_array_pool_ref;
+
+/////////////////////////////////////////////////
+//
+//  array_provider
+//  An image held in a layer of a texture_array_pool,
+//  the layer is kept across set_source() calls and
+//  returned to the pool when the provider is destroyed
+//
+//  There is no 2d texture, sprites using an
+//  array_provider are drawn with a sprite_batch
+//
+/////////////////////////////////////////////////
+class array_provider : public texture_provider {
+public:
+  //////////////////////////////////////////////////////
+  // static
+  //////////////////////////////////////////////////////
+  typedef std::shared_ptr<array_provider> array_provider_ref;
+
+  static array_provider_ref create(texture_array_pool_ref pool, std::string path = "");
+
+  //////////////////////////////////////////////////////
+  // ctr(s) / dctr(s)
+  //////////////////////////////////////////////////////
+  array_provider(texture_array_pool_ref pool);
+
+  ~array_provider();
+
+  //////////////////////////////////////////////////////
+  // getters
+  //////////////////////////////////////////////////////
+  ci::vec2 get_size() override;
+
+  provider_type get_type() override { return provider_type::Image; }
+
+  bool is_ready() override;
+
+  texture_array_pool_ref get_pool();
+
+  // the layer holding the image, -1 if the pool was full
+  int get_layer();
+
+  //////////////////////////////////////////////////////
+  // setters
+  //////////////////////////////////////////////////////
+  void set_source(std::string path) override;
+
+  void set_surface(const ci::Surface8uRef & surface);
+
+  //////////////////////////////////////////////////////
+  // methods
+  //////////////////////////////////////////////////////
+  void update() override {}
+
+protected:
+  //////////////////////////////////////////////////////
+  // properties
+  //////////////////////////////////////////////////////
+  texture_array_pool_ref pool;
+  int layer;
+  bool loaded;
+};
+
+//////////////////////////////////////////////////////
+// typedefs
+//////////////////////////////////////////////////////
+typedef array_provider::array_provider_ref array_provider_ref;
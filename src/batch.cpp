@@ -0,0 +1,246 @@
+// std
+#include <algorithm>
+#include <cstddef>
+
+// cinder
+#include "cinder/Log.h"
+#include "cinder/gl/gl.h"
+
+// sfmoma
+#include "batch.h"
+#include "dirty.h"
+#include "jobs.h"
+#include "profiler.h"
+
+using namespace ci;
+
+namespace {
+  gl::GlslProgRef program;
+
+  // sprites per job, enough that a job outweighs handing it out
+  const size_t chunk_size = 1024;
+
+#if defined( CINDER_GL_ES )
+  const char * header =
+    "#version 300 es\n"
+    "precision highp float;\n"
+    "precision highp sampler2DArray;\n";
+#else
+  const char * header =
+    "#version 150\n";
+#endif
+
+  const char * vertex_source = R"(
+    uniform mat4 ciModelViewProjection;
+    in vec4 ciPosition;
+    in vec3 ciTexCoord0;
+    in vec4 ciColor;
+    out vec3 vTexCoord;
+    out vec4 vColor;
+    void main() {
+      vTexCoord = ciTexCoord0;
+      vColor = ciColor;
+      gl_Position = ciModelViewProjection * ciPosition;
+    }
+  )";
+
+  const char * fragment_source = R"(
+    uniform sampler2DArray uTex0;
+    in vec3 vTexCoord;
+    in vec4 vColor;
+    out vec4 oColor;
+    void main() {
+      vec4 c = texture(uTex0, vTexCoord);
+      c.rgb *= vColor.rgb;
+      oColor = vec4(c.rgb * c.a * vColor.a, c.a * vColor.a);
+    }
+  )";
+
+  gl::GlslProgRef get_program() {
+    if(!program) {
+      try {
+        program = gl::GlslProg::create(gl::GlslProg::Format()
+          .vertex(std::string(header) + vertex_source)
+          .fragment(std::string(header) + fragment_source));
+        program->uniform("uTex0", 0);
+      } catch(const gl::GlslProgExc & e) {
+        CI_LOG_E("Error compiling sprite batch shader: " << e.what());
+      }
+    }
+    return program;
+  }
+}
+
+////////////////////////////////////////////////////
+//  static
+////////////////////////////////////////////////////
+sprite_batch_ref sprite_batch::create(texture_array_pool_ref pool) {
+  return std::make_shared<sprite_batch>(pool);
+}
+
+//////////////////////////////////////////////////////
+// ctr(s) / dctr(s)
+//////////////////////////////////////////////////////
+sprite_batch::sprite_batch(texture_array_pool_ref array_pool) {
+  pool = array_pool;
+  drawn = 0;
+}
+
+//////////////////////////////////////////////////////
+// getters
+//////////////////////////////////////////////////////
+size_t sprite_batch::size() {
+  return sprites.size();
+}
+
+size_t sprite_batch::get_drawn() {
+  return drawn;
+}
+
+//////////////////////////////////////////////////////
+// methods
+//////////////////////////////////////////////////////
+void sprite_batch::add(const sprite_ref & sp) {
+  sprites.push_back(sp);
+  if(dirty_tracker::is_enabled()) dirty_tracker::damage(sp->get_bounds());
+}
+
+void sprite_batch::remove(const sprite_ref & sp) {
+  sprites.erase(std::remove(sprites.begin(), sprites.end(), sp), sprites.end());
+  if(dirty_tracker::is_enabled()) dirty_tracker::damage(sp->get_bounds());
+}
+
+void sprite_batch::clear() {
+  if(dirty_tracker::is_enabled()) {
+    for(auto & sp : sprites) dirty_tracker::damage(sp->get_bounds());
+  }
+  sprites.clear();
+}
+
+void sprite_batch::draw() {
+  prepare(nullptr);
+  submit();
+}
+
+void sprite_batch::draw(const Rectf & visible) {
+  prepare(&visible);
+  submit();
+}
+
+void sprite_batch::prepare() {
+  prepare(nullptr);
+}
+
+void sprite_batch::prepare(const Rectf & visible) {
+  prepare(&visible);
+}
+
+/**
+ * Build the quads a chunk of sprites at a time on the job system,
+ * then join the chunks in the order the sprites were added
+ */
+void sprite_batch::prepare(const Rectf * visible) {
+  SPRITE_PROFILE_SCOPE("sprite_batch::prepare");
+
+  // deliveries can render, they stay on this thread
+  for(auto & sp : sprites) {
+    if(sp->provider) sp->provider->deliver_updates();
+  }
+
+  chunks.resize((sprites.size() + chunk_size - 1) / chunk_size);
+  job_system::parallel_for(sprites.size(), chunk_size, [&](size_t begin, size_t end) {
+    build(begin, end, visible, chunks[begin / chunk_size]);
+  });
+
+  std::vector<size_t> offsets(chunks.size());
+  size_t total = 0;
+  drawn = 0;
+  for(size_t i = 0; i < chunks.size(); i++) {
+    offsets[i] = total;
+    total += chunks[i].vertices.size();
+    drawn += chunks[i].shown.size();
+    for(size_t shown : chunks[i].shown) sprites[shown]->provider->mark_visible();
+  }
+
+  vertices.resize(total);
+  job_system::parallel_for(chunks.size(), 1, [&](size_t begin, size_t end) {
+    for(size_t i = begin; i < end; i++) {
+      std::copy(chunks[i].vertices.begin(), chunks[i].vertices.end(), vertices.begin() + offsets[i]);
+    }
+  });
+}
+
+/**
+ * Build a quad per sprite the same way sprite::draw() places its
+ * output, reading the sprites only
+ */
+void sprite_batch::build(size_t begin, size_t end, const Rectf * visible, chunk & out) {
+  out.vertices.clear();
+  out.shown.clear();
+
+  for(size_t i = begin; i < end; i++) {
+    auto & sp = sprites[i];
+    auto provider = std::dynamic_pointer_cast<array_provider>(sp->provider);
+    if(!provider || provider->get_pool() != pool || provider->get_layer() < 0 || !provider->is_ready()) continue;
+    if(sp->alpha() <= 0.0f || sp->texture_size.x <= 0 || sp->texture_size.y <= 0) continue;
+    if(visible && !visible->intersects(sp->get_frame_bounds(sp->texture_size))) continue;
+
+    vec2 size = sp->texture_size;
+    vec2 offset = sp->origin == sprite::origin_point::Center ? size * 0.5f : vec2(0);
+    Rectf local = sp->mask();
+    Rectf zoom(sp->zoom_area);
+    float layer = (float)provider->get_layer();
+    vec4 color(sp->tint().r, sp->tint().g, sp->tint().b, sp->alpha());
+
+    auto corner = [&](vec2 p) {
+      vec2 position = sp->coordinates() + sp->scale() * (p - offset);
+      vec2 uv = (zoom.getUpperLeft() + p / size * zoom.getSize()) / size;
+      return vertex { position, vec3(uv, layer), color };
+    };
+    vertex ul = corner(local.getUpperLeft());
+    vertex ur = corner(local.getUpperRight());
+    vertex lr = corner(local.getLowerRight());
+    vertex ll = corner(local.getLowerLeft());
+    out.vertices.insert(out.vertices.end(), { ul, ur, lr, ul, lr, ll });
+    out.shown.push_back(i);
+  }
+}
+
+void sprite_batch::submit() {
+  SPRITE_PROFILE_SCOPE("sprite_batch::submit");
+  if(vertices.empty()) return;
+
+  auto prog = get_program();
+  if(!prog) return;
+
+  // orphan the buffer every frame so the driver never waits on the last draw
+  size_t bytes = vertices.size() * sizeof(vertex);
+  if(!vbo || vbo->getSize() < bytes) {
+    vbo = gl::Vbo::create(GL_ARRAY_BUFFER, bytes, vertices.data(), GL_STREAM_DRAW);
+  } else {
+    vbo->bufferData(vbo->getSize(), nullptr, GL_STREAM_DRAW);
+    vbo->bufferSubData(0, bytes, vertices.data());
+  }
+  gl::VaoRef & vao = vaos[gl::context()];
+  if(!vao) vao = gl::Vao::create();
+
+  gl::ScopedGlslProg scoped_prog(prog);
+  gl::ScopedVao scoped_vao(vao);
+  gl::ScopedBuffer scoped_vbo(vbo);
+  gl::ScopedTextureBind scoped_texture(pool->get_texture(), 0);
+  gl::ScopedBlendPremult scoped_blend;
+
+  int position = prog->getAttribSemanticLocation(geom::Attrib::POSITION);
+  int uv = prog->getAttribSemanticLocation(geom::Attrib::TEX_COORD_0);
+  int color = prog->getAttribSemanticLocation(geom::Attrib::COLOR);
+  gl::enableVertexAttribArray(position);
+  gl::vertexAttribPointer(position, 2, GL_FLOAT, GL_FALSE, sizeof(vertex), (const GLvoid *)offsetof(vertex, position));
+  gl::enableVertexAttribArray(uv);
+  gl::vertexAttribPointer(uv, 3, GL_FLOAT, GL_FALSE, sizeof(vertex), (const GLvoid *)offsetof(vertex, uv));
+  gl::enableVertexAttribArray(color);
+  gl::vertexAttribPointer(color, 4, GL_FLOAT, GL_FALSE, sizeof(vertex), (const GLvoid *)offsetof(vertex, color));
+
+  gl::setDefaultShaderVars();
+  gl::drawArrays(GL_TRIANGLES, 0, (GLsizei)vertices.size());
+  SPRITE_PROFILE_COUNT("draw_calls", 1);
+}
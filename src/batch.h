@@ -0,0 +1,111 @@
+#pragma once
+
+// std
+#include <map>
+#include <vector>
+
+// cinder
+#include "cinder/gl/Context.h"
+#include "cinder/gl/Vao.h"
+#include "cinder/gl/Vbo.h"
+
+// sfmoma
+#include "array.h"
+#include "sprite.h"
+
+/////////////////////////////////////////////////
+//
+//  sprite_batch
+//  Draws sprites whose providers are array_providers
+//  of one texture_array_pool with a single texture
+//  bind and a single draw call
+//
+//  Position, scale, origin, alpha, tint, mask and
+//  zoom are honoured; everything is blended
+//  premultiplied and mask feathering is not applied
+//
+/////////////////////////////////////////////////
+class sprite_batch {
+public:
+  //////////////////////////////////////////////////////
+  // static
+  //////////////////////////////////////////////////////
+  typedef std::shared_ptr<sprite_batch> sprite_batch_ref;
+
+  static sprite_batch_ref create(texture_array_pool_ref pool);
+
+  //////////////////////////////////////////////////////
+  // ctr(s) / dctr(s)
+  //////////////////////////////////////////////////////
+  sprite_batch(texture_array_pool_ref pool);
+
+  //////////////////////////////////////////////////////
+  // getters
+  //////////////////////////////////////////////////////
+  size_t size();
+
+  // sprites drawn by the last draw(), ie. those that were loaded and visible
+  size_t get_drawn();
+
+  //////////////////////////////////////////////////////
+  // methods
+  //////////////////////////////////////////////////////
+  void add(const sprite_ref & sp);
+
+  void remove(const sprite_ref & sp);
+
+  void clear();
+
+  // draw in the order the sprites were added
+  void draw();
+
+  // the same, skipping sprites outside visible, ie. a window's part of the canvas
+  void draw(const ci::Rectf & visible);
+
+  // build the quads for submit() on the job_system, ie. in update() while the gpu
+  // works on the last frame; the sprites must not change until they are submitted
+  void prepare();
+
+  void prepare(const ci::Rectf & visible);
+
+  // draw what prepare() built, the only part that needs the gl thread
+  void submit();
+
+protected:
+  //////////////////////////////////////////////////////
+  // properties
+  //////////////////////////////////////////////////////
+  class vertex {
+  public:
+    ci::vec2 position;
+    ci::vec3 uv;       // layer in z
+    ci::vec4 color;
+  };
+
+  // the quads one job built, kept between frames so they do not reallocate
+  class chunk {
+  public:
+    std::vector<vertex> vertices;
+    std::vector<size_t> shown;  // the sprites drawn
+  };
+
+  texture_array_pool_ref pool;
+  std::vector<sprite_ref> sprites;
+  std::vector<chunk> chunks;
+  std::vector<vertex> vertices;
+  ci::gl::VboRef vbo;
+  std::map<ci::gl::Context *, ci::gl::VaoRef> vaos;  // vaos are not shared between contexts
+  size_t drawn;
+
+  //////////////////////////////////////////////////////
+  // methods
+  //////////////////////////////////////////////////////
+  void prepare(const ci::Rectf * visible);
+
+  void build(size_t begin, size_t end, const ci::Rectf * visible, chunk & out);
+};
+
+//////////////////////////////////////////////////////
+// typedefs
+//////////////////////////////////////////////////////
+typedef sprite_batch::sprite_batch_ref sprite_batch_ref;
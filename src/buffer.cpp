@@ -0,0 +1,238 @@
+// std
+#include <algorithm>
+
+// cinder
+#include "cinder/Log.h"
+#include "cinder/gl/gl.h"
+
+// sfmoma
+#include "buffer.h"
+#include "color.h"
+#include "memory.h"
+#include "profiler.h"
+
+using namespace ci;
+
+namespace {
+  // slots start on a boundary drivers are happy to read pixels from
+  const size_t slot_alignment = 256;
+}
+
+////////////////////////////////////////////////////
+//  static
+////////////////////////////////////////////////////
+buffer_provider_ref buffer_provider::create(ivec2 size, int slots) {
+  return std::make_shared<buffer_provider>(size, slots);
+}
+
+//////////////////////////////////////////////////////
+// ctr(s) / dctr(s)
+//////////////////////////////////////////////////////
+buffer_provider::buffer_provider(ivec2 frame_size, int slot_count) {
+  size = glm::max(frame_size, ivec2(1));
+  frame_bytes = (size_t)size.x * size.y * 4;
+  writing = -1;
+  sequence = 0;
+  buffer = 0;
+  mapped = nullptr;
+  published = 0;
+  uploaded = 0;
+  dropped = 0;
+  texture_is_new = false;
+
+  size_t stride = (frame_bytes + slot_alignment - 1) / slot_alignment * slot_alignment;
+  slots.resize(std::max(slot_count, 2));
+
+#if defined( GL_MAP_PERSISTENT_BIT )
+  if(gl::isExtensionAvailable("GL_ARB_buffer_storage")) {
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glGenBuffers(1, &buffer);
+    gl::ScopedBuffer scoped_buffer(GL_PIXEL_UNPACK_BUFFER, buffer);
+    glBufferStorage(GL_PIXEL_UNPACK_BUFFER, stride * slots.size(), nullptr, flags);
+    mapped = (uint8_t *)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, stride * slots.size(), flags);
+    if(!mapped) {
+      CI_LOG_W("Persistent mapping failed, buffer_provider falls back to cpu memory");
+      glDeleteBuffers(1, &buffer);
+      buffer = 0;
+    }
+  }
+#endif
+
+  if(mapped) {
+    storage = std::make_shared<GLuint>(buffer);
+    gpu_memory::track(storage, "pbo", "buffer_provider", stride * slots.size());
+  } else {
+    memory.resize(stride * slots.size());
+  }
+
+  uint8_t * base = mapped ? mapped : memory.data();
+  for(size_t i = 0; i < slots.size(); i++) {
+    slots[i] = { base + i * stride, i * stride, Free, 0, nullptr };
+  }
+
+  gl::Texture::Format format = color_policy::get_texture_format().minFilter(GL_LINEAR).magFilter(GL_LINEAR);
+  gpu_memory::reserve(gpu_memory::get_texture_bytes(size, format.getInternalFormat()));
+  gl::TextureRef created = gl::Texture::create(size.x, size.y, format);
+  created->setTopDown(true);
+  gpu_memory::track(created, "buffer_provider");
+  texture = created;
+}
+
+buffer_provider::~buffer_provider() {
+#if ! defined( CINDER_GL_ES_2 )
+  for(auto & s : slots) {
+    if(s.fence) glDeleteSync((GLsync)s.fence);
+  }
+#endif
+#if defined( GL_MAP_PERSISTENT_BIT )
+  if(buffer) {
+    gl::ScopedBuffer scoped_buffer(GL_PIXEL_UNPACK_BUFFER, buffer);
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    glDeleteBuffers(1, &buffer);
+  }
+#endif
+}
+
+//////////////////////////////////////////////////////
+// getters
+//////////////////////////////////////////////////////
+vec2 buffer_provider::get_size() {
+  return size;
+}
+
+bool buffer_provider::is_ready() {
+  return uploaded > 0;
+}
+
+size_t buffer_provider::get_row_bytes() {
+  return (size_t)size.x * 4;
+}
+
+bool buffer_provider::is_persistent() {
+  return mapped != nullptr;
+}
+
+uint64_t buffer_provider::get_published_frames() {
+  return published;
+}
+
+uint64_t buffer_provider::get_uploaded_frames() {
+  return uploaded;
+}
+
+uint64_t buffer_provider::get_dropped_frames() {
+  return dropped;
+}
+
+//////////////////////////////////////////////////////
+// methods
+//////////////////////////////////////////////////////
+/**
+ * Take a free slot, or if there is none the oldest published frame
+ * that has not been uploaded yet
+ */
+uint8_t * buffer_provider::begin_frame() {
+  std::lock_guard<std::mutex> lock(mutex);
+  if(writing >= 0) return slots[writing].data;
+
+  int oldest_ready = -1;
+  for(int i = 0; i < (int)slots.size(); i++) {
+    if(slots[i].state == Free) {
+      writing = i;
+      break;
+    }
+    if(slots[i].state == Ready && (oldest_ready < 0 || slots[i].sequence < slots[oldest_ready].sequence)) {
+      oldest_ready = i;
+    }
+  }
+  if(writing < 0 && oldest_ready >= 0) {
+    writing = oldest_ready;
+    dropped++;
+  }
+  if(writing < 0) return nullptr;
+
+  slots[writing].state = Writing;
+  return slots[writing].data;
+}
+
+void buffer_provider::end_frame() {
+  std::lock_guard<std::mutex> lock(mutex);
+  if(writing < 0) return;
+  slots[writing].state = Ready;
+  slots[writing].sequence = ++sequence;
+  writing = -1;
+  published++;
+}
+
+void buffer_provider::update() {
+  schedule(frame_bytes, [=] {
+    SPRITE_PROFILE_SCOPE("buffer_provider::update");
+    slot * newest = nullptr;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+
+      // slots the gpu has finished reading from can be written again
+      for(auto & s : slots) {
+        if(s.state != Uploading) continue;
+#if ! defined( CINDER_GL_ES_2 )
+        if(s.fence) {
+          GLenum status = glClientWaitSync((GLsync)s.fence, 0, 0);
+          if(status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) continue;
+          glDeleteSync((GLsync)s.fence);
+          s.fence = nullptr;
+        }
+#endif
+        s.state = Free;
+      }
+
+      // only the newest frame is uploaded
+      for(auto & s : slots) {
+        if(s.state == Ready && (!newest || s.sequence > newest->sequence)) newest = &s;
+      }
+      if(!newest) return (size_t)0;
+      for(auto & s : slots) {
+        if(s.state == Ready && &s != newest) {
+          s.state = Free;
+          dropped++;
+        }
+      }
+      newest->state = Uploading;
+    }
+
+    upload(*newest);
+    uploaded++;
+
+    // cpu memory has been copied by the driver once glTexSubImage2D returns
+    if(!mapped) {
+      std::lock_guard<std::mutex> lock(mutex);
+      newest->state = Free;
+    }
+
+    if(uploaded == 1) {
+      set_texture(texture);
+    } else {
+      set_texture_changed(texture->getBounds());
+    }
+    return frame_bytes;
+  });
+}
+
+void buffer_provider::upload(slot & s) {
+  gl::ScopedTextureBind scoped_texture(texture);
+  GLint unpack_alignment;
+  glGetIntegerv(GL_UNPACK_ALIGNMENT, &unpack_alignment);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+#if defined( GL_MAP_PERSISTENT_BIT )
+  if(mapped) {
+    gl::ScopedBuffer scoped_buffer(GL_PIXEL_UNPACK_BUFFER, buffer);
+    glTexSubImage2D(texture->getTarget(), 0, 0, 0, size.x, size.y,
+      GL_RGBA, GL_UNSIGNED_BYTE, (const void *)s.offset);
+    s.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  } else
+#endif
+  {
+    glTexSubImage2D(texture->getTarget(), 0, 0, 0, size.x, size.y,
+      GL_RGBA, GL_UNSIGNED_BYTE, s.data);
+  }
+  glPixelStorei(GL_UNPACK_ALIGNMENT, unpack_alignment);
+}
@@ -0,0 +1,129 @@
+#pragma once
+
+// std
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+// sfmoma
+#include "provider.h"
+
+/////////////////////////////////////////////////
+//
+//  buffer_provider
+//  A texture fed with RGBA8 pixels written on
+//  the cpu, ie. by a simulation thread
+//
+//  Frames are written straight into a ring of
+//  persistently mapped pixel buffers where the
+//  driver supports them (GL 4.4 / ARB_buffer_storage),
+//  otherwise into cpu memory uploaded from the
+//  gl thread. Slots are recycled once a fence
+//  shows the gpu has finished reading them, and
+//  the producer is never blocked: when every slot
+//  is busy the oldest unuploaded frame is dropped
+//
+/////////////////////////////////////////////////
+class buffer_provider : public texture_provider {
+public:
+  //////////////////////////////////////////////////////
+  // static
+  //////////////////////////////////////////////////////
+  typedef std::shared_ptr<buffer_provider> buffer_provider_ref;
+
+  static buffer_provider_ref create(ci::ivec2 size, int slots = 3);
+
+  //////////////////////////////////////////////////////
+  // ctr(s) / dctr(s)
+  //////////////////////////////////////////////////////
+  // create on the gl thread, stop the producer before destroying
+  buffer_provider(ci::ivec2 size, int slots = 3);
+
+  ~buffer_provider();
+
+  //////////////////////////////////////////////////////
+  // getters
+  //////////////////////////////////////////////////////
+  ci::vec2 get_size() override;
+
+  provider_type get_type() override { return provider_type::Buffer; }
+
+  bool is_ready() override;
+
+  // bytes between the start of rows in a frame
+  size_t get_row_bytes();
+
+  // whether frames are written directly into gpu visible memory
+  bool is_persistent();
+
+  uint64_t get_published_frames();
+
+  uint64_t get_uploaded_frames();
+
+  // frames published but replaced by a newer one before they were uploaded
+  uint64_t get_dropped_frames();
+
+  //////////////////////////////////////////////////////
+  // setters
+  //////////////////////////////////////////////////////
+  void set_source(std::string path) override {}
+
+  //////////////////////////////////////////////////////
+  // methods
+  //////////////////////////////////////////////////////
+  // producer thread: memory for the next frame, RGBA8 with the top row first,
+  // nullptr if every slot is in use. Only one frame can be written at a time
+  uint8_t * begin_frame();
+
+  // producer thread: publish the frame from begin_frame
+  void end_frame();
+
+  // gl thread: upload the newest published frame
+  void update() override;
+
+protected:
+  //////////////////////////////////////////////////////
+  // properties
+  //////////////////////////////////////////////////////
+  enum slot_state {
+    Free,
+    Writing,
+    Ready,
+    Uploading
+  };
+
+  class slot {
+  public:
+    uint8_t * data;
+    size_t offset;
+    slot_state state;
+    uint64_t sequence;
+    void * fence;
+  };
+
+  ci::ivec2 size;
+  size_t frame_bytes;
+  std::vector<slot> slots;
+  std::vector<uint8_t> memory;   // slot memory when not persistent
+  int writing;
+  uint64_t sequence;
+  std::mutex mutex;
+
+  GLuint buffer;
+  uint8_t * mapped;
+  std::shared_ptr<GLuint> storage;   // lifetime handle for gpu_memory
+
+  std::atomic<uint64_t> published;
+  std::atomic<uint64_t> uploaded;
+  std::atomic<uint64_t> dropped;
+
+  //////////////////////////////////////////////////////
+  // methods
+  //////////////////////////////////////////////////////
+  void upload(slot & s);
+};
+
+//////////////////////////////////////////////////////
+// typedefs
+//////////////////////////////////////////////////////
+typedef buffer_provider::buffer_provider_ref buffer_provider_ref;
@@ -0,0 +1,141 @@
+// std
+#include <algorithm>
+
+// sfmoma
+#include "cache.h"
+#include "memory.h"
+
+using namespace ci;
+
+namespace {
+  std::map<std::string, gl::TextureRef> textures;
+  std::map<std::tuple<int, int, int, GLint>, std::vector<gl::FboRef>> free_fbos;
+  int misses = 0;
+  int free_limit = 8;
+
+  // drop cached textures nothing else holds, they are the ones that free memory
+  void evict_textures(size_t bytes) {
+    size_t freed = 0;
+    for(auto it = textures.begin(); it != textures.end() && freed < bytes;) {
+      if(it->second.use_count() == 1) {
+        freed += gpu_memory::get_texture_bytes(it->second);
+        it = textures.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+
+  // free fbos are only held by the pool
+  void evict_fbos(size_t bytes) {
+    size_t freed = 0;
+    for(auto & available : free_fbos) {
+      while(!available.second.empty() && freed < bytes) {
+        freed += gpu_memory::get_fbo_bytes(available.second.back());
+        available.second.pop_back();
+      }
+    }
+  }
+
+  // spare fbos are cheaper to lose than cached textures
+  void add_evictors() {
+    static bool added = false;
+    if(added) return;
+    gpu_memory::add_evictor(0, evict_fbos);
+    gpu_memory::add_evictor(1, evict_textures);
+    added = true;
+  }
+}
+
+/////////////////////////////////////////////////
+//
+//  texture_cache
+//
+/////////////////////////////////////////////////
+gl::TextureRef texture_cache::get(const std::string & source) {
+  auto it = textures.find(source);
+  if(it == textures.end()) return nullptr;
+  return it->second;
+}
+
+void texture_cache::put(const std::string & source, const gl::TextureRef & texture) {
+  add_evictors();
+  gpu_memory::track(texture, "texture_cache");
+  textures[source] = texture;
+}
+
+void texture_cache::remove(const std::string & source) {
+  textures.erase(source);
+}
+
+void texture_cache::clear() {
+  textures.clear();
+}
+
+size_t texture_cache::size() {
+  return textures.size();
+}
+
+/////////////////////////////////////////////////
+//
+//  fbo_pool
+//
+/////////////////////////////////////////////////
+fbo_pool::key fbo_pool::make_key(ivec2 size, const gl::Fbo::Format & format) {
+  return key(size.x, size.y, format.getSamples(), format.getColorTextureFormat().getInternalFormat());
+}
+
+gl::FboRef fbo_pool::acquire(ivec2 size, const gl::Fbo::Format & format, const char * owner) {
+  add_evictors();
+  auto & available = free_fbos[make_key(size, format)];
+  if(!available.empty()) {
+    gl::FboRef fbo = available.back();
+    available.pop_back();
+    gpu_memory::track(fbo, owner);
+    return fbo;
+  }
+  misses++;
+  gpu_memory::reserve(gpu_memory::get_fbo_bytes(size, format));
+  gl::FboRef fbo = gl::Fbo::create(size.x, size.y, format);
+  gpu_memory::track(fbo, owner);
+  return fbo;
+}
+
+void fbo_pool::release(const gl::FboRef & fbo, const gl::Fbo::Format & format) {
+  if(!fbo) return;
+  auto & available = free_fbos[make_key(fbo->getSize(), format)];
+  if((int)available.size() >= free_limit) return;
+  gpu_memory::track(fbo, "fbo_pool");
+  available.push_back(fbo);
+}
+
+void fbo_pool::reserve(ivec2 size, const gl::Fbo::Format & format, int count) {
+  add_evictors();
+  auto & available = free_fbos[make_key(size, format)];
+  for(int i = 0; i < count; i++) {
+    gpu_memory::reserve(gpu_memory::get_fbo_bytes(size, format));
+    gl::FboRef fbo = gl::Fbo::create(size.x, size.y, format);
+    gpu_memory::track(fbo, "fbo_pool");
+    available.push_back(fbo);
+  }
+}
+
+int fbo_pool::get_misses() {
+  return misses;
+}
+
+void fbo_pool::set_free_limit(int count) {
+  free_limit = std::max(count, 0);
+  for(auto & available : free_fbos) {
+    if((int)available.second.size() > free_limit) available.second.resize(free_limit);
+  }
+}
+
+void fbo_pool::trim() {
+  free_fbos.clear();
+}
+
+void fbo_pool::clear() {
+  free_fbos.clear();
+  misses = 0;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+// std
+#include <map>
+#include <string>
+#include <tuple>
+#include <vector>
+
+// cinder
+#include "cinder/gl/Fbo.h"
+#include "cinder/gl/Texture.h"
+
+/////////////////////////////////////////////////
+//
+//  texture_cache
+//  Textures keyed by source, filled by the
+//  preloader and consulted by image_provider
+//
+//  Unused textures are dropped when gpu_memory
+//  needs room for an allocation
+//
+/////////////////////////////////////////////////
+class texture_cache {
+public:
+  // the cached texture for a source, or nullptr
+  static ci::gl::TextureRef get(const std::string & source);
+
+  static void put(const std::string & source, const ci::gl::TextureRef & texture);
+
+  static void remove(const std::string & source);
+
+  static void clear();
+
+  static size_t size();
+};
+
+/////////////////////////////////////////////////
+//
+//  fbo_pool
+//  Reusable render targets keyed by size and
+//  format, so sprites do not allocate on resize
+//
+//  Free fbos are the first thing gpu_memory
+//  evicts when over budget, and at most
+//  free_limit of each size and format are kept
+//
+/////////////////////////////////////////////////
+class fbo_pool {
+public:
+  // get an fbo from the pool, creating one if none are free,
+  // owner is what gpu_memory reports it under
+  static ci::gl::FboRef acquire(
+    ci::ivec2 size,
+    const ci::gl::Fbo::Format & format,
+    const char * owner = "fbo_pool");
+
+  // return an fbo to the pool
+  static void release(const ci::gl::FboRef & fbo, const ci::gl::Fbo::Format & format);
+
+  // allocate count fbos ahead of time
+  static void reserve(ci::ivec2 size, const ci::gl::Fbo::Format & format, int count);
+
+  // number of acquire() calls that had to allocate
+  static int get_misses();
+
+  // free fbos kept per size and format, release() drops any beyond it, 8 by default
+  static void set_free_limit(int count);
+
+  // drop every free fbo
+  static void trim();
+
+  static void clear();
+
+private:
+  typedef std::tuple<int, int, int, GLint> key;
+
+  static key make_key(ci::ivec2 size, const ci::gl::Fbo::Format & format);
+};
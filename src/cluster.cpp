@@ -0,0 +1,420 @@
+// std
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+// cinder
+#include "asio/asio.hpp"
+#include "cinder/Log.h"
+
+// sfmoma
+#include "cluster.h"
+#include "profiler.h"
+#include "sprite.h"
+
+using namespace ci;
+using asio::ip::udp;
+
+namespace {
+  const uint32_t magic = 0x43535043;     // "CSPC"
+  const uint64_t resend_frames = 30;     // messages ride along this many frames after they are due
+  const size_t max_datagram = 60000;
+
+  enum packet_type : uint32_t {
+    Hello = 1,
+    Frame,
+    Ack
+  };
+
+#pragma pack(push, 1)
+  class packet_header {
+  public:
+    uint32_t magic;
+    uint32_t type;
+    uint32_t node;
+    uint32_t count;
+    uint64_t frame;
+    double time;
+  };
+
+  class message_header {
+  public:
+    uint64_t id;
+    uint64_t frame;
+    uint32_t topic_length;
+    uint32_t payload_length;
+  };
+#pragma pack(pop)
+
+  void append(std::string & out, const void * data, size_t bytes) {
+    out.append((const char *)data, bytes);
+  }
+
+  packet_header make_header(packet_type type, int node, uint64_t frame, double time) {
+    packet_header header;
+    header.magic = magic;
+    header.type = type;
+    header.node = (uint32_t)node;
+    header.count = 0;
+    header.frame = frame;
+    header.time = time;
+    return header;
+  }
+}
+
+/////////////////////////////////////////////////
+//
+//  cluster_sync::transport
+//  Non-blocking udp, polled from the frame calls
+//
+/////////////////////////////////////////////////
+class cluster_sync::transport {
+public:
+  transport(bool master, const std::string & host, uint16_t port) : socket(service) {
+    asio::error_code ec;
+    socket.open(udp::v4(), ec);
+    if(master) {
+      socket.bind(udp::endpoint(udp::v4(), port), ec);
+      if(ec) CI_LOG_E("Error binding port " << port << ": " << ec.message());
+    } else {
+      udp::resolver resolver(service);
+      auto it = resolver.resolve(udp::resolver::query(udp::v4(), host, std::to_string(port)), ec);
+      if(ec || it == udp::resolver::iterator()) {
+        CI_LOG_E("Error resolving " << host << ": " << ec.message());
+      } else {
+        master_endpoint = *it;
+      }
+    }
+    socket.non_blocking(true, ec);
+  }
+
+  void send(const udp::endpoint & to, const std::string & data) {
+    asio::error_code ec;
+    socket.send_to(asio::buffer(data), to, 0, ec);
+    if(ec && ec != asio::error::would_block) CI_LOG_W("Error sending to " << to << ": " << ec.message());
+  }
+
+  // false when nothing is waiting
+  bool receive(std::string & data, udp::endpoint & from) {
+    asio::error_code ec;
+    size_t bytes = socket.receive_from(asio::buffer(buffer), from, 0, ec);
+    if(ec) return false;
+    data.assign(buffer, bytes);
+    return true;
+  }
+
+  asio::io_service service;
+  udp::socket socket;
+  udp::endpoint master_endpoint;
+  std::map<int, udp::endpoint> nodes;
+  char buffer[65536];
+};
+
+/////////////////////////////////////////////////
+//
+//  cluster_sync
+//
+/////////////////////////////////////////////////
+cluster_sync_ref cluster_sync::create_master(uint16_t port, int node_count) {
+  return std::make_shared<cluster_sync>(true, "", port, 0, node_count);
+}
+
+cluster_sync_ref cluster_sync::create_node(const std::string & master_host, uint16_t port, int node_id) {
+  return std::make_shared<cluster_sync>(false, master_host, port, std::max(node_id, 1), 0);
+}
+
+cluster_sync::cluster_sync(bool is_master, const std::string & host, uint16_t port, int id, int count) {
+  master = is_master;
+  node_id = id;
+  node_count = count;
+  connected = false;
+  frame = 0;
+  time = 0.0;
+  timeout_ms = 100.0;
+  next_message = 1;
+  finished = 0.0;
+  offset = 0.0;
+  net.reset(new transport(master, host, port));
+  timeline = Timeline::create();
+  previous_timeline = sprite::set_default_timeline(timeline);
+  clock.start();
+  reset_stats();
+}
+
+cluster_sync::~cluster_sync() {
+  sprite::set_default_timeline(previous_timeline);
+}
+
+//////////////////////////////////////////////////////
+// getters
+//////////////////////////////////////////////////////
+bool cluster_sync::is_master() {
+  return master;
+}
+
+int cluster_sync::get_node_id() {
+  return node_id;
+}
+
+int cluster_sync::get_node_count() {
+  return (int)net->nodes.size();
+}
+
+bool cluster_sync::is_connected() {
+  return connected;
+}
+
+uint64_t cluster_sync::get_frame() {
+  return frame;
+}
+
+double cluster_sync::get_time() {
+  return time;
+}
+
+TimelineRef cluster_sync::get_timeline() {
+  return timeline;
+}
+
+cluster_sync::stats cluster_sync::get_stats() {
+  return frame_stats;
+}
+
+//////////////////////////////////////////////////////
+// setters
+//////////////////////////////////////////////////////
+void cluster_sync::set_timeout(double ms) {
+  timeout_ms = std::max(0.0, ms);
+}
+
+//////////////////////////////////////////////////////
+// methods
+//////////////////////////////////////////////////////
+void cluster_sync::on(const std::string & topic, message_fn fn) {
+  handlers[topic] = fn;
+}
+
+void cluster_sync::send(const std::string & topic, const std::string & payload, int delay) {
+  if(!master) {
+    CI_LOG_W("Only the master sends, dropping " << topic);
+    return;
+  }
+  message m;
+  m.id = next_message++;
+  m.frame = frame + std::max(delay, 1);
+  m.topic = topic;
+  m.payload = payload;
+  messages.push_back(m);
+}
+
+void cluster_sync::begin_frame() {
+  SPRITE_PROFILE_SCOPE("cluster_sync::begin_frame");
+  if(master) begin_master_frame();
+  else begin_node_frame();
+
+  // stepped first, so tweens a message starts begin at this frame's time
+  timeline->stepTo((float)time);
+  run_due_messages();
+}
+
+void cluster_sync::end_frame() {
+  finished = clock.getSeconds();
+  if(master || !connected) return;
+  packet_header header = make_header(Ack, node_id, frame, finished + offset);
+  std::string data;
+  append(data, &header, sizeof(header));
+  net->send(net->master_endpoint, data);
+}
+
+void cluster_sync::reset_stats() {
+  frame_stats.frames = 0;
+  frame_stats.timeouts = 0;
+  frame_stats.mean_skew_ms = 0.0;
+  frame_stats.max_skew_ms = 0.0;
+  frame_stats.last_skew_ms = 0.0;
+  frame_stats.mean_wait_ms = 0.0;
+}
+
+/**
+ * Wait for every node to acknowledge the last frame, then
+ * broadcast the next with the messages still in flight
+ */
+void cluster_sync::begin_master_frame() {
+  double start = clock.getSeconds();
+  double deadline = start + timeout_ms / 1000.0;
+  std::string data;
+  udp::endpoint from;
+  while(true) {
+    while(net->receive(data, from)) {
+      if(data.size() < sizeof(packet_header)) continue;
+      packet_header header;
+      std::memcpy(&header, data.data(), sizeof(header));
+      if(header.magic != magic) continue;
+      if(header.type == Hello) {
+        if(!net->nodes.count(header.node)) CI_LOG_I("Node " << header.node << " joined from " << from);
+        net->nodes[header.node] = from;
+        connected = (int)net->nodes.size() >= node_count;
+      } else if(header.type == Ack && header.frame == frame) {
+        acks[header.node] = header.time;
+      }
+    }
+
+    bool all = frame == 0 || std::all_of(net->nodes.begin(), net->nodes.end(), [this](const std::pair<const int, udp::endpoint> & node) {
+      return acks.count(node.first) > 0;
+    });
+    if(all) break;
+    if(clock.getSeconds() > deadline) {
+      frame_stats.timeouts++;
+      break;
+    }
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+  }
+  if(frame > 0) record_skew();
+  frame_stats.mean_wait_ms += ((clock.getSeconds() - start) * 1000.0 - frame_stats.mean_wait_ms) / (frame_stats.frames + 1);
+  acks.clear();
+
+  frame++;
+  time = clock.getSeconds();
+  messages.erase(std::remove_if(messages.begin(), messages.end(), [this](const message & m) {
+    return m.frame + resend_frames < frame;
+  }), messages.end());
+
+  packet_header header = make_header(Frame, 0, frame, time);
+  std::string body;
+  for(auto & m : messages) {
+    if(sizeof(header) + body.size() + sizeof(message_header) + m.topic.size() + m.payload.size() > max_datagram) {
+      CI_LOG_W("Frame " << frame << " is full, message " << m.id << " waits for the next");
+      break;
+    }
+    message_header mh;
+    mh.id = m.id;
+    mh.frame = m.frame;
+    mh.topic_length = (uint32_t)m.topic.size();
+    mh.payload_length = (uint32_t)m.payload.size();
+    append(body, &mh, sizeof(mh));
+    body += m.topic;
+    body += m.payload;
+    header.count++;
+  }
+  data.clear();
+  append(data, &header, sizeof(header));
+  data += body;
+  for(auto & node : net->nodes) net->send(node.second, data);
+  frame_stats.frames++;
+}
+
+/**
+ * Wait for the master's next frame, taking the newest if
+ * several arrived, and queue the messages not seen yet
+ */
+void cluster_sync::begin_node_frame() {
+  double start = clock.getSeconds();
+  double deadline = start + timeout_ms / 1000.0;
+  std::string data;
+  udp::endpoint from;
+  bool received_frame = false;
+
+  if(!connected) {
+    packet_header header = make_header(Hello, node_id, 0, 0.0);
+    data.clear();
+    append(data, &header, sizeof(header));
+    net->send(net->master_endpoint, data);
+  }
+
+  while(true) {
+    while(net->receive(data, from)) {
+      if(data.size() < sizeof(packet_header)) continue;
+      packet_header header;
+      std::memcpy(&header, data.data(), sizeof(header));
+      if(header.magic != magic || header.type != Frame || header.frame <= frame) continue;
+      frame = header.frame;
+      time = header.time;
+      offset = header.time - clock.getSeconds();
+      connected = true;
+      received_frame = true;
+
+      // ids missing from the packet will not be resent, so need not be remembered
+      std::set<uint64_t> in_packet;
+      size_t at = sizeof(header);
+      for(uint32_t i = 0; i < header.count && at + sizeof(message_header) <= data.size(); i++) {
+        message_header mh;
+        std::memcpy(&mh, data.data() + at, sizeof(mh));
+        at += sizeof(mh);
+        if(at + mh.topic_length + mh.payload_length > data.size()) break;
+        in_packet.insert(mh.id);
+        bool queued = std::any_of(messages.begin(), messages.end(), [&](const message & m) { return m.id == mh.id; });
+        if(!received.count(mh.id) && !queued) {
+          message m;
+          m.id = mh.id;
+          m.frame = mh.frame;
+          m.topic.assign(data.data() + at, mh.topic_length);
+          m.payload.assign(data.data() + at + mh.topic_length, mh.payload_length);
+          messages.push_back(m);
+        }
+        at += mh.topic_length + mh.payload_length;
+      }
+      for(auto it = received.begin(); it != received.end();) {
+        it = in_packet.count(*it) ? std::next(it) : received.erase(it);
+      }
+    }
+
+    if(received_frame) break;
+    if(clock.getSeconds() > deadline) {
+      // carry on with the local clock rather than freeze, the master's
+      // time is ours plus the offset, so it advances by the whole frame
+      if(connected) {
+        frame_stats.timeouts++;
+        time = std::max(time, clock.getSeconds() + offset);
+      }
+      break;
+    }
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+  }
+  frame_stats.mean_wait_ms += ((clock.getSeconds() - start) * 1000.0 - frame_stats.mean_wait_ms) / (frame_stats.frames + 1);
+  if(received_frame) frame_stats.frames++;
+}
+
+/**
+ * Messages run in the frame they are due, in the order they were
+ * sent, late ones on a node as soon as they arrive
+ */
+void cluster_sync::run_due_messages() {
+  std::vector<message> due;
+  for(auto it = messages.begin(); it != messages.end();) {
+    bool ready = master ? it->frame == frame : it->frame <= frame;
+    if(ready) due.push_back(*it);
+    if(ready && !master) {
+      received.insert(it->id);
+      it = messages.erase(it);
+    } else {
+      ++it;
+    }
+  }
+
+  std::sort(due.begin(), due.end(), [](const message & a, const message & b) { return a.id < b.id; });
+  for(auto & m : due) {
+    auto handler = handlers.find(m.topic);
+    if(handler != handlers.end() && handler->second) handler->second(m.payload);
+    else CI_LOG_W("No handler for " << m.topic);
+  }
+}
+
+/**
+ * Skew is the spread between the first and last machine to
+ * finish drawing the frame, nodes report their finish on the
+ * master's clock
+ */
+void cluster_sync::record_skew() {
+  if(acks.empty()) return;
+  double first = finished;
+  double last = finished;
+  for(auto & ack : acks) {
+    first = std::min(first, ack.second);
+    last = std::max(last, ack.second);
+  }
+  double skew = (last - first) * 1000.0;
+  frame_stats.last_skew_ms = skew;
+  frame_stats.max_skew_ms = std::max(frame_stats.max_skew_ms, skew);
+  frame_stats.mean_skew_ms += (skew - frame_stats.mean_skew_ms) / (frame_stats.frames + 1);
+}
@@ -0,0 +1,168 @@
+#pragma once
+
+// std
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+// cinder
+#include "cinder/Timeline.h"
+#include "cinder/Timer.h"
+
+/////////////////////////////////////////////////
+//
+//  cluster_sync
+//  Keeps render nodes driving one wall in step
+//  with a master over UDP
+//
+//  Every frame the master broadcasts the frame
+//  number, its clock and any messages, the nodes
+//  wait for it, step a shared sprite timeline to
+//  the master's time and run the messages due that
+//  frame, so tweens started by a message start at
+//  the same time everywhere. Nodes acknowledge each
+//  frame once drawn and the master holds the next
+//  one until all of them have, keeping their swaps
+//  within a frame of each other
+//
+//  Messages must fit in a datagram, send names or
+//  seeds (ie. a scene path) rather than content
+//
+/////////////////////////////////////////////////
+class cluster_sync {
+public:
+  //////////////////////////////////////////////////////
+  // static
+  //////////////////////////////////////////////////////
+  typedef std::shared_ptr<cluster_sync> cluster_sync_ref;
+
+  // runs a message on every machine, in the frame it is due
+  typedef std::function<void(const std::string & payload)> message_fn;
+
+  class stats {
+  public:
+    uint64_t frames;
+    uint64_t timeouts;        // frames that went ahead without every node
+    double mean_skew_ms;      // spread of the machines' frame completions, on the master
+    double max_skew_ms;
+    double last_skew_ms;
+    double mean_wait_ms;      // time spent blocked on the other side
+  };
+
+  // the master, expects node_count nodes to join on port
+  static cluster_sync_ref create_master(uint16_t port, int node_count);
+
+  // a render node, ids start from 1
+  static cluster_sync_ref create_node(const std::string & master_host, uint16_t port, int node_id);
+
+  //////////////////////////////////////////////////////
+  // ctr(s) / dctr(s)
+  //////////////////////////////////////////////////////
+  cluster_sync(bool master, const std::string & host, uint16_t port, int node_id, int node_count);
+
+  ~cluster_sync();
+
+  //////////////////////////////////////////////////////
+  // getters
+  //////////////////////////////////////////////////////
+  bool is_master();
+
+  // 0 for the master
+  int get_node_id();
+
+  // nodes that have joined, on the master
+  int get_node_count();
+
+  // all nodes joined on the master, a frame received on a node
+  bool is_connected();
+
+  uint64_t get_frame();
+
+  // the master's clock in seconds, the same on every node for a frame
+  double get_time();
+
+  // the sprites' default timeline while the cluster exists
+  ci::TimelineRef get_timeline();
+
+  stats get_stats();
+
+  //////////////////////////////////////////////////////
+  // setters
+  //////////////////////////////////////////////////////
+  // how long either side waits for the other before going ahead
+  void set_timeout(double ms);
+
+  //////////////////////////////////////////////////////
+  // methods
+  //////////////////////////////////////////////////////
+  void on(const std::string & topic, message_fn fn);
+
+  // master only, runs everywhere delay frames from now
+  void send(const std::string & topic, const std::string & payload, int delay = 1);
+
+  // call first in update(), then pace providers on get_time(),
+  // ie. provider_scheduler::update(get_time())
+  void begin_frame();
+
+  // call last in draw(), before the swap
+  void end_frame();
+
+  void reset_stats();
+
+protected:
+  //////////////////////////////////////////////////////
+  // types
+  //////////////////////////////////////////////////////
+  class message {
+  public:
+    uint64_t id;
+    uint64_t frame;
+    std::string topic;
+    std::string payload;
+  };
+
+  class transport;
+
+  //////////////////////////////////////////////////////
+  // properties
+  //////////////////////////////////////////////////////
+  bool master;
+  int node_id;
+  int node_count;
+  bool connected;
+  uint64_t frame;
+  double time;
+  double timeout_ms;
+  uint64_t next_message;
+  ci::Timer clock;
+  ci::TimelineRef timeline;
+  ci::TimelineRef previous_timeline;  // the default timeline before this one, restored when done
+  std::unique_ptr<transport> net;
+  std::map<std::string, message_fn> handlers;
+  std::vector<message> messages;    // on the master those being resent, on nodes those not yet due
+  std::set<uint64_t> received;
+  std::map<int, double> acks;       // node, when it finished the frame on the master's clock
+  double finished;
+  double offset;                    // the master's clock less ours, on nodes
+  stats frame_stats;
+
+  //////////////////////////////////////////////////////
+  // methods
+  //////////////////////////////////////////////////////
+  void begin_master_frame();
+
+  void begin_node_frame();
+
+  void run_due_messages();
+
+  void record_skew();
+};
+
+//////////////////////////////////////////////////////
+// typedefs
+//////////////////////////////////////////////////////
+typedef cluster_sync::cluster_sync_ref cluster_sync_ref;
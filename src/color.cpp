@@ -0,0 +1,156 @@
+// std
+#include <algorithm>
+#include <cmath>
+
+// sfmoma
+#include "color.h"
+
+using namespace ci;
+
+namespace {
+  bool linear_blending = false;
+  pixel_format hdr_format = pixel_format::RGBA8;
+
+  uint8_t to_byte(float c) {
+    return (uint8_t)std::lround(glm::clamp(c, 0.0f, 1.0f) * 255.0f);
+  }
+}
+
+/////////////////////////////////////////////////
+//
+//  color_policy
+//
+/////////////////////////////////////////////////
+bool color_policy::is_linear_blending() {
+  return linear_blending;
+}
+
+pixel_format color_policy::get_hdr_format() {
+  return hdr_format;
+}
+
+pixel_format color_policy::select(const content & c) {
+  pixel_format eight_bit = linear_blending ? pixel_format::SRGB8_A8 : pixel_format::RGBA8;
+  if(c.bits <= 8 && !c.extended_range) return eight_bit;
+
+  switch(hdr_format) {
+    case pixel_format::RGB10_A2:
+      return pixel_format::RGB10_A2;
+    case pixel_format::RGBA16F:
+      // same bandwidth as 8 bit when the range and alpha allow it
+      if(!c.extended_range && !c.alpha && c.bits <= 10) return pixel_format::RGB10_A2;
+      return pixel_format::RGBA16F;
+    default:
+      return eight_bit;
+  }
+}
+
+GLint color_policy::get_internal_format(pixel_format format) {
+  switch(format) {
+    case pixel_format::SRGB8_A8: return GL_SRGB8_ALPHA8;
+    case pixel_format::RGB10_A2: return GL_RGB10_A2;
+    case pixel_format::RGBA16F: return GL_RGBA16F;
+    default: return GL_RGBA8;
+  }
+}
+
+pixel_format color_policy::get_format(GLint internal_format) {
+  switch(internal_format) {
+    case GL_SRGB8:
+    case GL_SRGB8_ALPHA8: return pixel_format::SRGB8_A8;
+    case GL_RGB10_A2: return pixel_format::RGB10_A2;
+    case GL_RGB16F:
+    case GL_RGBA16F: return pixel_format::RGBA16F;
+    default: return pixel_format::RGBA8;
+  }
+}
+
+bool color_policy::is_srgb(pixel_format format) {
+  return format == pixel_format::SRGB8_A8;
+}
+
+gl::Texture::Format color_policy::get_texture_format(const content & c) {
+  return gl::Texture::Format().internalFormat(get_internal_format(select(c)));
+}
+
+gl::Fbo::Format color_policy::get_fbo_format(pixel_format format) {
+  return gl::Fbo::Format().disableDepth().colorTexture(
+    gl::Texture::Format().internalFormat(get_internal_format(format)));
+}
+
+void color_policy::set_linear_blending(bool linear) {
+#if defined( CINDER_GL_ES )
+  // no sRGB framebuffer control to encode what is written
+  linear = false;
+#endif
+  linear_blending = linear;
+}
+
+void color_policy::set_hdr_format(pixel_format format) {
+  hdr_format = format;
+}
+
+/////////////////////////////////////////////////
+//
+//  blend_reference
+//
+/////////////////////////////////////////////////
+float blend_reference::srgb_to_linear(float c) {
+  return c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+}
+
+float blend_reference::linear_to_srgb(float c) {
+  return c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f;
+}
+
+/**
+ * Sprites premultiply as they draw and blend with one, one minus source
+ * alpha, so color is src * a + dst * (1 - a) and alpha a + dst.a * (1 - a)
+ */
+ColorA blend_reference::over(const ColorA & src, const ColorA & dst, float alpha, bool linear) {
+  float a = src.a * alpha;
+  Color s(src.r, src.g, src.b);
+  Color d(dst.r, dst.g, dst.b);
+  if(linear) {
+    s = Color(srgb_to_linear(s.r), srgb_to_linear(s.g), srgb_to_linear(s.b));
+    d = Color(srgb_to_linear(d.r), srgb_to_linear(d.g), srgb_to_linear(d.b));
+  }
+  Color out = s * a + d * (1.0f - a);
+  if(linear) out = Color(linear_to_srgb(out.r), linear_to_srgb(out.g), linear_to_srgb(out.b));
+  return ColorA(out, a + dst.a * (1.0f - a));
+}
+
+Surface8u blend_reference::composite(const Surface8u & dst, const Surface8u & src, ivec2 offset, float alpha, bool linear) {
+  Surface8u result(dst.getWidth(), dst.getHeight(), true, SurfaceChannelOrder::RGBA);
+  result.copyFrom(dst, dst.getBounds());
+
+  Area area = Area(offset, offset + src.getSize()).getClipBy(result.getBounds());
+  for(int y = area.y1; y < area.y2; y++) {
+    for(int x = area.x1; x < area.x2; x++) {
+      ColorA s = ColorA(src.getPixel(ivec2(x, y) - offset));
+      ColorA d = ColorA(result.getPixel(ivec2(x, y)));
+      ColorA out = over(s, d, alpha, linear);
+      result.setPixel(ivec2(x, y), ColorA8u(to_byte(out.r), to_byte(out.g), to_byte(out.b), to_byte(out.a)));
+    }
+  }
+  return result;
+}
+
+vec2 blend_reference::compare(const Surface8u & a, const Surface8u & b) {
+  ivec2 size = glm::min(a.getSize(), b.getSize());
+  float largest = 0.0f;
+  double total = 0.0;
+  for(int y = 0; y < size.y; y++) {
+    for(int x = 0; x < size.x; x++) {
+      ColorA8u p = a.getPixel(ivec2(x, y));
+      ColorA8u q = b.getPixel(ivec2(x, y));
+      const int diffs[] = { std::abs(p.r - q.r), std::abs(p.g - q.g), std::abs(p.b - q.b), std::abs(p.a - q.a) };
+      for(int d : diffs) {
+        largest = std::max(largest, (float)d);
+        total += d;
+      }
+    }
+  }
+  double channels = std::max(1.0, (double)size.x * size.y * 4);
+  return vec2(largest, (float)(total / channels));
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+// cinder
+#include "cinder/Color.h"
+#include "cinder/Surface.h"
+#include "cinder/gl/Fbo.h"
+#include "cinder/gl/Texture.h"
+
+enum class pixel_format {
+  RGBA8,      // 8 bit, blended as stored
+  SRGB8_A8,   // 8 bit sRGB, filtered and blended in linear light
+  RGB10_A2,   // 10 bit linear 0..1, 2 bit alpha, the size of RGBA8
+  RGBA16F     // half float, for values outside 0..1, twice the size
+};
+
+/////////////////////////////////////////////////
+//
+//  color_policy
+//  The formats textures are uploaded in and
+//  sprites composite into
+//
+//  With linear blending 8 bit content is stored
+//  as sRGB, so sampling and blending happen on
+//  linear values at no extra bandwidth; the app's
+//  window then needs an sRGB capable framebuffer.
+//  Deeper content only gets a deeper format when
+//  one is allowed, and then the narrowest that
+//  holds it
+//
+/////////////////////////////////////////////////
+class color_policy {
+public:
+  // what a provider's pixels need
+  class content {
+  public:
+    content(int bits = 8, bool alpha = true, bool extended_range = false)
+      : bits(bits), alpha(alpha), extended_range(extended_range) {}
+
+    int bits;             // per channel
+    bool alpha;           // needs more than RGB10_A2's two bits of alpha
+    bool extended_range;  // values outside 0..1, ie. scene referred hdr
+  };
+
+  //////////////////////////////////////////////////////
+  // getters
+  //////////////////////////////////////////////////////
+  static bool is_linear_blending();
+
+  // the deepest format high precision content may use
+  static pixel_format get_hdr_format();
+
+  // the narrowest format allowed that holds content
+  static pixel_format select(const content & c = content());
+
+  static GLint get_internal_format(pixel_format format);
+
+  // the format of an existing texture, RGBA8 for ones the policy does not choose
+  static pixel_format get_format(GLint internal_format);
+
+  static bool is_srgb(pixel_format format);
+
+  static ci::gl::Texture::Format get_texture_format(const content & c = content());
+
+  // single sampled without depth, what sprites composite content of format into
+  static ci::gl::Fbo::Format get_fbo_format(pixel_format format);
+
+  //////////////////////////////////////////////////////
+  // setters
+  //////////////////////////////////////////////////////
+  // off by default, set before creating providers
+  static void set_linear_blending(bool linear);
+
+  // RGBA8 (the default) keeps everything at 8 bits, RGB10_A2 or RGBA16F opt in
+  static void set_hdr_format(pixel_format format);
+};
+
+/////////////////////////////////////////////////
+//
+//  blend_reference
+//  The sprite pipeline's blend on the cpu, to
+//  check what the gpu produced against
+//
+/////////////////////////////////////////////////
+class blend_reference {
+public:
+  static float srgb_to_linear(float c);
+
+  static float linear_to_srgb(float c);
+
+  // src over dst with alpha as a sprite draws it, in linear light
+  // when linear, otherwise on the stored values
+  static ci::ColorA over(const ci::ColorA & src, const ci::ColorA & dst, float alpha, bool linear);
+
+  // src drawn over dst at offset with alpha, rounded as an 8 bit target would
+  static ci::Surface8u composite(
+    const ci::Surface8u & dst,
+    const ci::Surface8u & src,
+    ci::ivec2 offset,
+    float alpha,
+    bool linear);
+
+  // the largest and mean channel difference in 8 bit steps
+  static ci::vec2 compare(const ci::Surface8u & a, const ci::Surface8u & b);
+};
@@ -0,0 +1,38 @@
+// sfmoma
+#include "context.h"
+
+using namespace ci;
+
+namespace {
+  gl::ContextRef shared;
+}
+
+//////////////////////////////////////////////////////
+// getters
+//////////////////////////////////////////////////////
+gl::ContextRef resource_context::get() {
+  return shared;
+}
+
+//////////////////////////////////////////////////////
+// setters
+//////////////////////////////////////////////////////
+void resource_context::set(const gl::ContextRef & context) {
+  shared = context;
+}
+
+//////////////////////////////////////////////////////
+// scope
+//////////////////////////////////////////////////////
+resource_context::scope::scope() {
+  previous = nullptr;
+  if(!shared) return;
+  gl::Context * current = gl::Context::getCurrent();
+  if(current == shared.get()) return;
+  previous = current;
+  shared->makeCurrent();
+}
+
+resource_context::scope::~scope() {
+  if(previous) previous->makeCurrent();
+}
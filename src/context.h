@@ -0,0 +1,50 @@
+#pragma once
+
+// cinder
+#include "cinder/gl/Context.h"
+
+/////////////////////////////////////////////////
+//
+//  resource_context
+//  The gl context providers render and sprites
+//  composite in when several windows share
+//  resources, ie. the primary window's
+//
+//  Textures, buffers and shaders are shared by
+//  every context in the share group, but fbos and
+//  vaos belong to the context that created them,
+//  so all fbo work is done in this one context and
+//  every window samples the resulting textures.
+//  Sprites composite in whichever context is
+//  current, display_wall delivers their updates
+//  here once per frame
+//
+/////////////////////////////////////////////////
+class resource_context {
+public:
+  //////////////////////////////////////////////////////
+  // getters
+  //////////////////////////////////////////////////////
+  // null when not set, work then happens in whichever context is current
+  static ci::gl::ContextRef get();
+
+  //////////////////////////////////////////////////////
+  // setters
+  //////////////////////////////////////////////////////
+  static void set(const ci::gl::ContextRef & context);
+
+  //////////////////////////////////////////////////////
+  // scope
+  //////////////////////////////////////////////////////
+  // makes the resource context current for its lifetime, nothing
+  // to do with a single window or when it is current already
+  class scope {
+  public:
+    scope();
+
+    ~scope();
+
+  protected:
+    ci::gl::Context * previous;
+  };
+};
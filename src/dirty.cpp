@@ -0,0 +1,165 @@
+// std
+#include <algorithm>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+// sfmoma
+#include "dirty.h"
+
+using namespace ci;
+
+namespace {
+  std::mutex mutex;
+  bool enabled = false;
+  int buffer_count = 2;
+
+  // damage since the last frame, and that of the frames a back buffer missed
+  Rectf pending;
+  bool has_pending = false;
+  std::deque<std::pair<Rectf, bool>> history;
+
+  ivec2 canvas(0);
+  Area frame_damage;
+  dirty_tracker::stats tracker_stats = { 0, 0, 0.0, 0.0 };
+  std::vector<std::function<void()>> frame_hooks;
+
+  void add_damage(const Rectf & area) {
+    if(area.getWidth() <= 0.0f || area.getHeight() <= 0.0f) return;
+    if(has_pending) {
+      pending.include(area);
+    } else {
+      pending = area;
+      has_pending = true;
+    }
+  }
+
+  void add_all() {
+    add_damage(Rectf(-1e9f, -1e9f, 1e9f, 1e9f));
+  }
+}
+
+//////////////////////////////////////////////////////
+// getters
+//////////////////////////////////////////////////////
+bool dirty_tracker::is_enabled() {
+  return enabled;
+}
+
+dirty_tracker::stats dirty_tracker::get_stats() {
+  std::lock_guard<std::mutex> lock(mutex);
+  return tracker_stats;
+}
+
+double dirty_tracker::get_skipped_fraction() {
+  std::lock_guard<std::mutex> lock(mutex);
+  return tracker_stats.frames ? (double)tracker_stats.skipped / tracker_stats.frames : 0.0;
+}
+
+double dirty_tracker::get_damaged_fraction() {
+  std::lock_guard<std::mutex> lock(mutex);
+  return tracker_stats.canvas_pixels > 0.0 ? tracker_stats.damaged_pixels / tracker_stats.canvas_pixels : 0.0;
+}
+
+Area dirty_tracker::get_frame_damage() {
+  std::lock_guard<std::mutex> lock(mutex);
+  return frame_damage;
+}
+
+//////////////////////////////////////////////////////
+// setters
+//////////////////////////////////////////////////////
+void dirty_tracker::set_enabled(bool enable) {
+  std::lock_guard<std::mutex> lock(mutex);
+  if(enable && !enabled) add_all();
+  enabled = enable;
+}
+
+void dirty_tracker::set_buffer_count(int count) {
+  std::lock_guard<std::mutex> lock(mutex);
+  buffer_count = std::max(count, 1);
+  add_all();
+}
+
+//////////////////////////////////////////////////////
+// methods
+//////////////////////////////////////////////////////
+void dirty_tracker::damage(const Rectf & area) {
+  std::lock_guard<std::mutex> lock(mutex);
+  if(enabled) add_damage(area);
+}
+
+void dirty_tracker::damage_all() {
+  std::lock_guard<std::mutex> lock(mutex);
+  add_all();
+}
+
+void dirty_tracker::add_frame_hook(std::function<void()> hook) {
+  frame_hooks.push_back(hook);
+}
+
+/**
+ * The frame's damage is what changed since the last frame, plus what
+ * changed in the frames since this frame's back buffer was last drawn
+ */
+bool dirty_tracker::begin_frame(ivec2 canvas_size) {
+  // hooks report damage, so they run before the lock is taken
+  if(enabled) {
+    for(auto & hook : frame_hooks) hook();
+  }
+
+  std::lock_guard<std::mutex> lock(mutex);
+  Area bounds(ivec2(0), canvas_size);
+  if(!enabled || canvas_size != canvas) add_all();
+  canvas = canvas_size;
+
+  Rectf area = pending;
+  bool has_area = has_pending;
+  for(auto & previous : history) {
+    if(!previous.second) continue;
+    if(has_area) area.include(previous.first);
+    else area = previous.first;
+    has_area = true;
+  }
+
+  history.push_back({ pending, has_pending });
+  while((int)history.size() > buffer_count - 1) history.pop_front();
+  has_pending = false;
+
+  // whole pixels covering the damage
+  frame_damage = has_area
+    ? Area(ivec2(glm::floor(area.getUpperLeft())), ivec2(glm::ceil(area.getLowerRight()))).getClipBy(bounds)
+    : Area(0, 0, 0, 0);
+  bool draw = frame_damage.getWidth() > 0 && frame_damage.getHeight() > 0;
+  if(!draw) frame_damage = Area(0, 0, 0, 0);
+
+  tracker_stats.frames++;
+  if(!draw) tracker_stats.skipped++;
+  tracker_stats.damaged_pixels += (double)frame_damage.calcArea();
+  tracker_stats.canvas_pixels += (double)bounds.calcArea();
+  return draw;
+}
+
+void dirty_tracker::reset_stats() {
+  std::lock_guard<std::mutex> lock(mutex);
+  tracker_stats = { 0, 0, 0.0, 0.0 };
+}
+
+/////////////////////////////////////////////////
+//
+//  dirty_tracker::scoped_damage
+//
+/////////////////////////////////////////////////
+dirty_tracker::scoped_damage::scoped_damage(ivec2 target_size)
+  : area(get_scissor(target_size)), scissor(area.getUL(), area.getSize()) {
+}
+
+Area dirty_tracker::scoped_damage::get_scissor(ivec2 target_size) {
+  std::lock_guard<std::mutex> lock(mutex);
+  vec2 scale = canvas.x > 0 && canvas.y > 0 ? vec2(target_size) / vec2(canvas) : vec2(1.0f);
+  ivec2 ul = ivec2(glm::floor(vec2(frame_damage.getUL()) * scale));
+  ivec2 lr = ivec2(glm::ceil(vec2(frame_damage.getLR()) * scale));
+
+  // scissor boxes are bottom-left origin
+  return Area(ul.x, target_size.y - lr.y, lr.x, target_size.y - ul.y);
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+// std
+#include <cstdint>
+#include <functional>
+
+// cinder
+#include "cinder/Area.h"
+#include "cinder/Rect.h"
+#include "cinder/gl/scoped.h"
+
+/////////////////////////////////////////////////
+//
+//  dirty_tracker
+//  What changed on screen since the last frame,
+//  so a scene where nothing moves is not drawn
+//  again, and one where little moves is only
+//  drawn where it did
+//
+//  Sprites report damage from their setters and
+//  provider updates, and what their tweens changed
+//  as each frame begins, in the coordinates they
+//  are positioned in. Each frame begin_frame
+//  says whether there is anything to draw and
+//  scoped_damage scissors drawing to it
+//
+//  A back buffer is reused every buffer_count
+//  frames, so a frame redraws the damage of the
+//  frames since, this relies on the swap keeping
+//  back buffer contents; draw into an fbo, ie. an
+//  offscreen display_view, where it does not
+//
+/////////////////////////////////////////////////
+class dirty_tracker {
+public:
+  class stats {
+  public:
+    uint64_t frames;        // begin_frame calls
+    uint64_t skipped;       // of those, frames with nothing to draw
+    double damaged_pixels;  // canvas area redrawn, over all frames
+    double canvas_pixels;   // canvas area, over all frames
+  };
+
+  //////////////////////////////////////////////////////
+  // getters
+  //////////////////////////////////////////////////////
+  static bool is_enabled();
+
+  static stats get_stats();
+
+  static double get_skipped_fraction();
+
+  // the mean fraction of the canvas redrawn per frame, skipped frames included
+  static double get_damaged_fraction();
+
+  // the area to redraw this frame, set by begin_frame, top-left origin
+  static ci::Area get_frame_damage();
+
+  //////////////////////////////////////////////////////
+  // setters
+  //////////////////////////////////////////////////////
+  // off by default, sprites only report damage while on, turning it on damages everything
+  static void set_enabled(bool enabled);
+
+  // the frames a back buffer lasts before it is drawn into again, 2 for double buffering
+  static void set_buffer_count(int count);
+
+  //////////////////////////////////////////////////////
+  // methods
+  //////////////////////////////////////////////////////
+  static void damage(const ci::Rectf & area);
+
+  // ie. when something not tracked, like a background, changes
+  static void damage_all();
+
+  // called by begin_frame before it closes the damage, ie. to report what tweens changed
+  static void add_frame_hook(std::function<void()> hook);
+
+  // close the damage gathered since the last frame, false when there is nothing
+  // to draw; always true while disabled, with the whole canvas damaged
+  static bool begin_frame(ci::ivec2 canvas_size);
+
+  static void reset_stats();
+
+  /////////////////////////////////////////////////
+  //  scissors to the frame's damage while in
+  //  scope, target_size is the framebuffer's size
+  //  in pixels, for high density displays
+  /////////////////////////////////////////////////
+  class scoped_damage {
+  public:
+    scoped_damage(ci::ivec2 target_size);
+
+  protected:
+    ci::Area area;  // bottom-left origin, in pixels
+    ci::gl::ScopedScissor scissor;
+
+    static ci::Area get_scissor(ci::ivec2 target_size);
+  };
+};
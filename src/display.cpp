@@ -0,0 +1,291 @@
+// std
+#include <algorithm>
+
+// cinder
+#include "cinder/gl/gl.h"
+
+// sfmoma
+#include "context.h"
+#include "dirty.h"
+#include "display.h"
+#include "jobs.h"
+#include "memory.h"
+#include "profiler.h"
+#include "scheduler.h"
+
+using namespace ci;
+using namespace ci::app;
+
+/////////////////////////////////////////////////
+//
+//  display_view
+//
+/////////////////////////////////////////////////
+display_view_ref display_view::create(WindowRef window, Rectf canvas_area) {
+  return std::make_shared<display_view>(window, window ? window->getSize() : ivec2(0), canvas_area);
+}
+
+display_view_ref display_view::create(ivec2 size, Rectf canvas_area) {
+  return std::make_shared<display_view>(nullptr, size, canvas_area);
+}
+
+display_view_ref display_view::create(gl::ContextRef context, ivec2 size, Rectf canvas_area) {
+  return std::make_shared<display_view>(nullptr, size, canvas_area, context);
+}
+
+display_view::display_view(WindowRef view_window, ivec2 view_size, Rectf area, gl::ContextRef view_context) {
+  window = view_window;
+  context = window ? nullptr : view_context;
+  size = glm::max(view_size, ivec2(1));
+  canvas_area = area;
+  drawn = 0;
+  culled = 0;
+
+  if(!window) {
+    // what sprites composite into, so blending matches theirs
+    auto create_fbo = [this] {
+      gl::Fbo::Format format = sprite::get_fbo_format();
+      gpu_memory::reserve(gpu_memory::get_fbo_bytes(size, format));
+      fbo = gl::Fbo::create(size.x, size.y, format);
+      gpu_memory::track(fbo, "display_view");
+    };
+
+    // made in the context the view draws in, the only one the fbo is valid in
+    if(context) {
+      gl::Context * previous = gl::Context::getCurrent();
+      context->makeCurrent();
+      create_fbo();
+      if(previous) previous->makeCurrent();
+    } else {
+      resource_context::scope scoped_context;
+      create_fbo();
+    }
+  }
+}
+
+Rectf display_view::get_canvas_area() {
+  return canvas_area;
+}
+
+ivec2 display_view::get_size() {
+  return window ? window->getSize() : size;
+}
+
+WindowRef display_view::get_window() {
+  return window;
+}
+
+bool display_view::is_offscreen() {
+  return !window;
+}
+
+gl::TextureRef display_view::get_texture() {
+  return fbo ? fbo->getColorTexture() : nullptr;
+}
+
+size_t display_view::get_drawn() {
+  return drawn;
+}
+
+size_t display_view::get_culled() {
+  return culled;
+}
+
+void display_view::set_canvas_area(Rectf area) {
+  canvas_area = area;
+}
+
+/////////////////////////////////////////////////
+//
+//  display_wall
+//
+/////////////////////////////////////////////////
+display_wall_ref display_wall::create() {
+  return std::make_shared<display_wall>();
+}
+
+display_wall::display_wall() {
+  resources_ready = nullptr;
+  if(!resource_context::get()) resource_context::set(gl::context()->shared_from_this());
+}
+
+display_wall::~display_wall() {
+#if ! defined( CINDER_GL_ES_2 )
+  if(resources_ready) glDeleteSync(resources_ready);
+#endif
+}
+
+const std::vector<display_view_ref> & display_wall::get_views() {
+  return views;
+}
+
+size_t display_wall::size() {
+  return sprites.size();
+}
+
+void display_wall::add_view(const display_view_ref & view) {
+  views.push_back(view);
+}
+
+void display_wall::remove_view(const display_view_ref & view) {
+  views.erase(std::remove(views.begin(), views.end(), view), views.end());
+}
+
+void display_wall::add(const sprite_ref & sp) {
+  sprites.push_back(sp);
+  if(dirty_tracker::is_enabled()) dirty_tracker::damage(sp->get_bounds());
+}
+
+void display_wall::add(const sprite_batch_ref & batch) {
+  sprite_batches.push_back(batch);
+  dirty_tracker::damage_all();
+}
+
+void display_wall::add(const text_batch_ref & batch) {
+  text_batches.push_back(batch);
+  dirty_tracker::damage_all();
+}
+
+void display_wall::remove(const sprite_ref & sp) {
+  sprites.erase(std::remove(sprites.begin(), sprites.end(), sp), sprites.end());
+  if(dirty_tracker::is_enabled()) dirty_tracker::damage(sp->get_bounds());
+}
+
+void display_wall::clear() {
+  sprites.clear();
+  sprite_batches.clear();
+  text_batches.clear();
+  dirty_tracker::damage_all();
+}
+
+/**
+ * Graphics providers render, video frames upload and sprites
+ * composite here, once, however many views show them
+ */
+void display_wall::update() {
+  SPRITE_PROFILE_SCOPE("display_wall::update");
+  resource_context::scope scoped_context;
+  provider_scheduler::update();
+  if(upload_scheduler::is_enabled()) upload_scheduler::process();
+  deliver();
+}
+
+void display_wall::update(double now) {
+  SPRITE_PROFILE_SCOPE("display_wall::update");
+  resource_context::scope scoped_context;
+  provider_scheduler::update(now);
+  if(upload_scheduler::is_enabled()) upload_scheduler::process();
+  deliver();
+}
+
+void display_wall::draw(const display_view_ref & view) {
+  if(!view) return;
+  SPRITE_PROFILE_SCOPE("display_wall::draw");
+  auto draw_fbo = [&] {
+    gl::ScopedFramebuffer scoped_fbo(view->fbo);
+    gl::ScopedViewport scoped_viewport(ivec2(0), view->size);
+    gl::clear(ColorA(0, 0, 0, 0));
+    draw_canvas(*view);
+  };
+
+  if(view->context) {
+    gl::Context * previous = gl::Context::getCurrent();
+    view->context->makeCurrent();
+    draw_fbo();
+    // the view's texture is sampled from other contexts
+    glFlush();
+    if(previous) previous->makeCurrent();
+  } else if(view->is_offscreen()) {
+    resource_context::scope scoped_context;
+    draw_fbo();
+  } else {
+    draw_canvas(*view);
+  }
+}
+
+void display_wall::draw_offscreen() {
+  for(auto & view : views) {
+    if(view->is_offscreen()) draw(view);
+  }
+}
+
+/**
+ * Map the view's area of the canvas onto the view and draw
+ * what intersects it
+ */
+void display_wall::draw_canvas(display_view & view) {
+  Rectf area = view.canvas_area;
+  if(area.getWidth() <= 0 || area.getHeight() <= 0) return;
+  vec2 size = view.get_size();
+
+  gl::ScopedMatrices scoped_matrices;
+  gl::setMatricesWindow(ivec2(size));
+  gl::scale(size / area.getSize());
+  gl::translate(-area.getUpperLeft());
+
+  // normally delivered by update(), changes since are delivered the same way,
+  // deliveries can render so they stay on this thread, then culling only reads the sprites
+  bool pending = std::any_of(sprites.begin(), sprites.end(), [](const sprite_ref & sp) {
+    return sp->provider && sp->provider->has_pending_updates();
+  });
+  if(pending) deliver();
+  wait_for_resources();
+
+  in_view.resize(sprites.size());
+  job_system::parallel_for(sprites.size(), 4096, [&](size_t begin, size_t end) {
+    for(size_t i = begin; i < end; i++) {
+      in_view[i] = area.intersects(sprites[i]->get_frame_bounds(sprites[i]->texture_size)) ? 1 : 0;
+    }
+  });
+
+  view.drawn = 0;
+  view.culled = 0;
+  for(size_t i = 0; i < sprites.size(); i++) {
+    if(!in_view[i]) {
+      view.culled++;
+      continue;
+    }
+    sprites[i]->draw();
+    view.drawn++;
+  }
+  for(auto & batch : sprite_batches) {
+    batch->draw(area);
+    view.drawn += batch->get_drawn();
+  }
+  for(auto & batch : text_batches) {
+    batch->draw();
+  }
+}
+
+/**
+ * Sprite fbos are only valid in the resource context, so queued
+ * updates are composited there with one switch for all of them
+ * rather than one per sprite, then fenced and flushed so the
+ * other contexts can wait for the result
+ */
+void display_wall::deliver() {
+  SPRITE_PROFILE_SCOPE("display_wall::deliver");
+  resource_context::scope scoped_context;
+  for(auto & sp : sprites) {
+    if(sp->provider) sp->provider->deliver_updates();
+  }
+
+#if ! defined( CINDER_GL_ES_2 )
+  if(resources_ready) glDeleteSync(resources_ready);
+  resources_ready = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+#endif
+  glFlush();
+}
+
+/**
+ * A context sharing the resource context's textures has to wait
+ * on the gpu for the last frame's work before sampling them,
+ * the resource context itself sees its own work in order
+ */
+void display_wall::wait_for_resources() {
+#if ! defined( CINDER_GL_ES_2 )
+  if(resources_ready && gl::Context::getCurrent() != resource_context::get().get()) {
+    glWaitSync(resources_ready, 0, GL_TIMEOUT_IGNORED);
+  }
+#endif
+}
@@ -0,0 +1,185 @@
+#pragma once
+
+// std
+#include <cstdint>
+#include <vector>
+
+// cinder
+#include "cinder/app/Window.h"
+#include "cinder/gl/Context.h"
+#include "cinder/gl/Fbo.h"
+
+// sfmoma
+#include "batch.h"
+#include "sprite.h"
+#include "text.h"
+
+/////////////////////////////////////////////////
+//
+//  display_view
+//  A window or offscreen surface showing one area
+//  of a wall's canvas, ie. one output of a video
+//  wall driven from a single machine
+//
+/////////////////////////////////////////////////
+class display_view {
+  friend class display_wall;
+
+public:
+  //////////////////////////////////////////////////////
+  // static
+  //////////////////////////////////////////////////////
+  typedef std::shared_ptr<display_view> display_view_ref;
+
+  // a window showing canvas_area, drawn from the window's draw()
+  static display_view_ref create(ci::app::WindowRef window, ci::Rectf canvas_area);
+
+  // an offscreen surface of size showing canvas_area
+  static display_view_ref create(ci::ivec2 size, ci::Rectf canvas_area);
+
+  // the same drawn in context, one sharing the resource context's objects,
+  // ie. a context of its own per output
+  static display_view_ref create(ci::gl::ContextRef context, ci::ivec2 size, ci::Rectf canvas_area);
+
+  //////////////////////////////////////////////////////
+  // ctr(s) / dctr(s)
+  //////////////////////////////////////////////////////
+  display_view(ci::app::WindowRef window, ci::ivec2 size, ci::Rectf canvas_area, ci::gl::ContextRef context = nullptr);
+
+  //////////////////////////////////////////////////////
+  // getters
+  //////////////////////////////////////////////////////
+  ci::Rectf get_canvas_area();
+
+  ci::ivec2 get_size();
+
+  ci::app::WindowRef get_window();
+
+  bool is_offscreen();
+
+  // the offscreen surface, null for windows
+  ci::gl::TextureRef get_texture();
+
+  // sprites drawn and culled by the last draw
+  size_t get_drawn();
+
+  size_t get_culled();
+
+  //////////////////////////////////////////////////////
+  // setters
+  //////////////////////////////////////////////////////
+  void set_canvas_area(ci::Rectf canvas_area);
+
+protected:
+  //////////////////////////////////////////////////////
+  // properties
+  //////////////////////////////////////////////////////
+  ci::app::WindowRef window;
+  ci::gl::ContextRef context;  // the context an offscreen view draws in, null for the resource context
+  ci::gl::FboRef fbo;
+  ci::ivec2 size;
+  ci::Rectf canvas_area;
+  size_t drawn;
+  size_t culled;
+};
+
+//////////////////////////////////////////////////////
+// typedefs
+//////////////////////////////////////////////////////
+typedef display_view::display_view_ref display_view_ref;
+
+/////////////////////////////////////////////////
+//
+//  display_wall
+//  Sprites on one canvas shown by several views
+//
+//  Providers are updated and sprites composite
+//  their updates once per frame in the resource
+//  context, then every view samples the same
+//  textures, each view only draws the sprites
+//  that intersect its area of the canvas
+//
+/////////////////////////////////////////////////
+class display_wall {
+public:
+  //////////////////////////////////////////////////////
+  // static
+  //////////////////////////////////////////////////////
+  typedef std::shared_ptr<display_wall> display_wall_ref;
+
+  // create on the gl thread, the current context becomes the resource
+  // context unless one is set, with Cinder's default shared contexts the
+  // first window's
+  static display_wall_ref create();
+
+  //////////////////////////////////////////////////////
+  // ctr(s) / dctr(s)
+  //////////////////////////////////////////////////////
+  display_wall();
+
+  ~display_wall();
+
+  //////////////////////////////////////////////////////
+  // getters
+  //////////////////////////////////////////////////////
+  const std::vector<display_view_ref> & get_views();
+
+  size_t size();
+
+  //////////////////////////////////////////////////////
+  // methods
+  //////////////////////////////////////////////////////
+  void add_view(const display_view_ref & view);
+
+  void remove_view(const display_view_ref & view);
+
+  void add(const sprite_ref & sp);
+
+  // batches are drawn after the sprites, sprite batches are culled per view
+  void add(const sprite_batch_ref & batch);
+
+  void add(const text_batch_ref & batch);
+
+  void remove(const sprite_ref & sp);
+
+  void clear();
+
+  // run the provider and upload schedulers once for every view, call from App::update()
+  void update();
+
+  // the same on an external clock, ie. a cluster's
+  void update(double now);
+
+  // draw a view, a window's from that window's draw()
+  void draw(const display_view_ref & view);
+
+  // draw every offscreen view
+  void draw_offscreen();
+
+protected:
+  //////////////////////////////////////////////////////
+  // properties
+  //////////////////////////////////////////////////////
+  std::vector<display_view_ref> views;
+  std::vector<sprite_ref> sprites;
+  std::vector<sprite_batch_ref> sprite_batches;
+  std::vector<text_batch_ref> text_batches;
+  std::vector<uint8_t> in_view;  // per sprite, from the last cull
+  GLsync resources_ready;        // fenced after the resource context's work each frame
+
+  //////////////////////////////////////////////////////
+  // methods
+  //////////////////////////////////////////////////////
+  void draw_canvas(display_view & view);
+
+  // composite the sprites' queued updates in the resource context, in one switch
+  void deliver();
+
+  // before another context samples what the resource context rendered
+  void wait_for_resources();
+};
+
+//////////////////////////////////////////////////////
+// typedefs
+//////////////////////////////////////////////////////
+typedef display_wall::display_wall_ref display_wall_ref;
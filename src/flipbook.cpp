@@ -0,0 +1,250 @@
+// std
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// cinder
+#include "cinder/app/App.h"
+#include "cinder/ImageIo.h"
+#include "cinder/Log.h"
+
+// sfmoma
+#include "cache.h"
+#include "color.h"
+#include "flipbook.h"
+#include "memory.h"
+#include "sprite.h"
+
+using namespace ci;
+using namespace ci::app;
+
+namespace {
+  // gap between packed frames, wide enough for the bicubic filter's footprint
+  const int atlas_padding = 2;
+}
+
+////////////////////////////////////////////////////
+//  static
+////////////////////////////////////////////////////
+flipbook_provider_ref flipbook_provider::create(std::string sheet, ivec2 frame_size, int frame_count, float frame_rate) {
+  gl::TextureRef atlas = texture_cache::get(sheet);
+  if(!atlas) {
+    try {
+      Surface8u surface(loadImage(loadAsset(sheet)));
+      gl::Texture::Format format = color_policy::get_texture_format();
+      gpu_memory::reserve(gpu_memory::get_texture_bytes(surface.getSize(), format.getInternalFormat()));
+      atlas = gl::Texture::create(surface, format);
+      gpu_memory::track(atlas, "flipbook_provider");
+      texture_cache::put(sheet, atlas);
+    } catch(const std::exception & e) {
+      CI_LOG_E("Error loading sprite sheet " << sheet << ": " << e.what());
+    }
+  }
+  return create(atlas, frame_size, frame_count, frame_rate);
+}
+
+flipbook_provider_ref flipbook_provider::create(gl::TextureRef sheet, ivec2 frame_size, int frame_count, float frame_rate) {
+  return std::make_shared<flipbook_provider>(sheet, frame_size, frame_count, 0, frame_rate);
+}
+
+/**
+ * Pack the frames into rows of an atlas no larger than the driver's maximum
+ * texture size, frames that do not fit are dropped with a warning
+ */
+flipbook_provider_ref flipbook_provider::create(const std::vector<std::string> & frames, float frame_rate) {
+  if(frames.empty()) return nullptr;
+
+  // every path is part of the key, sequences can share a first frame and length
+  std::string key = "flipbook";
+  for(auto & frame : frames) key += "\n" + frame;
+  gl::TextureRef atlas = texture_cache::get(key);
+  ivec2 frame_size;
+  std::vector<Surface8u> surfaces;
+  try {
+    surfaces.push_back(Surface8u(loadImage(loadAsset(frames.front()))));
+    frame_size = surfaces.front().getSize();
+  } catch(const std::exception & e) {
+    CI_LOG_E("Error loading frame " << frames.front() << ": " << e.what());
+    return nullptr;
+  }
+
+  GLint max_size = 4096;
+  glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_size);
+  ivec2 stride = frame_size + ivec2(atlas_padding);
+  int count = (int)frames.size();
+  int columns = std::max(1, std::min((int)std::ceil(std::sqrt((float)count)), max_size / stride.x));
+  int max_rows = std::max(1, max_size / stride.y);
+  if((count + columns - 1) / columns > max_rows) {
+    CI_LOG_W("Flipbook " << frames.front() << " does not fit in one texture, keeping "
+      << columns * max_rows << " of " << count << " frames");
+    count = columns * max_rows;
+  }
+
+  if(!atlas) {
+    int rows = (count + columns - 1) / columns;
+    Surface8u packed(columns * stride.x, rows * stride.y, true);
+    for(int y = 0; y < packed.getHeight(); y++) {
+      std::memset(packed.getData(ivec2(0, y)), 0, packed.getWidth() * packed.getPixelInc());
+    }
+    for(int i = 0; i < count; i++) {
+      try {
+        if(i > 0) surfaces.push_back(Surface8u(loadImage(loadAsset(frames[i]))));
+        Area frame_area = surfaces.back().getBounds().getClipBy(Area(ivec2(0), frame_size));
+        ivec2 offset((i % columns) * stride.x, (i / columns) * stride.y);
+        packed.copyFrom(surfaces.back(), frame_area, offset);
+      } catch(const std::exception & e) {
+        CI_LOG_E("Error loading frame " << frames[i] << ": " << e.what());
+      }
+      // only the current frame is needed once it is packed
+      if(surfaces.size() > 1) surfaces.erase(surfaces.begin());
+    }
+    gl::Texture::Format format = color_policy::get_texture_format();
+    gpu_memory::reserve(gpu_memory::get_texture_bytes(packed.getSize(), format.getInternalFormat()));
+    atlas = gl::Texture::create(packed, format);
+    gpu_memory::track(atlas, "flipbook_provider");
+    texture_cache::put(key, atlas);
+  }
+
+  return std::make_shared<flipbook_provider>(atlas, frame_size, count, atlas_padding, frame_rate);
+}
+
+//////////////////////////////////////////////////////
+// ctr(s) / dctr(s)
+//////////////////////////////////////////////////////
+flipbook_provider::flipbook_provider(gl::TextureRef atlas, ivec2 size, int count, int pad, float fps) {
+  frame_size = glm::max(size, ivec2(1));
+  padding = pad;
+  frame_rate = fps;
+  frame = 0;
+  looping = true;
+  playing = false;
+  position = 0.0f;
+  texture_is_new = false;
+
+  columns = 1;
+  frame_count = 0;
+  if(atlas) {
+    columns = std::max(1, (atlas->getWidth() + padding) / (frame_size.x + padding));
+    int rows = std::max(1, (atlas->getHeight() + padding) / (frame_size.y + padding));
+    frame_count = count > 0 ? std::min(count, columns * rows) : columns * rows;
+    set_texture(atlas);
+  }
+}
+
+//////////////////////////////////////////////////////
+// getters
+//////////////////////////////////////////////////////
+vec2 flipbook_provider::get_size() {
+  return frame_size;
+}
+
+bool flipbook_provider::is_ready() {
+  return texture != nullptr;
+}
+
+Area flipbook_provider::get_source_area() {
+  ivec2 ul((frame % columns) * (frame_size.x + padding), (frame / columns) * (frame_size.y + padding));
+  return Area(ul, ul + frame_size);
+}
+
+int flipbook_provider::get_frame() {
+  return frame;
+}
+
+int flipbook_provider::get_frame_count() {
+  return frame_count;
+}
+
+float flipbook_provider::get_frame_rate() {
+  return frame_rate;
+}
+
+bool flipbook_provider::is_playing() {
+  return playing;
+}
+
+//////////////////////////////////////////////////////
+// setters
+//////////////////////////////////////////////////////
+void flipbook_provider::set_frame(int f) {
+  stop();
+  position = (float)f;
+  show_position();
+}
+
+void flipbook_provider::set_frame_rate(float fps) {
+  frame_rate = fps;
+  if(playing) play();
+}
+
+void flipbook_provider::set_looping(bool loop) {
+  if(loop == looping) return;
+  looping = loop;
+  if(playing) play();
+}
+
+//////////////////////////////////////////////////////
+// methods
+//////////////////////////////////////////////////////
+/**
+ * Play to the end from the current frame; looping continues with a tween
+ * over every frame that the timeline repeats, rather than restarting
+ * from inside the finishing tween
+ */
+ci::TweenRef<float> flipbook_provider::play(float delay) {
+  if(frame_count < 2 || frame_rate <= 0.0f) return nullptr;
+
+  if(position() >= frame_count - 1) position = 0.0f;
+  float from = position();
+  float cycle = frame_count / frame_rate;
+  Timeline & timeline = sprite::get_default_timeline();
+  playing = true;
+
+  if(looping) {
+    if(from <= 0.0f) {
+      return timeline.apply(&position, 0.0f, (float)frame_count, cycle).delay(delay).loop()
+        .updateFn([this] { show_position(); });
+    }
+    ci::TweenRef<float> tween = timeline.apply(&position, (float)frame_count, (frame_count - from) / frame_rate)
+      .delay(delay).updateFn([this] { show_position(); });
+    timeline.appendTo(&position, 0.0f, (float)frame_count, cycle).loop()
+      .updateFn([this] { show_position(); });
+    return tween;
+  }
+
+  return timeline.apply(&position, (float)frame_count, (frame_count - from) / frame_rate).delay(delay)
+    .updateFn([this] { show_position(); })
+    .finishFn([this] {
+      playing = false;
+      position = (float)(frame_count - 1);
+      show_position();
+    });
+}
+
+void flipbook_provider::stop() {
+  position.stop();
+  playing = false;
+}
+
+ci::TweenRef<float> flipbook_provider::frame_to(float target, float duration, float delay, EaseFn ease_fn) {
+  target = glm::clamp(target, 0.0f, (float)std::max(frame_count - 1, 0));
+  if(duration <= 0) {
+    set_frame((int)target);
+    return nullptr;
+  }
+  playing = false;
+  return sprite::get_default_timeline().apply(&position, target, duration).delay(delay).easeFn(ease_fn)
+    .updateFn([this] { show_position(); });
+}
+
+/**
+ * A frame change only moves the source area, sprites drawing straight
+ * from the atlas pick it up as they draw; zoomed sprites recomposite
+ */
+void flipbook_provider::show_position() {
+  if(frame_count <= 0) return;
+  int f = glm::clamp((int)std::floor(position()), 0, frame_count - 1);
+  if(f == frame) return;
+  frame = f;
+  set_texture_changed(Area(ivec2(0), frame_size));
+}
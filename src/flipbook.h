@@ -0,0 +1,129 @@
+#pragma once
+
+// std
+#include <string>
+#include <vector>
+
+// cinder
+#include "cinder/Timeline.h"
+
+// sfmoma
+#include "provider.h"
+
+/////////////////////////////////////////////////
+//
+//  flipbook_provider
+//  Frame-indexed animation from a sprite sheet
+//  or an image sequence packed into one atlas
+//
+//  The atlas is uploaded once and shared through
+//  the texture_cache, changing frames only moves
+//  the source area the sprite draws from; only
+//  zoomed sprites composite each frame
+//
+/////////////////////////////////////////////////
+class flipbook_provider : public texture_provider {
+public:
+  //////////////////////////////////////////////////////
+  // static
+  //////////////////////////////////////////////////////
+  typedef std::shared_ptr<flipbook_provider> flipbook_provider_ref;
+
+  // a sheet of frame_size frames in rows, frame_count 0 for every frame in the sheet
+  static flipbook_provider_ref create(
+    std::string sheet,
+    ci::ivec2 frame_size,
+    int frame_count = 0,
+    float frame_rate = 30.0f);
+
+  static flipbook_provider_ref create(
+    ci::gl::TextureRef sheet,
+    ci::ivec2 frame_size,
+    int frame_count = 0,
+    float frame_rate = 30.0f);
+
+  // an image per frame, packed into an atlas
+  static flipbook_provider_ref create(
+    const std::vector<std::string> & frames,
+    float frame_rate = 30.0f);
+
+  //////////////////////////////////////////////////////
+  // ctr(s) / dctr(s)
+  //////////////////////////////////////////////////////
+  flipbook_provider(ci::gl::TextureRef atlas, ci::ivec2 frame_size, int frame_count, int padding, float frame_rate);
+
+  //////////////////////////////////////////////////////
+  // getters
+  //////////////////////////////////////////////////////
+  ci::vec2 get_size() override;
+
+  provider_type get_type() override { return provider_type::Image; }
+
+  bool is_ready() override;
+
+  ci::Area get_source_area() override;
+
+  bool is_atlas() override { return true; }
+
+  int get_frame();
+
+  int get_frame_count();
+
+  float get_frame_rate();
+
+  bool is_playing();
+
+  //////////////////////////////////////////////////////
+  // setters
+  //////////////////////////////////////////////////////
+  void set_frame(int frame);
+
+  void set_frame_rate(float fps);
+
+  void set_looping(bool loop);
+
+  void set_source(std::string path) override {}
+
+  //////////////////////////////////////////////////////
+  // methods
+  //////////////////////////////////////////////////////
+  // play from the current frame at the frame rate
+  ci::TweenRef<float> play(float delay = 0);
+
+  void stop();
+
+  // schedule an animation to a frame, ie. to scrub or ease a sequence
+  ci::TweenRef<float> frame_to(
+    float target,
+    float duration = 0,
+    float delay = 0,
+    ci::EaseFn fn = ci::easeNone);
+
+  // frames are driven by sprite::get_default_timeline(), nothing to do here
+  void update() override {}
+
+protected:
+  //////////////////////////////////////////////////////
+  // properties
+  //////////////////////////////////////////////////////
+  ci::ivec2 frame_size;
+  int frame_count;
+  int columns;
+  int padding;
+  int frame;
+  float frame_rate;
+  bool looping;
+  bool playing;
+  ci::Anim<float> position;   // fractional frame, driven by the sprites' default timeline
+
+  //////////////////////////////////////////////////////
+  // methods
+  //////////////////////////////////////////////////////
+  // show the frame under position, if it changed
+  void show_position();
+};
+
+//////////////////////////////////////////////////////
+// typedefs
+//////////////////////////////////////////////////////
+typedef flipbook_provider::flipbook_provider_ref flipbook_provider_ref;
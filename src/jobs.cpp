@@ -0,0 +1,218 @@
+// std
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// cinder
+#include "cinder/Log.h"
+
+// sfmoma
+#include "jobs.h"
+#include "profiler.h"
+
+namespace {
+  class queued_job {
+  public:
+    job_system::job_fn fn;
+    std::atomic<int> * pending;
+  };
+
+  class job_queue {
+  public:
+    std::mutex mutex;
+    std::deque<queued_job> jobs;
+  };
+
+  /**
+   * Queue 0 is shared by every thread that is not a worker,
+   * worker i owns queue i
+   */
+  class workers {
+  public:
+    workers() { start(std::max(std::thread::hardware_concurrency(), 1u)); }
+
+    ~workers() { stop(); }
+
+    void start(unsigned count) {
+      stop();
+      stopping = false;
+      queues.clear();
+      for(unsigned i = 0; i < count; i++) queues.emplace_back(new job_queue());
+      for(unsigned i = 1; i < count; i++) threads.emplace_back([this, i] { loop(i); });
+    }
+
+    void stop() {
+      {
+        std::lock_guard<std::mutex> lock(wake_mutex);
+        stopping = true;
+      }
+      wake.notify_all();
+      for(auto & t : threads) t.join();
+      threads.clear();
+    }
+
+    void push(unsigned index, queued_job job) {
+      {
+        std::lock_guard<std::mutex> lock(queues[index]->mutex);
+        queues[index]->jobs.push_back(std::move(job));
+      }
+      {
+        std::lock_guard<std::mutex> lock(wake_mutex);
+        queued++;
+      }
+      wake.notify_one();
+    }
+
+    // run one job, newest of our own first, otherwise the oldest of someone else's
+    bool run_one(unsigned index) {
+      queued_job job;
+      if(!take_newest(index, job)) {
+        bool stolen = false;
+        for(size_t i = 1; i < queues.size() && !stolen; i++) {
+          stolen = take_oldest((unsigned)((index + i) % queues.size()), job);
+        }
+        if(!stolen) return false;
+        steals++;
+      }
+      {
+        std::lock_guard<std::mutex> lock(wake_mutex);
+        queued--;
+      }
+
+      try {
+        job.fn();
+      } catch(const std::exception & e) {
+        CI_LOG_E("Job failed: " << e.what());
+      }
+      jobs++;
+      (*job.pending)--;
+      return true;
+    }
+
+    std::vector<std::unique_ptr<job_queue>> queues;
+    std::vector<std::thread> threads;
+    std::mutex wake_mutex;
+    std::condition_variable wake;
+    int queued = 0;
+    bool stopping = false;
+    std::atomic<uint64_t> jobs { 0 };
+    std::atomic<uint64_t> steals { 0 };
+
+  protected:
+    bool take_newest(unsigned index, queued_job & job) {
+      std::lock_guard<std::mutex> lock(queues[index]->mutex);
+      if(queues[index]->jobs.empty()) return false;
+      job = std::move(queues[index]->jobs.back());
+      queues[index]->jobs.pop_back();
+      return true;
+    }
+
+    bool take_oldest(unsigned index, queued_job & job) {
+      std::lock_guard<std::mutex> lock(queues[index]->mutex);
+      if(queues[index]->jobs.empty()) return false;
+      job = std::move(queues[index]->jobs.front());
+      queues[index]->jobs.pop_front();
+      return true;
+    }
+
+    void loop(unsigned index) {
+      worker_index = index;
+      while(true) {
+        if(run_one(index)) continue;
+        std::unique_lock<std::mutex> lock(wake_mutex);
+        wake.wait(lock, [this] { return stopping || queued > 0; });
+        if(stopping) return;
+      }
+    }
+
+  public:
+    static thread_local unsigned worker_index;
+  };
+
+  thread_local unsigned workers::worker_index = 0;
+
+  workers & get_workers() {
+    static workers pool;
+    return pool;
+  }
+}
+
+/////////////////////////////////////////////////
+//
+//  job_system::group
+//
+/////////////////////////////////////////////////
+void job_system::group::run(job_fn job) {
+  workers & pool = get_workers();
+  pending++;
+  if(pool.queues.size() < 2) {
+    // no workers, run it now
+    job();
+    pool.jobs++;
+    pending--;
+    return;
+  }
+  pool.push(workers::worker_index, { std::move(job), &pending });
+}
+
+void job_system::group::wait() {
+  if(pending == 0) return;
+  workers & pool = get_workers();
+  while(pending > 0) {
+    if(!pool.run_one(workers::worker_index)) std::this_thread::yield();
+  }
+}
+
+//////////////////////////////////////////////////////
+// getters
+//////////////////////////////////////////////////////
+unsigned job_system::get_thread_count() {
+  return (unsigned)get_workers().queues.size();
+}
+
+job_system::stats job_system::get_stats() {
+  workers & pool = get_workers();
+  return { pool.jobs, pool.steals };
+}
+
+//////////////////////////////////////////////////////
+// setters
+//////////////////////////////////////////////////////
+void job_system::set_thread_count(unsigned count) {
+  if(count == 0) count = std::max(std::thread::hardware_concurrency(), 1u);
+  workers & pool = get_workers();
+  if(pool.queues.size() != count) pool.start(count);
+}
+
+//////////////////////////////////////////////////////
+// methods
+//////////////////////////////////////////////////////
+void job_system::parallel_for(size_t count, size_t chunk_size, const std::function<void(size_t, size_t)> & fn) {
+  SPRITE_PROFILE_SCOPE("job_system::parallel_for");
+  chunk_size = std::max<size_t>(chunk_size, 1);
+  // inline still chunk by chunk, callers may keep state per chunk (ie. sprite_batch)
+  if(count <= chunk_size || get_thread_count() < 2) {
+    for(size_t begin = 0; begin < count; begin += chunk_size) {
+      fn(begin, std::min(begin + chunk_size, count));
+    }
+    return;
+  }
+
+  group chunks;
+  for(size_t begin = 0; begin < count; begin += chunk_size) {
+    size_t end = std::min(begin + chunk_size, count);
+    chunks.run([&fn, begin, end] { fn(begin, end); });
+  }
+  chunks.wait();
+}
+
+void job_system::reset_stats() {
+  workers & pool = get_workers();
+  pool.jobs = 0;
+  pool.steals = 0;
+}
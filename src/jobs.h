@@ -0,0 +1,80 @@
+#pragma once
+
+// std
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+/////////////////////////////////////////////////
+//
+//  job_system
+//  Worker threads, one per core by default, that
+//  share out short cpu jobs, ie. building a
+//  sprite_batch's vertices a chunk at a time
+//
+//  Each worker takes the newest job from its own
+//  queue and, when that is empty, steals the
+//  oldest from another's. A thread waiting on a
+//  group runs queued jobs instead of sleeping
+//
+//  Jobs must not touch gl, only the render thread
+//  has a context
+//
+/////////////////////////////////////////////////
+class job_system {
+public:
+  typedef std::function<void()> job_fn;
+
+  class stats {
+  public:
+    uint64_t jobs;    // jobs run
+    uint64_t steals;  // of those, jobs taken from another thread's queue
+  };
+
+  /////////////////////////////////////////////////
+  //  jobs waited on together
+  /////////////////////////////////////////////////
+  class group {
+  public:
+    group() : pending(0) {}
+
+    ~group() { wait(); }
+
+    void run(job_fn job);
+
+    // run queued jobs until every job of the group has finished
+    void wait();
+
+    bool is_done() { return pending == 0; }
+
+  protected:
+    friend class job_system;
+
+    std::atomic<int> pending;
+  };
+
+  //////////////////////////////////////////////////////
+  // getters
+  //////////////////////////////////////////////////////
+  // the threads jobs run on, the workers and the thread waiting on them
+  static unsigned get_thread_count();
+
+  static stats get_stats();
+
+  //////////////////////////////////////////////////////
+  // setters
+  //////////////////////////////////////////////////////
+  // 0 = one per core, 1 = every job runs on the thread waiting for it,
+  // only call it while no jobs are queued
+  static void set_thread_count(unsigned count);
+
+  //////////////////////////////////////////////////////
+  // methods
+  //////////////////////////////////////////////////////
+  // fn(begin, end) over [0, count) in chunks of chunk_size, returns once every chunk is done,
+  // always a call per chunk, on the calling thread when there are no workers
+  static void parallel_for(size_t count, size_t chunk_size, const std::function<void(size_t, size_t)> & fn);
+
+  static void reset_stats();
+};
@@ -0,0 +1,294 @@
+// std
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// cinder
+#include "cinder/Log.h"
+
+// sfmoma
+#include "memory.h"
+#include "profiler.h"
+
+using namespace ci;
+
+namespace {
+  class tracked {
+  public:
+    std::weak_ptr<void> resource;
+    const char * category;
+    const char * owner;
+    size_t bytes;
+  };
+
+  class evictor {
+  public:
+    int id;
+    int priority;
+    gpu_memory::evict_fn evict;
+  };
+
+  std::mutex mutex;
+  std::unordered_map<const void *, tracked> resources;
+  size_t total_bytes = 0;
+  size_t peak_bytes = 0;
+  size_t budget = 0;
+  size_t collected_size = 0;
+  bool over_budget = false;
+
+  std::vector<evictor> evictors;
+  int next_evictor_id = 0;
+
+  // drop resources that have been destroyed and recount, caller holds the lock
+  void collect() {
+    total_bytes = 0;
+    for(auto it = resources.begin(); it != resources.end();) {
+      if(it->second.resource.expired()) {
+        it = resources.erase(it);
+      } else {
+        total_bytes += it->second.bytes;
+        ++it;
+      }
+    }
+    collected_size = resources.size();
+  }
+
+  bool fits(size_t bytes) {
+    return budget == 0 || total_bytes + bytes <= budget;
+  }
+}
+
+/////////////////////////////////////////////////
+//
+//  gpu_memory
+//
+/////////////////////////////////////////////////
+float gpu_memory::get_bytes_per_pixel(GLint internal_format) {
+  switch(internal_format) {
+    case GL_R8:
+    case GL_RED:
+      return 1;
+    case GL_RG8:
+    case GL_R16F:
+    case GL_DEPTH_COMPONENT16:
+      return 2;
+    // drivers pad three channel formats to four
+    case GL_RGB8:
+    case GL_RGB:
+    case GL_RGBA8:
+    case GL_RGBA:
+    case GL_SRGB8_ALPHA8:
+    case GL_RGB10_A2:
+    case GL_R11F_G11F_B10F:
+    case GL_RG16F:
+    case GL_R32F:
+    case GL_DEPTH_COMPONENT24:
+    case GL_DEPTH_COMPONENT32F:
+    case GL_DEPTH24_STENCIL8:
+      return 4;
+    case GL_RGB16F:
+    case GL_RGBA16F:
+    case GL_RG32F:
+    case GL_DEPTH32F_STENCIL8:
+      return 8;
+    case GL_RGB32F:
+    case GL_RGBA32F:
+      return 16;
+#if defined( GL_COMPRESSED_RGB_S3TC_DXT1_EXT )
+    case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+    case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+      return 0.5f;
+    case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:
+    case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+      return 1;
+#endif
+    default:
+      return 4;
+  }
+}
+
+size_t gpu_memory::get_texture_bytes(ivec2 size, GLint internal_format, bool mipmapped, int samples, int layers) {
+  double bytes_per_pixel = get_bytes_per_pixel(internal_format);
+  double bytes = 0;
+  ivec2 level = glm::max(size, ivec2(0));
+  while(true) {
+    bytes += (double)level.x * level.y * bytes_per_pixel;
+    if(!mipmapped || (level.x <= 1 && level.y <= 1)) break;
+    level = glm::max(ivec2(1), level / 2);
+  }
+  return (size_t)std::ceil(bytes) * std::max(samples, 1) * std::max(layers, 1);
+}
+
+size_t gpu_memory::get_texture_bytes(const gl::TextureRef & texture) {
+  if(!texture) return 0;
+  return get_texture_bytes(texture->getSize(), texture->getInternalFormat(), texture->hasMipmapping());
+}
+
+size_t gpu_memory::get_fbo_bytes(ivec2 size, const gl::Fbo::Format & format) {
+  int samples = format.getSamples();
+  size_t bytes = 0;
+
+  // multisampled attachments are renderbuffers, resolved into the textures
+  if(format.hasColorTexture()) {
+    const auto & color = format.getColorTextureFormat();
+    bytes += get_texture_bytes(size, color.getInternalFormat(), color.hasMipmapping());
+    if(samples > 0) bytes += get_texture_bytes(size, color.getInternalFormat(), false, samples);
+  }
+
+  if(format.hasDepthTexture()) {
+    GLint depth = format.getDepthTextureFormat().getInternalFormat();
+    bytes += get_texture_bytes(size, depth);
+    if(samples > 0) bytes += get_texture_bytes(size, depth, false, samples);
+  } else if(format.hasDepthBuffer()) {
+    bytes += get_texture_bytes(size, format.getDepthBufferInternalFormat(), false, samples);
+  }
+
+  if(format.hasStencilBuffer()) {
+    bytes += (size_t)size.x * size.y * std::max(samples, 1);
+  }
+  return bytes;
+}
+
+size_t gpu_memory::get_fbo_bytes(const gl::FboRef & fbo) {
+  if(!fbo) return 0;
+  return get_fbo_bytes(fbo->getSize(), fbo->getFormat());
+}
+
+void gpu_memory::track(const std::shared_ptr<void> & resource, const char * category, const char * owner, size_t bytes) {
+  if(!resource) return;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto found = resources.find(resource.get());
+    if(found != resources.end() && !found->second.resource.expired()) {
+      found->second.owner = owner;
+      return;
+    }
+
+    // the address of a destroyed resource can be reused before it is collected
+    if(found != resources.end()) total_bytes -= std::min(total_bytes, found->second.bytes);
+    resources[resource.get()] = { resource, category, owner, bytes };
+    total_bytes += bytes;
+    peak_bytes = std::max(peak_bytes, total_bytes);
+
+    // destroyed resources are only noticed when collected, so collect as the map grows
+    if(resources.size() > std::max<size_t>(collected_size * 2, 64)) collect();
+  }
+  SPRITE_PROFILE_ALLOC(category, bytes);
+}
+
+void gpu_memory::track(const gl::TextureRef & texture, const char * owner) {
+  track(texture, "texture", owner, get_texture_bytes(texture));
+}
+
+void gpu_memory::track(const gl::FboRef & fbo, const char * owner) {
+  track(fbo, "fbo", owner, get_fbo_bytes(fbo));
+}
+
+bool gpu_memory::reserve(size_t bytes) {
+  std::vector<evictor> pending;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if(fits(bytes)) return true;
+    collect();
+    if(fits(bytes)) return true;
+    pending = evictors;
+  }
+
+  // evictors run without the lock, freeing resources only drops their references
+  for(auto & e : pending) {
+    size_t needed;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      collect();
+      if(fits(bytes)) {
+        over_budget = false;
+        return true;
+      }
+      needed = total_bytes + bytes - budget;
+    }
+    e.evict(needed);
+  }
+
+  std::lock_guard<std::mutex> lock(mutex);
+  collect();
+  if(fits(bytes)) {
+    over_budget = false;
+    return true;
+  }
+  if(!over_budget) {
+    CI_LOG_W("GPU memory over budget: " << (total_bytes + bytes) / (1024 * 1024) << "MB of "
+      << budget / (1024 * 1024) << "MB after evicting");
+    over_budget = true;
+  }
+  return false;
+}
+
+void gpu_memory::set_budget(size_t bytes) {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    budget = bytes;
+    over_budget = false;
+  }
+  reserve(0);
+}
+
+size_t gpu_memory::get_budget() {
+  std::lock_guard<std::mutex> lock(mutex);
+  return budget;
+}
+
+size_t gpu_memory::get_bytes() {
+  std::lock_guard<std::mutex> lock(mutex);
+  collect();
+  return total_bytes;
+}
+
+size_t gpu_memory::get_peak_bytes() {
+  std::lock_guard<std::mutex> lock(mutex);
+  return peak_bytes;
+}
+
+std::map<std::string, size_t> gpu_memory::get_bytes_by_owner() {
+  std::lock_guard<std::mutex> lock(mutex);
+  collect();
+  std::map<std::string, size_t> bytes;
+  for(auto & r : resources) bytes[r.second.owner] += r.second.bytes;
+  return bytes;
+}
+
+std::map<std::string, size_t> gpu_memory::get_bytes_by_category() {
+  std::lock_guard<std::mutex> lock(mutex);
+  collect();
+  std::map<std::string, size_t> bytes;
+  for(auto & r : resources) bytes[r.second.category] += r.second.bytes;
+  return bytes;
+}
+
+void gpu_memory::log_report() {
+  auto megabytes = [](size_t bytes) { return bytes / (1024.0 * 1024.0); };
+  CI_LOG_I("GPU memory: " << megabytes(get_bytes()) << "MB, peak " << megabytes(get_peak_bytes())
+    << "MB, budget " << megabytes(get_budget()) << "MB");
+  for(auto & owner : get_bytes_by_owner()) {
+    CI_LOG_I("  " << owner.first << ": " << megabytes(owner.second) << "MB");
+  }
+  for(auto & category : get_bytes_by_category()) {
+    CI_LOG_I("  [" << category.first << "]: " << megabytes(category.second) << "MB");
+  }
+}
+
+int gpu_memory::add_evictor(int priority, evict_fn evict) {
+  std::lock_guard<std::mutex> lock(mutex);
+  int id = next_evictor_id++;
+  auto position = std::upper_bound(evictors.begin(), evictors.end(), priority,
+    [](int p, const evictor & e) { return p < e.priority; });
+  evictors.insert(position, { id, priority, evict });
+  return id;
+}
+
+void gpu_memory::remove_evictor(int id) {
+  std::lock_guard<std::mutex> lock(mutex);
+  evictors.erase(std::remove_if(evictors.begin(), evictors.end(),
+    [=](const evictor & e) { return e.id == id; }), evictors.end());
+}
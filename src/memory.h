@@ -0,0 +1,87 @@
+#pragma once
+
+// std
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+
+// cinder
+#include "cinder/gl/Fbo.h"
+#include "cinder/gl/Texture.h"
+
+/////////////////////////////////////////////////
+//
+//  gpu_memory
+//  Tracks the video memory of every texture and
+//  fbo the block allocates, by owner and category,
+//  and enforces an optional budget by asking the
+//  caches to evict before allocating past it
+//
+/////////////////////////////////////////////////
+class gpu_memory {
+public:
+  // asked to free at least bytes, evictors free what they can
+  typedef std::function<void(size_t bytes)> evict_fn;
+
+  //////////////////////////////////////////////////////
+  // static
+  //////////////////////////////////////////////////////
+  // size of a single pixel of an internal format, 4 for unknown formats
+  static float get_bytes_per_pixel(GLint internal_format);
+
+  // size of a texture or renderbuffer, including its mip chain and samples
+  static size_t get_texture_bytes(
+    ci::ivec2 size,
+    GLint internal_format,
+    bool mipmapped = false,
+    int samples = 0,
+    int layers = 1);
+
+  static size_t get_texture_bytes(const ci::gl::TextureRef & texture);
+
+  // size of an fbo's attachments, multisampled fbos also hold resolve textures
+  static size_t get_fbo_bytes(ci::ivec2 size, const ci::gl::Fbo::Format & format);
+
+  static size_t get_fbo_bytes(const ci::gl::FboRef & fbo);
+
+  // register a resource, it is dropped from the totals once it is destroyed,
+  // tracking a resource again changes its owner. category and owner must be
+  // string literals, ie. "texture" and "sprite"
+  static void track(
+    const std::shared_ptr<void> & resource,
+    const char * category,
+    const char * owner,
+    size_t bytes);
+
+  static void track(const ci::gl::TextureRef & texture, const char * owner);
+
+  static void track(const ci::gl::FboRef & fbo, const char * owner);
+
+  // make room for an allocation of bytes, evicting if it would exceed the budget,
+  // returns false if the allocation will still go over
+  static bool reserve(size_t bytes);
+
+  // the budget in bytes, 0 (the default) for no budget
+  static void set_budget(size_t bytes);
+
+  static size_t get_budget();
+
+  // bytes of live tracked resources
+  static size_t get_bytes();
+
+  static size_t get_peak_bytes();
+
+  static std::map<std::string, size_t> get_bytes_by_owner();
+
+  static std::map<std::string, size_t> get_bytes_by_category();
+
+  // log the totals by owner and category
+  static void log_report();
+
+  // evictors run in ascending priority until the allocation fits,
+  // returns an id for remove_evictor
+  static int add_evictor(int priority, evict_fn evict);
+
+  static void remove_evictor(int id);
+};
@@ -0,0 +1,365 @@
+// std
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+
+// cinder
+#include "cinder/ImageIo.h"
+#include "cinder/Log.h"
+#include "cinder/Timer.h"
+#include "cinder/gl/gl.h"
+
+// sfmoma
+#include "memory.h"
+#include "offline.h"
+#include "profiler.h"
+#include "scheduler.h"
+#include "sprite.h"
+
+using namespace ci;
+
+namespace {
+  void write_rows(const Surface8u & frame, const std::function<void(const uint8_t *, size_t)> & out) {
+    size_t row_bytes = frame.getWidth() * frame.getPixelInc();
+    for(int y = 0; y < frame.getHeight(); y++) {
+      out(frame.getData(ivec2(0, y)), row_bytes);
+    }
+  }
+
+  void replace_all(std::string & text, const std::string & key, const std::string & value) {
+    for(size_t at = text.find(key); at != std::string::npos; at = text.find(key, at + value.size())) {
+      text.replace(at, key.size(), value);
+    }
+  }
+}
+
+/////////////////////////////////////////////////
+//
+//  raw_sink
+//
+/////////////////////////////////////////////////
+frame_sink_ref raw_sink::create(fs::path path) {
+  return std::make_shared<raw_sink>(path);
+}
+
+raw_sink::raw_sink(fs::path file_path) {
+  path = file_path;
+}
+
+bool raw_sink::open(ivec2 size, double fps) {
+  file.open(path.string(), std::ios::binary | std::ios::trunc);
+  if(!file) CI_LOG_E("Error opening " << path);
+  return (bool)file;
+}
+
+void raw_sink::write(const Surface8u & frame, int index) {
+  write_rows(frame, [this](const uint8_t * row, size_t bytes) {
+    file.write((const char *)row, bytes);
+  });
+}
+
+void raw_sink::close() {
+  file.close();
+}
+
+/////////////////////////////////////////////////
+//
+//  png_sink
+//
+/////////////////////////////////////////////////
+frame_sink_ref png_sink::create(fs::path directory, std::string prefix) {
+  return std::make_shared<png_sink>(directory, prefix);
+}
+
+png_sink::png_sink(fs::path dir, std::string file_prefix) {
+  directory = dir;
+  prefix = file_prefix;
+}
+
+bool png_sink::open(ivec2 size, double fps) {
+  try {
+    fs::create_directories(directory);
+  } catch(const std::exception & e) {
+    CI_LOG_E("Error creating " << directory << ": " << e.what());
+    return false;
+  }
+  return true;
+}
+
+void png_sink::write(const Surface8u & frame, int index) {
+  std::ostringstream name;
+  name << prefix << std::setw(6) << std::setfill('0') << index << ".png";
+  try {
+    writeImage(directory / name.str(), frame);
+  } catch(const std::exception & e) {
+    CI_LOG_E("Error writing " << name.str() << ": " << e.what());
+  }
+}
+
+/////////////////////////////////////////////////
+//
+//  pipe_sink
+//
+/////////////////////////////////////////////////
+frame_sink_ref pipe_sink::create(std::string command) {
+  return std::make_shared<pipe_sink>(command);
+}
+
+pipe_sink::pipe_sink(std::string cmd) {
+  command = cmd;
+  pipe = nullptr;
+}
+
+pipe_sink::~pipe_sink() {
+  close();
+}
+
+bool pipe_sink::open(ivec2 size, double fps) {
+  std::string line = command;
+  replace_all(line, "{width}", std::to_string(size.x));
+  replace_all(line, "{height}", std::to_string(size.y));
+  std::ostringstream rate;
+  rate << fps;
+  replace_all(line, "{fps}", rate.str());
+
+#if defined( CINDER_MSW )
+  pipe = _popen(line.c_str(), "wb");
+#else
+  pipe = popen(line.c_str(), "w");
+#endif
+  if(!pipe) CI_LOG_E("Error starting " << line);
+  return pipe != nullptr;
+}
+
+void pipe_sink::write(const Surface8u & frame, int index) {
+  if(!pipe) return;
+  write_rows(frame, [this](const uint8_t * row, size_t bytes) {
+    fwrite(row, 1, bytes, pipe);
+  });
+}
+
+void pipe_sink::close() {
+  if(!pipe) return;
+#if defined( CINDER_MSW )
+  _pclose(pipe);
+#else
+  pclose(pipe);
+#endif
+  pipe = nullptr;
+}
+
+/////////////////////////////////////////////////
+//
+//  offline_renderer
+//
+/////////////////////////////////////////////////
+offline_renderer_ref offline_renderer::create(ivec2 size, double fps, frame_sink_ref sink, int samples) {
+  return std::make_shared<offline_renderer>(size, fps, sink, samples);
+}
+
+offline_renderer::offline_renderer(ivec2 frame_size, double frame_rate, frame_sink_ref frame_sink, int samples) {
+  size = glm::max(frame_size, ivec2(1));
+  fps = frame_rate > 0.0 ? frame_rate : 30.0;
+  sink = frame_sink;
+  sink_open = false;
+  frame = 0;
+  render_fps = 0.0;
+  load_timeout = 30.0;
+  timeline = Timeline::create();
+  frame_surface = Surface8u(size.x, size.y, true, SurfaceChannelOrder::RGBA);
+
+  // what sprites composite into, so blending matches theirs
+  gl::Fbo::Format format = sprite::get_fbo_format();
+  gpu_memory::reserve(gpu_memory::get_fbo_bytes(size, format));
+  resolved = gl::Fbo::create(size.x, size.y, format);
+  gpu_memory::track(resolved, "offline_renderer");
+  if(samples > 0) {
+    format.samples(samples);
+    gpu_memory::reserve(gpu_memory::get_fbo_bytes(size, format));
+    fbo = gl::Fbo::create(size.x, size.y, format);
+    gpu_memory::track(fbo, "offline_renderer");
+  } else {
+    fbo = resolved;
+  }
+
+  // three frames in flight keep the copy ahead of the cpu without stalling
+  size_t bytes = (size_t)size.x * size.y * 4;
+  readbacks.resize(3);
+  for(auto & slot : readbacks) {
+    slot.pbo = gl::Pbo::create(GL_PIXEL_PACK_BUFFER, bytes, nullptr, GL_STREAM_READ);
+    gpu_memory::track(slot.pbo, "pbo", "offline_renderer", bytes);
+  }
+}
+
+offline_renderer::~offline_renderer() {
+  for(auto & slot : readbacks) {
+    if(slot.fence) glDeleteSync(slot.fence);
+  }
+  if(sink_open) sink->close();
+}
+
+//////////////////////////////////////////////////////
+// getters
+//////////////////////////////////////////////////////
+ivec2 offline_renderer::get_size() {
+  return size;
+}
+
+TimelineRef offline_renderer::get_timeline() {
+  return timeline;
+}
+
+double offline_renderer::get_time() {
+  return frame / fps;
+}
+
+int offline_renderer::get_frames_rendered() {
+  return frame;
+}
+
+double offline_renderer::get_render_fps() {
+  return render_fps;
+}
+
+//////////////////////////////////////////////////////
+// setters
+//////////////////////////////////////////////////////
+void offline_renderer::set_update_fn(update_fn fn) {
+  on_update = fn;
+}
+
+void offline_renderer::set_draw_fn(draw_fn fn) {
+  on_draw = fn;
+}
+
+void offline_renderer::set_load_timeout(double seconds) {
+  load_timeout = seconds;
+}
+
+//////////////////////////////////////////////////////
+// methods
+//////////////////////////////////////////////////////
+void offline_renderer::wait_for(texture_provider_ref provider) {
+  if(provider && std::find(providers.begin(), providers.end(), provider) == providers.end()) {
+    providers.push_back(provider);
+  }
+}
+
+void offline_renderer::render(int frames) {
+  if(!sink || frames <= 0) return;
+  if(!sink_open) {
+    sink_open = sink->open(size, fps);
+    if(!sink_open) return;
+  }
+
+  // sprites animate in render time for the duration, then on whichever timeline they did before
+  TimelineRef previous_timeline = sprite::set_default_timeline(timeline);
+  Timer timer(true);
+
+  for(int i = 0; i < frames; i++) {
+    SPRITE_PROFILE_SCOPE("offline_renderer::frame");
+    double time = frame / fps;
+    timeline->stepTo((float)time);
+    if(on_update) on_update(time);
+    provider_scheduler::update(time);
+
+    // nothing may arrive late, so the frame does not depend on how fast it was drawn
+    load();
+
+    {
+      gl::ScopedFramebuffer scoped_fbo(fbo);
+      gl::ScopedViewport scoped_viewport(ivec2(0), size);
+      gl::ScopedMatrices scoped_matrices;
+      gl::setMatricesWindow(size);
+      gl::clear(ColorA(0, 0, 0, 0));
+      if(on_draw) on_draw();
+    }
+    if(fbo != resolved) fbo->blitTo(resolved, fbo->getBounds(), resolved->getBounds());
+
+    // the slot's previous frame is the oldest in flight, hand it over first
+    readback & slot = readbacks[frame % readbacks.size()];
+    if(slot.index >= 0) read(slot);
+
+    gl::ScopedFramebuffer scoped_read(GL_READ_FRAMEBUFFER, resolved->getId());
+    gl::ScopedBuffer scoped_pbo(slot.pbo);
+    GLint pack_alignment;
+    glGetIntegerv(GL_PACK_ALIGNMENT, &pack_alignment);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, size.x, size.y, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glPixelStorei(GL_PACK_ALIGNMENT, pack_alignment);
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    slot.index = frame;
+    frame++;
+  }
+
+  for(size_t i = 0; i < readbacks.size(); i++) {
+    readback & slot = readbacks[(frame + i) % readbacks.size()];
+    if(slot.index >= 0) read(slot);
+  }
+
+  sprite::set_default_timeline(previous_timeline);
+  double seconds = timer.getSeconds();
+  render_fps = seconds > 0.0 ? frames / seconds : 0.0;
+  CI_LOG_I("Rendered " << frames << " frames at " << render_fps << " fps");
+}
+
+void offline_renderer::render_seconds(double seconds) {
+  render((int)std::ceil(seconds * fps));
+}
+
+void offline_renderer::finish() {
+  if(sink_open) sink->close();
+  sink_open = false;
+}
+
+/**
+ * Update the providers waited for and drain the upload queue until
+ * none of them is loading, giving their decode threads a moment
+ * between passes
+ */
+void offline_renderer::load() {
+  Timer waited(true);
+  while(true) {
+    bool loading = false;
+    for(auto & provider : providers) {
+      provider->update();
+      if(provider->is_loading()) loading = true;
+    }
+    while(upload_scheduler::get_queue_size() > 0) upload_scheduler::process();
+    if(!loading) return;
+
+    if(waited.getSeconds() > load_timeout) {
+      CI_LOG_W("Frame " << frame << " drawn before its providers finished loading");
+      return;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+}
+
+/**
+ * Wait for the slot's copy, then flip it into a top-down surface
+ * for the sink
+ */
+void offline_renderer::read(readback & slot) {
+  if(slot.fence) {
+    while(glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) == GL_TIMEOUT_EXPIRED) {}
+    glDeleteSync(slot.fence);
+    slot.fence = nullptr;
+  }
+
+  size_t row_bytes = (size_t)size.x * 4;
+  gl::ScopedBuffer scoped_pbo(slot.pbo);
+  const uint8_t * mapped = (const uint8_t *)slot.pbo->mapBufferRange(0, row_bytes * size.y, GL_MAP_READ_BIT);
+  if(mapped) {
+    for(int y = 0; y < size.y; y++) {
+      std::memcpy(frame_surface.getData(ivec2(0, y)), mapped + (size.y - 1 - y) * row_bytes, row_bytes);
+    }
+    slot.pbo->unmap();
+    sink->write(frame_surface, slot.index);
+  }
+  slot.index = -1;
+}
@@ -0,0 +1,234 @@
+#pragma once
+
+// std
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <vector>
+
+// cinder
+#include "cinder/Filesystem.h"
+#include "cinder/Surface.h"
+#include "cinder/Timeline.h"
+#include "cinder/gl/Fbo.h"
+#include "cinder/gl/Pbo.h"
+
+// sfmoma
+#include "provider.h"
+
+/////////////////////////////////////////////////
+//
+//  frame_sink
+//  Receives the frames of an offline render in
+//  order, top row first, as RGBA8
+//
+/////////////////////////////////////////////////
+class frame_sink {
+public:
+  typedef std::shared_ptr<frame_sink> frame_sink_ref;
+
+  virtual ~frame_sink() {}
+
+  // called before the first frame, returning false stops the render
+  virtual bool open(ci::ivec2 size, double fps) { return true; }
+
+  virtual void write(const ci::Surface8u & frame, int index) = 0;
+
+  virtual void close() {}
+};
+
+typedef frame_sink::frame_sink_ref frame_sink_ref;
+
+/////////////////////////////////////////////////
+//
+//  raw_sink
+//  Frames appended to one file as raw RGBA
+//
+/////////////////////////////////////////////////
+class raw_sink : public frame_sink {
+public:
+  static frame_sink_ref create(ci::fs::path path);
+
+  raw_sink(ci::fs::path path);
+
+  bool open(ci::ivec2 size, double fps) override;
+
+  void write(const ci::Surface8u & frame, int index) override;
+
+  void close() override;
+
+protected:
+  ci::fs::path path;
+  std::ofstream file;
+};
+
+/////////////////////////////////////////////////
+//
+//  png_sink
+//  A numbered png per frame, ie. frame_000042.png
+//
+/////////////////////////////////////////////////
+class png_sink : public frame_sink {
+public:
+  static frame_sink_ref create(ci::fs::path directory, std::string prefix = "frame_");
+
+  png_sink(ci::fs::path directory, std::string prefix);
+
+  bool open(ci::ivec2 size, double fps) override;
+
+  void write(const ci::Surface8u & frame, int index) override;
+
+protected:
+  ci::fs::path directory;
+  std::string prefix;
+};
+
+/////////////////////////////////////////////////
+//
+//  pipe_sink
+//  Raw RGBA frames written to the stdin of a
+//  command, ie. an encoder. {width}, {height}
+//  and {fps} in the command are replaced, eg.
+//  ffmpeg -f rawvideo -pix_fmt rgba -s {width}x{height}
+//    -r {fps} -i - -pix_fmt yuv420p out.mp4
+//
+/////////////////////////////////////////////////
+class pipe_sink : public frame_sink {
+public:
+  static frame_sink_ref create(std::string command);
+
+  pipe_sink(std::string command);
+
+  ~pipe_sink();
+
+  bool open(ci::ivec2 size, double fps) override;
+
+  void write(const ci::Surface8u & frame, int index) override;
+
+  void close() override;
+
+protected:
+  std::string command;
+  FILE * pipe;
+};
+
+/////////////////////////////////////////////////
+//
+//  offline_renderer
+//  Renders a scene frame by frame into an fbo on
+//  a stepped timeline, as fast as the machine
+//  allows, and streams the frames to a sink
+//
+//  While rendering, sprites without a timeline of
+//  their own animate on the renderer's, and queued
+//  uploads are finished and providers added with
+//  wait_for() done loading before each frame is
+//  drawn, so the same scene always renders the
+//  same frames.
+//  Frames are read back through a ring of pixel
+//  buffers, the sink receives a frame a couple of
+//  frames after it was drawn
+//
+/////////////////////////////////////////////////
+class offline_renderer {
+public:
+  //////////////////////////////////////////////////////
+  // static
+  //////////////////////////////////////////////////////
+  typedef std::shared_ptr<offline_renderer> offline_renderer_ref;
+  typedef std::function<void(double time)> update_fn;
+  typedef std::function<void()> draw_fn;
+
+  static offline_renderer_ref create(ci::ivec2 size, double fps, frame_sink_ref sink, int samples = 0);
+
+  //////////////////////////////////////////////////////
+  // ctr(s) / dctr(s)
+  //////////////////////////////////////////////////////
+  // create on the gl thread
+  offline_renderer(ci::ivec2 size, double fps, frame_sink_ref sink, int samples = 0);
+
+  ~offline_renderer();
+
+  //////////////////////////////////////////////////////
+  // getters
+  //////////////////////////////////////////////////////
+  ci::ivec2 get_size();
+
+  // start new tweens on this timeline to animate in render time
+  ci::TimelineRef get_timeline();
+
+  // the time of the next frame in seconds
+  double get_time();
+
+  int get_frames_rendered();
+
+  // frames per second achieved by the last render()
+  double get_render_fps();
+
+  //////////////////////////////////////////////////////
+  // setters
+  //////////////////////////////////////////////////////
+  // called with the frame's time before it is drawn
+  void set_update_fn(update_fn fn);
+
+  // draws the frame, the fbo is bound and cleared with window matrices
+  void set_draw_fn(draw_fn fn);
+
+  // the longest a frame waits for providers to load before it is drawn anyway
+  void set_load_timeout(double seconds);
+
+  //////////////////////////////////////////////////////
+  // methods
+  //////////////////////////////////////////////////////
+  // updated until it is done loading before each frame, for providers
+  // that load on other threads, ie. tiled images
+  void wait_for(texture_provider_ref provider);
+
+  // render the next frames, returns once the sink has all of them
+  void render(int frames);
+
+  void render_seconds(double seconds);
+
+  // flush and close the sink, further renders reopen it
+  void finish();
+
+protected:
+  //////////////////////////////////////////////////////
+  // properties
+  //////////////////////////////////////////////////////
+  class readback {
+  public:
+    ci::gl::PboRef pbo;
+    GLsync fence = nullptr;
+    int index = -1;
+  };
+
+  ci::ivec2 size;
+  double fps;
+  frame_sink_ref sink;
+  bool sink_open;
+  ci::gl::FboRef fbo;       // drawn into, multisampled when samples > 0
+  ci::gl::FboRef resolved;  // read back from, the same as fbo without samples
+  ci::TimelineRef timeline;
+  std::vector<readback> readbacks;
+  ci::Surface8u frame_surface;
+  update_fn on_update;
+  draw_fn on_draw;
+  std::vector<texture_provider_ref> providers;
+  double load_timeout;
+  int frame;
+  double render_fps;
+
+  //////////////////////////////////////////////////////
+  // methods
+  //////////////////////////////////////////////////////
+  void read(readback & slot);
+
+  // update the providers and finish their uploads until none is loading
+  void load();
+};
+
+//////////////////////////////////////////////////////
+// typedefs
+//////////////////////////////////////////////////////
+typedef offline_renderer::offline_renderer_ref offline_renderer_ref;
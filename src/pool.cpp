@@ -0,0 +1,126 @@
+// std
+#include <algorithm>
+#include <cstdint>
+#include <new>
+
+// sfmoma
+#include "pool.h"
+#include "profiler.h"
+
+namespace {
+  /**
+   * operator new only guarantees max_align_t, over-aligned blocks are
+   * carved from a larger one that is remembered just before the block
+   */
+  void * heap_allocate(size_t bytes, size_t alignment) {
+    if(alignment <= alignof(std::max_align_t)) return ::operator new(bytes);
+    char * raw = (char *)::operator new(bytes + alignment + sizeof(void *));
+    uintptr_t aligned = ((uintptr_t)(raw + sizeof(void *)) + alignment - 1) & ~(uintptr_t)(alignment - 1);
+    ((void **)aligned)[-1] = raw;
+    return (void *)aligned;
+  }
+
+  void heap_deallocate(void * block, size_t alignment) {
+    if(alignment <= alignof(std::max_align_t)) ::operator delete(block);
+    else ::operator delete(((void **)block)[-1]);
+  }
+}
+
+//////////////////////////////////////////////////////
+// ctr(s) / dctr(s)
+//////////////////////////////////////////////////////
+slab_pool::slab_pool(const char * pool_name, size_t slab_blocks) {
+  name = pool_name;
+  blocks_per_slab = std::max<size_t>(slab_blocks, 1);
+  free_list = nullptr;
+  pool_stats.slabs = 0;
+  pool_stats.block_size = 0;
+  pool_stats.live = 0;
+  pool_stats.allocations = 0;
+  pool_stats.recycled = 0;
+  pool_stats.heap_fallbacks = 0;
+}
+
+slab_pool::~slab_pool() {
+  for(char * slab : slabs) delete[] slab;
+}
+
+//////////////////////////////////////////////////////
+// getters
+//////////////////////////////////////////////////////
+slab_pool::stats slab_pool::get_stats() {
+  std::lock_guard<std::mutex> lock(mutex);
+  return pool_stats;
+}
+
+//////////////////////////////////////////////////////
+// methods
+//////////////////////////////////////////////////////
+void * slab_pool::allocate(size_t bytes, size_t alignment) {
+  std::lock_guard<std::mutex> lock(mutex);
+  if(pool_stats.block_size == 0) {
+    // blocks also hold the free list link, and keep every block aligned
+    size_t align = alignof(std::max_align_t);
+    pool_stats.block_size = (std::max(bytes, sizeof(free_block)) + align - 1) / align * align;
+  }
+
+  if(!is_pooled(bytes, alignment)) {
+    pool_stats.heap_fallbacks++;
+    return heap_allocate(bytes, alignment);
+  }
+
+  if(free_list) pool_stats.recycled++;
+  else add_slab();
+
+  free_block * block = free_list;
+  free_list = block->next;
+  pool_stats.live++;
+  pool_stats.allocations++;
+  return block;
+}
+
+void slab_pool::deallocate(void * block, size_t bytes, size_t alignment) {
+  if(!block) return;
+  std::lock_guard<std::mutex> lock(mutex);
+  if(!is_pooled(bytes, alignment)) {
+    heap_deallocate(block, alignment);
+    return;
+  }
+
+  free_block * freed = (free_block *)block;
+  freed->next = free_list;
+  free_list = freed;
+  pool_stats.live--;
+}
+
+void slab_pool::reserve(size_t blocks) {
+  std::lock_guard<std::mutex> lock(mutex);
+  if(pool_stats.block_size == 0) return;
+  size_t available = pool_stats.slabs * blocks_per_slab - pool_stats.live;
+  while(available < blocks) {
+    add_slab();
+    available += blocks_per_slab;
+  }
+}
+
+/**
+ * Carve a new slab into blocks, threaded onto the free list
+ * in address order
+ */
+void slab_pool::add_slab() {
+  size_t bytes = pool_stats.block_size * blocks_per_slab;
+  char * slab = new char[bytes];
+  slabs.push_back(slab);
+  pool_stats.slabs++;
+  SPRITE_PROFILE_ALLOC(name, bytes);
+
+  for(size_t i = blocks_per_slab; i > 0; i--) {
+    free_block * block = (free_block *)(slab + (i - 1) * pool_stats.block_size);
+    block->next = free_list;
+    free_list = block;
+  }
+}
+
+bool slab_pool::is_pooled(size_t bytes, size_t alignment) {
+  return bytes <= pool_stats.block_size && alignment <= alignof(std::max_align_t);
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+// std
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+/////////////////////////////////////////////////
+//
+//  slab_pool
+//  Fixed size blocks carved from slabs, blocks
+//  that are freed go on a free list and are handed
+//  out again, so a steady cycle of creating and
+//  destroying objects never reaches the heap
+//
+//  The block size is set by the first allocation,
+//  larger or more aligned requests fall back to
+//  the heap
+//
+/////////////////////////////////////////////////
+class slab_pool {
+public:
+  class stats {
+  public:
+    size_t slabs;
+    size_t block_size;
+    size_t live;              // blocks handed out and not yet returned
+    uint64_t allocations;     // blocks handed out
+    uint64_t recycled;        // of those, blocks handed out without adding a slab
+    uint64_t heap_fallbacks;  // requests too large or too aligned for a block
+  };
+
+  //////////////////////////////////////////////////////
+  // ctr(s) / dctr(s)
+  //////////////////////////////////////////////////////
+  // name must be a string literal, it is what allocations are profiled under
+  slab_pool(const char * name, size_t blocks_per_slab = 256);
+
+  ~slab_pool();
+
+  //////////////////////////////////////////////////////
+  // getters
+  //////////////////////////////////////////////////////
+  stats get_stats();
+
+  //////////////////////////////////////////////////////
+  // methods
+  //////////////////////////////////////////////////////
+  void * allocate(size_t bytes, size_t alignment);
+
+  // bytes and alignment as allocated, they decide whether the block came from the heap
+  void deallocate(void * block, size_t bytes, size_t alignment);
+
+  // make room for blocks more, once the block size is known
+  void reserve(size_t blocks);
+
+protected:
+  //////////////////////////////////////////////////////
+  // types
+  //////////////////////////////////////////////////////
+  class free_block {
+  public:
+    free_block * next;
+  };
+
+  //////////////////////////////////////////////////////
+  // properties
+  //////////////////////////////////////////////////////
+  const char * name;
+  size_t blocks_per_slab;
+  std::vector<char *> slabs;
+  free_block * free_list;
+  stats pool_stats;
+  std::mutex mutex;
+
+  //////////////////////////////////////////////////////
+  // methods
+  //////////////////////////////////////////////////////
+  void add_slab();
+
+  // whether a request is served from the slabs rather than the heap
+  bool is_pooled(size_t bytes, size_t alignment);
+};
+
+/////////////////////////////////////////////////
+//
+//  pool_allocator
+//  A std allocator drawing from a slab_pool, for
+//  std::allocate_shared, which puts the object
+//  and its reference counts in one block
+//
+/////////////////////////////////////////////////
+template<typename T>
+class pool_allocator {
+public:
+  typedef T value_type;
+
+  pool_allocator(slab_pool & p) : pool(&p) {}
+
+  template<typename U>
+  pool_allocator(const pool_allocator<U> & other) : pool(other.pool) {}
+
+  T * allocate(size_t n) {
+    return (T *)pool->allocate(n * sizeof(T), alignof(T));
+  }
+
+  void deallocate(T * p, size_t n) {
+    pool->deallocate(p, n * sizeof(T), alignof(T));
+  }
+
+  template<typename U>
+  bool operator==(const pool_allocator<U> & other) const { return pool == other.pool; }
+
+  template<typename U>
+  bool operator!=(const pool_allocator<U> & other) const { return pool != other.pool; }
+
+  slab_pool * pool;
+};
@@ -0,0 +1,150 @@
+// std
+#include <algorithm>
+
+// cinder
+#include "cinder/app/App.h"
+#include "cinder/ImageIo.h"
+#include "cinder/Log.h"
+#include "cinder/gl/Texture.h"
+
+// sfmoma
+#include "cache.h"
+#include "color.h"
+#include "memory.h"
+#include "preload.h"
+#include "shader.h"
+
+using namespace ci;
+using namespace ci::app;
+
+////////////////////////////////////////////////////
+//  static
+////////////////////////////////////////////////////
+preloader_ref preloader::create(const preload_manifest & manifest) {
+  return std::make_shared<preloader>(manifest);
+}
+
+//////////////////////////////////////////////////////
+// ctr(s) / dctr(s)
+//////////////////////////////////////////////////////
+preloader::preloader(const preload_manifest & m) : manifest(m), next_asset(0), cancelled(false) {
+  if(manifest.shader_variants.empty()) {
+    for(int variant = 0; variant < sprite_shader::variant_count; variant++) {
+      manifest.shader_variants.push_back(variant);
+    }
+  }
+
+  items_total = manifest.assets.size() + manifest.shader_variants.size() + manifest.render_targets.size();
+  items_done = 0;
+  next_variant = 0;
+  next_target = 0;
+  frame_budget = 4.0;
+  finished = false;
+  timer.start();
+
+  // leave a core for the main thread
+  unsigned int thread_count = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+  thread_count = std::min(thread_count, (unsigned int)manifest.assets.size());
+  for(unsigned int i = 0; i < thread_count; i++) {
+    workers.emplace_back(&preloader::decode, this);
+  }
+}
+
+preloader::~preloader() {
+  cancelled = true;
+  for(auto & worker : workers) {
+    if(worker.joinable()) worker.join();
+  }
+}
+
+//////////////////////////////////////////////////////
+// getters
+//////////////////////////////////////////////////////
+float preloader::get_progress() {
+  if(items_total == 0) return 1.0f;
+  return (float)items_done / (float)items_total;
+}
+
+double preloader::get_elapsed_seconds() {
+  return timer.getSeconds();
+}
+
+bool preloader::is_complete() {
+  return finished;
+}
+
+//////////////////////////////////////////////////////
+// setters
+//////////////////////////////////////////////////////
+void preloader::set_frame_budget(double ms) {
+  frame_budget = std::max(0.0, ms);
+}
+
+//////////////////////////////////////////////////////
+// methods
+//////////////////////////////////////////////////////
+/**
+ * Worker loop, decodes assets until the manifest is exhausted
+ */
+void preloader::decode() {
+  while(!cancelled) {
+    size_t i = next_asset++;
+    if(i >= manifest.assets.size()) break;
+
+    decoded d;
+    d.source = manifest.assets[i];
+    try {
+      d.surface = Surface8u::create(loadImage(loadAsset(d.source)));
+    } catch(const std::exception & e) {
+      CI_LOG_E("Error preloading " << d.source << ": " << e.what());
+    }
+
+    std::lock_guard<std::mutex> lock(decoded_mutex);
+    decoded_queue.push_back(d);
+  }
+}
+
+void preloader::update() {
+  if(finished) return;
+
+  Timer frame_timer(true);
+  auto over_budget = [&] { return frame_timer.getSeconds() * 1000.0 >= frame_budget; };
+  size_t done_before = items_done;
+
+  // shaders first, sprites cannot draw without them
+  while(next_variant < manifest.shader_variants.size() && !over_budget()) {
+    sprite_shader::warm(manifest.shader_variants[next_variant++]);
+    items_done++;
+  }
+
+  while(next_target < manifest.render_targets.size() && !over_budget()) {
+    auto & target = manifest.render_targets[next_target++];
+    fbo_pool::reserve(target.size, target.format, target.count);
+    items_done++;
+  }
+
+  while(!over_budget()) {
+    decoded d;
+    {
+      std::lock_guard<std::mutex> lock(decoded_mutex);
+      if(decoded_queue.empty()) break;
+      d = decoded_queue.front();
+      decoded_queue.pop_front();
+    }
+    if(d.surface) {
+      gl::Texture::Format format = color_policy::get_texture_format();
+      gpu_memory::reserve(gpu_memory::get_texture_bytes(d.surface->getSize(), format.getInternalFormat()));
+      texture_cache::put(d.source, gl::Texture::create(*d.surface, format));
+    }
+    items_done++;
+  }
+
+  if(items_done != done_before) progress_update.emit(get_progress());
+
+  if(items_done == items_total) {
+    finished = true;
+    timer.stop();
+    CI_LOG_I("Preloaded " << items_total << " items in " << timer.getSeconds() << "s");
+    complete.emit();
+  }
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+// std
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// cinder
+#include "cinder/Signals.h"
+#include "cinder/Surface.h"
+#include "cinder/Timer.h"
+#include "cinder/gl/Fbo.h"
+
+/////////////////////////////////////////////////
+//
+//  preload_manifest
+//  Everything a show needs resident before
+//  its first frame
+//
+/////////////////////////////////////////////////
+class preload_manifest {
+public:
+  class render_target {
+  public:
+    render_target(ci::ivec2 target_size, int target_count, ci::gl::Fbo::Format target_format)
+      : size(target_size), count(target_count), format(target_format) {};
+
+    ci::ivec2 size;
+    int count;
+    ci::gl::Fbo::Format format;
+  };
+
+  std::vector<std::string> assets;            // asset paths, as given to image_provider::set_source
+  std::vector<int> shader_variants;           // sprite_shader variants, empty warms all of them
+  std::vector<render_target> render_targets;  // fbos to reserve in the fbo_pool, see sprite::get_fbo_format
+};
+
+/////////////////////////////////////////////////
+//
+//  preloader
+//  Decodes assets on worker threads and uploads
+//  them within a per-frame budget
+//
+/////////////////////////////////////////////////
+class preloader {
+public:
+  //////////////////////////////////////////////////////
+  // static
+  //////////////////////////////////////////////////////
+  typedef std::shared_ptr<preloader> preloader_ref;
+
+  static preloader_ref create(const preload_manifest & manifest);
+
+  //////////////////////////////////////////////////////
+  // ctr(s) / dctr(s)
+  //////////////////////////////////////////////////////
+  preloader(const preload_manifest & manifest);
+
+  ~preloader();
+
+  //////////////////////////////////////////////////////
+  // getters
+  //////////////////////////////////////////////////////
+  // fraction of the manifest that is resident, 0 - 1
+  float get_progress();
+
+  // seconds since the preloader started, frozen at completion
+  double get_elapsed_seconds();
+
+  bool is_complete();
+
+  //////////////////////////////////////////////////////
+  // setters
+  //////////////////////////////////////////////////////
+  // milliseconds of gpu work update() may spend per frame
+  void set_frame_budget(double ms);
+
+  //////////////////////////////////////////////////////
+  // properties
+  //////////////////////////////////////////////////////
+  ci::signals::Signal<void(float)> progress_update;
+  ci::signals::Signal<void()> complete;
+
+  //////////////////////////////////////////////////////
+  // methods
+  //////////////////////////////////////////////////////
+  // upload decoded work, call once per frame from the gl thread
+  void update();
+
+protected:
+  //////////////////////////////////////////////////////
+  // properties
+  //////////////////////////////////////////////////////
+  class decoded {
+  public:
+    std::string source;
+    ci::Surface8uRef surface;
+  };
+
+  preload_manifest manifest;
+  std::vector<std::thread> workers;
+  std::atomic<size_t> next_asset;
+  std::atomic<bool> cancelled;
+  std::mutex decoded_mutex;
+  std::deque<decoded> decoded_queue;
+  size_t items_total;
+  size_t items_done;
+  size_t next_variant;
+  size_t next_target;
+  double frame_budget;
+  bool finished;
+  ci::Timer timer;
+
+  //////////////////////////////////////////////////////
+  // methods
+  //////////////////////////////////////////////////////
+  void decode();
+};
+
+//////////////////////////////////////////////////////
+// typedefs
+//////////////////////////////////////////////////////
+typedef preloader::preloader_ref preloader_ref;
@@ -0,0 +1,231 @@
+// sfmoma
+#include "profiler.h"
+
+#if defined( CINDER_SPRITE_PROFILING )
+
+// std
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// cinder
+#include "cinder/gl/platform.h"
+
+namespace {
+  enum event_kind : uint8_t {
+    Cpu,
+    Gpu,
+    Allocation
+  };
+
+  class event {
+  public:
+    const char * name;
+    uint64_t start;
+    uint64_t duration;
+    uint64_t bytes;
+    uint32_t thread;
+    event_kind kind;
+  };
+
+  class gpu_timing {
+  public:
+    const char * name;
+    GLuint begin;
+    GLuint end;
+    bool ended;
+  };
+
+  class allocation_total {
+  public:
+    uint64_t count = 0;
+    uint64_t bytes = 0;
+  };
+
+  std::mutex ring_mutex;
+  std::vector<event> ring(1 << 16);
+  uint64_t ring_head = 0;
+
+  std::mutex allocation_mutex;
+  std::map<std::string, allocation_total> allocations;
+  std::map<std::string, uint64_t> counters;
+
+  // gpu timings are only taken on the thread frame() is called from,
+  // scopes on loader and worker threads are cpu only
+  std::atomic<std::thread::id> gl_thread;
+  std::vector<gpu_timing> gpu_timings;
+  std::vector<GLuint> free_queries;
+  int64_t gpu_offset = 0;
+  bool gpu_synced = false;
+
+  const uint32_t gpu_thread = 1000;
+
+  uint64_t now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+  uint32_t thread_index() {
+    static std::atomic<uint32_t> next(0);
+    thread_local uint32_t index = next++;
+    return index;
+  }
+
+  void record(const event & e) {
+    std::lock_guard<std::mutex> lock(ring_mutex);
+    ring[ring_head++ % ring.size()] = e;
+  }
+
+  GLuint take_query() {
+    if(free_queries.empty()) {
+      GLuint queries[16];
+      glGenQueries(16, queries);
+      free_queries.insert(free_queries.end(), queries, queries + 16);
+    }
+    GLuint query = free_queries.back();
+    free_queries.pop_back();
+    return query;
+  }
+}
+
+/////////////////////////////////////////////////
+//
+//  sprite_profiler
+//
+/////////////////////////////////////////////////
+void sprite_profiler::frame() {
+  gl_thread = std::this_thread::get_id();
+
+#if ! defined( CINDER_GL_ES )
+  // line the gpu clock up with ours once
+  if(!gpu_synced) {
+    GLint64 gpu_now = 0;
+    glGetInteger64v(GL_TIMESTAMP, &gpu_now);
+    gpu_offset = (int64_t)now() - (int64_t)gpu_now;
+    gpu_synced = true;
+  }
+
+  auto it = gpu_timings.begin();
+  while(it != gpu_timings.end()) {
+    GLint available = 0;
+    if(it->ended) glGetQueryObjectiv(it->end, GL_QUERY_RESULT_AVAILABLE, &available);
+    if(!available) {
+      ++it;
+      continue;
+    }
+
+    GLuint64 begin = 0, end = 0;
+    glGetQueryObjectui64v(it->begin, GL_QUERY_RESULT, &begin);
+    glGetQueryObjectui64v(it->end, GL_QUERY_RESULT, &end);
+    record({ it->name, (uint64_t)((int64_t)begin + gpu_offset), end - begin, 0, gpu_thread, Gpu });
+    free_queries.push_back(it->begin);
+    free_queries.push_back(it->end);
+    it = gpu_timings.erase(it);
+  }
+#endif
+}
+
+void sprite_profiler::count_allocation(const char * category, size_t bytes) {
+  uint64_t total;
+  {
+    std::lock_guard<std::mutex> lock(allocation_mutex);
+    auto & a = allocations[category];
+    a.count++;
+    a.bytes += bytes;
+    total = a.bytes;
+  }
+  record({ category, now(), 0, total, thread_index(), Allocation });
+}
+
+uint64_t sprite_profiler::get_allocation_count(const std::string & category) {
+  std::lock_guard<std::mutex> lock(allocation_mutex);
+  return allocations[category].count;
+}
+
+uint64_t sprite_profiler::get_allocation_bytes(const std::string & category) {
+  std::lock_guard<std::mutex> lock(allocation_mutex);
+  return allocations[category].bytes;
+}
+
+void sprite_profiler::count(const char * counter, uint64_t n) {
+  std::lock_guard<std::mutex> lock(allocation_mutex);
+  counters[counter] += n;
+}
+
+uint64_t sprite_profiler::get_count(const std::string & counter) {
+  std::lock_guard<std::mutex> lock(allocation_mutex);
+  return counters[counter];
+}
+
+void sprite_profiler::set_capacity(size_t events) {
+  std::lock_guard<std::mutex> lock(ring_mutex);
+  ring.assign(std::max<size_t>(events, 1), event());
+  ring_head = 0;
+}
+
+void sprite_profiler::clear() {
+  {
+    std::lock_guard<std::mutex> lock(ring_mutex);
+    ring_head = 0;
+  }
+  std::lock_guard<std::mutex> lock(allocation_mutex);
+  allocations.clear();
+  counters.clear();
+}
+
+bool sprite_profiler::write_chrome_trace(const std::string & path) {
+  std::ofstream out(path);
+  if(!out) return false;
+
+  std::lock_guard<std::mutex> lock(ring_mutex);
+  uint64_t head = ring_head;
+  uint64_t count = std::min<uint64_t>(head, ring.size());
+  out << "{\"traceEvents\":[\n";
+  out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << gpu_thread << ",\"args\":{\"name\":\"gpu\"}}";
+  for(uint64_t i = head - count; i < head; i++) {
+    const event & e = ring[i % ring.size()];
+    out << ",\n{\"name\":\"" << e.name << "\",\"pid\":0,\"tid\":" << e.thread
+        << ",\"ts\":" << e.start / 1000.0;
+    if(e.kind == Allocation) {
+      out << ",\"ph\":\"C\",\"args\":{\"bytes\":" << e.bytes << "}}";
+    } else {
+      out << ",\"ph\":\"X\",\"dur\":" << e.duration / 1000.0 << "}";
+    }
+  }
+  out << "\n]}\n";
+  return true;
+}
+
+//////////////////////////////////////////////////////
+// scope
+//////////////////////////////////////////////////////
+sprite_profiler::scope::scope(const char * n) : name(n), gpu_query(-1) {
+#if ! defined( CINDER_GL_ES )
+  // timestamps rather than elapsed time queries, which can not nest
+  if(std::this_thread::get_id() == gl_thread) {
+    gpu_timing timing = { name, take_query(), take_query(), false };
+    glQueryCounter(timing.begin, GL_TIMESTAMP);
+    gpu_query = (int)gpu_timings.size();
+    gpu_timings.push_back(timing);
+  }
+#endif
+  start = now();
+}
+
+sprite_profiler::scope::~scope() {
+  uint64_t end = now();
+#if ! defined( CINDER_GL_ES )
+  if(gpu_query >= 0) {
+    glQueryCounter(gpu_timings[gpu_query].end, GL_TIMESTAMP);
+    gpu_timings[gpu_query].ended = true;
+  }
+#endif
+  record({ name, start, end - start, 0, thread_index(), Cpu });
+}
+
+#endif
@@ -0,0 +1,84 @@
+#pragma once
+
+// std
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/////////////////////////////////////////////////
+//
+//  sprite_profiler
+//  Scoped cpu / gpu timers and allocation
+//  counters recorded into a ring buffer and
+//  exported as a Chrome trace
+//
+//  Define CINDER_SPRITE_PROFILING to enable,
+//  otherwise the macros below compile to nothing
+//
+/////////////////////////////////////////////////
+#if defined( CINDER_SPRITE_PROFILING )
+
+#define SPRITE_PROFILE_CONCAT_INNER(a, b) a##b
+#define SPRITE_PROFILE_CONCAT(a, b) SPRITE_PROFILE_CONCAT_INNER(a, b)
+
+// time the enclosing block on the cpu and gpu, name must be a string literal
+#define SPRITE_PROFILE_SCOPE(name) \
+  sprite_profiler::scope SPRITE_PROFILE_CONCAT(sprite_profile_scope_, __LINE__)(name)
+
+// count an allocation of a texture, fbo etc.
+#define SPRITE_PROFILE_ALLOC(category, bytes) \
+  sprite_profiler::count_allocation(category, bytes)
+
+// add to a named counter, ie. draw calls
+#define SPRITE_PROFILE_COUNT(counter, n) \
+  sprite_profiler::count(counter, n)
+
+class sprite_profiler {
+public:
+  //////////////////////////////////////////////////////
+  // static
+  //////////////////////////////////////////////////////
+  // gather finished gpu timings, call once per frame from the gl thread
+  // outside of any profiled scope, scopes on other threads are timed on the cpu only
+  static void frame();
+
+  static void count_allocation(const char * category, size_t bytes);
+
+  static uint64_t get_allocation_count(const std::string & category);
+
+  static uint64_t get_allocation_bytes(const std::string & category);
+
+  static void count(const char * counter, uint64_t n);
+
+  static uint64_t get_count(const std::string & counter);
+
+  // the number of events the ring buffer holds before overwriting the oldest
+  static void set_capacity(size_t events);
+
+  static void clear();
+
+  // write the recorded events in the Chrome trace event format (chrome://tracing)
+  static bool write_chrome_trace(const std::string & path);
+
+  //////////////////////////////////////////////////////
+  // scope
+  //////////////////////////////////////////////////////
+  class scope {
+  public:
+    scope(const char * name);
+    ~scope();
+
+  private:
+    const char * name;
+    uint64_t start;
+    int gpu_query;
+  };
+};
+
+#else
+
+#define SPRITE_PROFILE_SCOPE(name)
+#define SPRITE_PROFILE_ALLOC(category, bytes)
+#define SPRITE_PROFILE_COUNT(counter, n)
+
+#endif
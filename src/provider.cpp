@@ -1,24 +1,122 @@
+  // std
+#include <algorithm>
+#include <cstring>
+
   // cinder
 #include "cinder/app/App.h"
+#include "cinder/ImageIo.h"
 #include "cinder/Log.h"
 
   // sfmoma
+#include "archive.h"
+#include "cache.h"
+#include "color.h"
+#include "context.h"
+#include "memory.h"
+#include "profiler.h"
 #include "provider.h"
 
 using namespace ci;
 using namespace ci::app;
 using namespace ci::qtime;
 
+namespace {
+  // never destroyed, providers held in statics may outlive it
+  slab_pool & get_image_pool() {
+    static slab_pool * pool = new slab_pool("image_provider");
+    return *pool;
+  }
+
+  uint64_t update_count = 0;
+  uint64_t notify_count = 0;
+}
+
 /////////////////////////////////////////////////
 //
 //  texture_provider
 //  Base class for texture providers
 //
 /////////////////////////////////////////////////
+uint64_t texture_provider::get_update_count() {
+  return update_count;
+}
+
+uint64_t texture_provider::get_notify_count() {
+  return notify_count;
+}
+
+void texture_provider::reset_update_stats() {
+  update_count = 0;
+  notify_count = 0;
+}
+
 void texture_provider::set_texture(const gl::TextureRef & newTexture) {
   texture_is_new = true;
   texture = newTexture;
-  texture_update.emit();
+  queue_update(newTexture ? newTexture->getBounds() : Area(0, 0, 0, 0));
+}
+
+void texture_provider::set_texture_changed(const Area & area) {
+  texture_is_new = true;
+  queue_update(area);
+}
+
+/**
+ * Changes are held until the next delivery, however many arrive
+ * in between the listeners hear once, about the union of them
+ */
+void texture_provider::queue_update(const Area & changed) {
+  revision++;
+  update_count++;
+  if(update_pending) {
+    pending_changes.include(changed);
+  } else {
+    pending_changes = changed;
+    update_pending = true;
+  }
+  for(texture_listener * listener = listeners; listener; listener = listener->next_listener) {
+    listener->on_provider_texture_queued(changed);
+  }
+}
+
+void texture_provider::deliver_updates() {
+  if(!update_pending) return;
+  update_pending = false;
+  if(!listeners) return;
+  notify_count++;
+  notify_listeners(pending_changes);
+}
+
+void texture_provider::notify_listeners(const Area & changed) {
+  for(texture_listener * listener = listeners; listener;) {
+    texture_listener * next = listener->next_listener;
+    listener->on_provider_texture_update(changed);
+    listener = next;
+  }
+}
+
+texture_listener::~texture_listener() {
+  if(listening) listening->remove_listener(this);
+}
+
+void texture_provider::add_listener(texture_listener * listener) {
+  if(!listener || listener->listening == this) return;
+  if(listener->listening) listener->listening->remove_listener(listener);
+  listener->listening = this;
+  listener->previous_listener = nullptr;
+  listener->next_listener = listeners;
+  if(listeners) listeners->previous_listener = listener;
+  listeners = listener;
+}
+
+void texture_provider::remove_listener(texture_listener * listener) {
+  if(!listener || listener->listening != this) return;
+  if(listener->previous_listener) listener->previous_listener->next_listener = listener->next_listener;
+  else listeners = listener->next_listener;
+  if(listener->next_listener) listener->next_listener->previous_listener = listener->previous_listener;
+  listener->listening = nullptr;
+  listener->previous_listener = nullptr;
+  listener->next_listener = nullptr;
 }
 
 std::string texture_provider::get_source() {
@@ -34,21 +132,102 @@ bool texture_provider::has_new_texture() {
   return texture_is_new;
 }
 
+bool texture_provider::is_visible() {
+  return visible_frame > 0 && visible_frame + 1 >= upload_scheduler::get_frame();
+}
+
+void texture_provider::mark_visible() {
+  visible_frame = std::max<uint64_t>(upload_scheduler::get_frame(), 1);
+}
+
+void texture_provider::schedule(size_t bytes, upload_scheduler::work_fn work) {
+  upload_scheduler::submit(this, bytes, work);
+}
+
+/**
+ * Upload part of a surface with glTexSubImage2D, so the cost is the size of
+ * the area rather than the texture. The rows are packed into one of a pair of
+ * pbos, orphaned on each use, so the copy never waits on the previous upload
+ */
+void texture_provider::update_region(const Surface8u & surface, const Area & area) {
+  if(!texture || texture->getSize() != surface.getSize()) {
+    set_texture(gl::Texture::create(surface, color_policy::get_texture_format()));
+    return;
+  }
+
+  Area clipped = area.getClipBy(texture->getBounds());
+  if(clipped.getWidth() <= 0 || clipped.getHeight() <= 0) return;
+
+  GLint data_format;
+  GLenum data_type;
+  gl::TextureBase::SurfaceChannelOrderToDataFormatAndType(surface.getChannelOrder(), &data_format, &data_type);
+
+  size_t row_bytes = clipped.getWidth() * surface.getPixelInc();
+  size_t bytes = row_bytes * clipped.getHeight();
+  int height = texture->getHeight();
+
+  // textures that are not top down store their rows bottom up
+  bool flip = !texture->isTopDown();
+  int y_offset = flip ? height - clipped.y2 : clipped.y1;
+  auto copy_rows = [&](uint8_t * dst) {
+    for(int row = 0; row < clipped.getHeight(); row++) {
+      int y = flip ? clipped.y2 - 1 - row : clipped.y1 + row;
+      std::memcpy(dst + row * row_bytes, surface.getData(ivec2(clipped.x1, y)), row_bytes);
+    }
+  };
+
+  // rows are tightly packed
+  gl::ScopedTextureBind scoped_texture(texture);
+  GLint unpack_alignment;
+  glGetIntegerv(GL_UNPACK_ALIGNMENT, &unpack_alignment);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+#if defined( CINDER_GL_ES_2 )
+  std::vector<uint8_t> packed(bytes);
+  copy_rows(packed.data());
+  glTexSubImage2D(texture->getTarget(), 0, clipped.x1, y_offset, clipped.getWidth(), clipped.getHeight(),
+    data_format, data_type, packed.data());
+#else
+  if(upload_pbos.empty()) upload_pbos.resize(2);
+  gl::PboRef & pbo = upload_pbos[upload_pbo_index++ % upload_pbos.size()];
+  if(!pbo || pbo->getSize() < bytes) {
+    pbo = gl::Pbo::create(GL_PIXEL_UNPACK_BUFFER, bytes, nullptr, GL_STREAM_DRAW);
+    gpu_memory::track(pbo, "pbo", "texture_provider", bytes);
+  }
+
+  gl::ScopedBuffer scoped_pbo(pbo);
+  uint8_t * mapped = (uint8_t *)pbo->mapBufferRange(0, bytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+  if(mapped) {
+    copy_rows(mapped);
+    pbo->unmap();
+    glTexSubImage2D(texture->getTarget(), 0, clipped.x1, y_offset, clipped.getWidth(), clipped.getHeight(),
+      data_format, data_type, nullptr);
+  }
+#endif
+  glPixelStorei(GL_UNPACK_ALIGNMENT, unpack_alignment);
+
+  SPRITE_PROFILE_COUNT("upload_bytes", bytes);
+  set_texture_changed(clipped);
+}
+
 /////////////////////////////////////////////////
 //
 //  image_provider
 //
 /////////////////////////////////////////////////
 image_provider_ref image_provider::create(std::string filename){
-  return std::make_shared<image_provider>(filename);
+  return std::allocate_shared<image_provider>(pool_allocator<image_provider>(get_image_pool()), filename);
 }
 
 image_provider_ref image_provider::create(gl::TextureRef tex){
-  return std::make_shared<image_provider>(tex);
+  return std::allocate_shared<image_provider>(pool_allocator<image_provider>(get_image_pool()), tex);
 }
 
 image_provider_ref image_provider::create(){
-  return std::make_shared<image_provider>();
+  return std::allocate_shared<image_provider>(pool_allocator<image_provider>(get_image_pool()));
+}
+
+slab_pool::stats image_provider::get_pool_stats() {
+  return get_image_pool().get_stats();
 }
 
 image_provider::image_provider(std::string filename) {
@@ -65,11 +244,70 @@ image_provider::image_provider() {
 
 void image_provider::set_source(std::string path) {
   source = path;
-  set_texture(gl::Texture::create(ci::loadImage(ci::app::loadAsset(path))));
+  
+  // prefer a texture that was preloaded by sprite::init
+  gl::TextureRef cached = texture_cache::get(path);
+  if(cached) {
+    set_texture(cached);
+    return;
+  }
+  
+  // then a mounted archive, uploaded straight from the mapped pages
+  asset_archive::entry packed;
+  if(asset_archive::find_mounted(path, packed)) {
+    pending_size = vec2(packed.width, packed.height);
+    schedule(packed.size, [=] {
+      gpu_memory::reserve(packed.size);
+      gl::TextureRef uploaded = asset_archive::create_texture(packed);
+      gpu_memory::track(uploaded, "image_provider");
+      set_texture(uploaded);
+      return packed.size;
+    });
+    return;
+  }
+  
+  // decode now, upload when the scheduler has budget for it
+  ImageSourceRef image = ci::loadImage(ci::app::loadAsset(path));
+  color_policy::content content(8, image->hasAlpha());
+  if(image->getDataType() == ImageIo::UINT16) content.bits = 16;
+  if(image->getDataType() == ImageIo::FLOAT16 || image->getDataType() == ImageIo::FLOAT32) {
+    content.bits = 16;
+    content.extended_range = true;
+  }
+
+  // only keep the depth when the policy has a format that holds it
+  gl::Texture::Format format = color_policy::get_texture_format(content);
+  GLint internal_format = format.getInternalFormat();
+  if(color_policy::get_format(internal_format) == pixel_format::RGB10_A2 ||
+     color_policy::get_format(internal_format) == pixel_format::RGBA16F) {
+    Surface32fRef surface = Surface32f::create(image);
+    pending_size = surface->getSize();
+    size_t bytes = surface->getRowBytes() * surface->getHeight();
+    schedule(bytes, [=] {
+      gpu_memory::reserve(gpu_memory::get_texture_bytes(surface->getSize(), internal_format));
+      gl::TextureRef uploaded = gl::Texture::create(*surface, format);
+      gpu_memory::track(uploaded, "image_provider");
+      set_texture(uploaded);
+      return bytes;
+    });
+    return;
+  }
+
+  Surface8uRef surface = Surface8u::create(image);
+  pending_size = surface->getSize();
+  size_t bytes = surface->getRowBytes() * surface->getHeight();
+  schedule(bytes, [=] {
+    gpu_memory::reserve(gpu_memory::get_texture_bytes(surface->getSize(), internal_format));
+    gl::TextureRef uploaded = gl::Texture::create(*surface, format);
+    gpu_memory::track(uploaded, "image_provider");
+    set_texture(uploaded);
+    return bytes;
+  });
 }
 
 vec2 image_provider::get_size() { 
-  return texture->getSize();
+  // the scheduled image's size until its upload lands, so it can be laid out right away
+  return texture ? vec2(texture->getSize()) : pending_size;
 }
 
 bool image_provider::is_ready() {
@@ -81,13 +319,67 @@ bool image_provider::is_ready() {
 //  graphics_provider
 //
 /////////////////////////////////////////////////
-graphics_provider::graphics_provider(ci::vec2 size, bool transparent) {
+namespace {
+  uint64_t resolve_count = 0;
+  uint64_t resolve_bytes = 0;
+}
+
+uint64_t graphics_provider::get_resolve_count() {
+  return resolve_count;
+}
+
+uint64_t graphics_provider::get_resolve_bytes() {
+  return resolve_bytes;
+}
+
+void graphics_provider::reset_resolve_stats() {
+  resolve_count = 0;
+  resolve_bytes = 0;
+}
+
+graphics_provider::graphics_provider(ci::vec2 size, bool transparent, int sample_count) {
+  // the fbos are only valid in the context that creates them
+  resource_context::scope scoped_context;
+  samples = std::max(sample_count, 0);
+#if defined( CINDER_GL_ES_2 )
+  // no multisampled renderbuffers or blits
+  samples = 0;
+#endif
+  gl::Texture::Format color_format = gl::Fbo::Format::getDefaultColorTextureFormat(transparent);
+  if(color_policy::is_linear_blending()) {
+    // sRGB8 alone is not required to be renderable
+    color_format.setInternalFormat(color_policy::get_internal_format(color_policy::select()));
+  }
   gl::Fbo::Format format;
-  format.setSamples(4);
-  format.setColorTextureFormat(
-    gl::Fbo::Format::getDefaultColorTextureFormat(transparent));
-  fbo = ci::gl::Fbo::create(size.x, size.y, format);
+  format.setColorTextureFormat(color_format);
+
+  if(samples > 0) {
+    // draw into multisampled renderbuffers and resolve into a plain texture ourselves,
+    // a multisampled fbo's color texture would resolve on every access
+    GLint internal_format = color_format.getInternalFormat();
+    size_t color_bytes = gpu_memory::get_texture_bytes(size, internal_format, false, samples);
+    size_t depth_bytes = gpu_memory::get_texture_bytes(size, GL_DEPTH_COMPONENT24, false, samples);
+    gpu_memory::reserve(color_bytes + depth_bytes);
+    auto color = gl::Renderbuffer::create(size.x, size.y, internal_format, samples);
+    auto depth = gl::Renderbuffer::create(size.x, size.y, GL_DEPTH_COMPONENT24, samples);
+    gpu_memory::track(color, "renderbuffer", "graphics_provider", color_bytes);
+    gpu_memory::track(depth, "renderbuffer", "graphics_provider", depth_bytes);
+    fbo = gl::Fbo::create(size.x, size.y, gl::Fbo::Format().disableColor().disableDepth()
+      .attachment(GL_COLOR_ATTACHMENT0, color)
+      .attachment(GL_DEPTH_ATTACHMENT, depth));
+
+    format.disableDepth();
+    gpu_memory::reserve(gpu_memory::get_fbo_bytes(size, format));
+    resolved = gl::Fbo::create(size.x, size.y, format);
+    gpu_memory::track(resolved, "graphics_provider");
+  } else {
+    gpu_memory::reserve(gpu_memory::get_fbo_bytes(size, format));
+    fbo = gl::Fbo::create(size.x, size.y, format);
+    gpu_memory::track(fbo, "graphics_provider");
+    resolved = fbo;
+  }
   background = ColorA(0, 0, 0, 0);
+  pending_area = Area(0, 0, 0, 0);
 }
 
 vec2 graphics_provider::get_size() {
@@ -104,15 +396,60 @@ void graphics_provider::set_background(ColorA c) {
 }
 
 void graphics_provider::update() {
-  if(fbo) {
-    gl::ScopedFramebuffer scoped_fbo(fbo);
-    gl::ScopedMatrices scoped_matrices;
-    gl::ScopedViewport scoped_viewport(ivec2(0), fbo->getSize());
-    gl::setMatricesWindow(fbo->getSize());
-    gl::clear(background);
-    draw();
-    set_texture(fbo->getColorTexture());
+  if(fbo) update(fbo->getBounds());
+}
+
+/**
+ * Redraw only area, top-left origin. Pending areas merge until the
+ * scheduler runs the update, then draw() is clipped to them with a
+ * scissor and only they are resolved
+ */
+void graphics_provider::update(const Area & area) {
+  if(!fbo) return;
+  Area clipped = area.getClipBy(fbo->getBounds());
+  if(clipped.getWidth() <= 0 || clipped.getHeight() <= 0) return;
+
+  if(pending_area.getWidth() > 0 && pending_area.getHeight() > 0) {
+    pending_area.include(clipped);
+  } else {
+    pending_area = clipped;
   }
+
+  size_t bytes = pending_area.getWidth() * pending_area.getHeight() * 4;
+  schedule(bytes, [=] {
+    SPRITE_PROFILE_SCOPE("graphics_provider::update");
+    Area changed = pending_area;
+    pending_area = Area(0, 0, 0, 0);
+
+    // fbo rows are bottom up
+    int height = fbo->getHeight();
+    Area gl_area(changed.x1, height - changed.y2, changed.x2, height - changed.y1);
+    bool partial = changed != fbo->getBounds();
+    {
+      gl::ScopedFramebuffer scoped_fbo(fbo);
+      gl::ScopedMatrices scoped_matrices;
+      gl::ScopedViewport scoped_viewport(ivec2(0), fbo->getSize());
+      gl::ScopedScissor scoped_scissor(gl_area.x1, gl_area.y1, gl_area.getWidth(), gl_area.getHeight());
+      gl::setMatricesWindow(fbo->getSize());
+      gl::clear(background);
+      draw();
+    }
+#if ! defined( CINDER_GL_ES_2 )
+    if(resolved != fbo) {
+      fbo->blitTo(resolved, gl_area, gl_area);
+      resolve_count++;
+      resolve_bytes += bytes * samples;
+      SPRITE_PROFILE_COUNT("resolves", 1);
+    }
+#endif
+    gl::TextureRef color = resolved->getColorTexture();
+    if(partial && texture == color) {
+      set_texture_changed(changed);
+    } else {
+      set_texture(color);
+    }
+    return bytes;
+  });
 }
 
 /////////////////////////////////////////////////
@@ -157,9 +494,14 @@ void video_provider::update() {
   if(movie) {
     if(movie->isPlaying()) {
       if(movie->checkNewFrame()) {
-        if(movie->getTexture()) {
-          set_texture(movie->getTexture());
-        }
+        size_t bytes = movie->getWidth() * movie->getHeight() * 4;
+        schedule(bytes, [=] {
+          SPRITE_PROFILE_SCOPE("video_provider::update");
+          if(movie && movie->getTexture()) {
+            set_texture(movie->getTexture());
+          }
+          return bytes;
+        });
       }
     }
   }
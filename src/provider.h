@@ -1,15 +1,63 @@
 #pragma once
 
   // cinder
+#include "cinder/Area.h"
+#include "cinder/Surface.h"
+#include "cinder/gl/Pbo.h"
 #include "cinder/gl/Texture.h"
 #include "cinder/qtime/QuickTimeGl.h"
 
+  // sfmoma
+#include "pool.h"
+#include "scheduler.h"
+
 
 enum class provider_type {
   None,
   Image,
   Graphics,
-  Video
+  Video,
+  Buffer,
+  Text
+};
+
+class texture_provider;
+
+/////////////////////////////////////////////////
+//
+//  texture_listener
+//  Told when a provider's texture changes, the
+//  links live in the listener so listening does
+//  not allocate
+//
+/////////////////////////////////////////////////
+class texture_listener {
+  friend class texture_provider;
+
+public:
+  texture_listener() {}
+
+  // a copy does not listen until added
+  texture_listener(const texture_listener &) {}
+
+  texture_listener & operator=(const texture_listener &) { return *this; }
+
+  // stops listening, so the provider is not left holding the listener
+  virtual ~texture_listener();
+
+  // changed is the area that changed, top-left origin within the provider's
+  // get_size(), the whole area when the texture was replaced
+  virtual void on_provider_texture_update(const ci::Area & changed) = 0;
+
+  // changed was queued, it is delivered to on_provider_texture_update when next asked for
+  virtual void on_provider_texture_queued(const ci::Area & changed) {}
+
+  texture_listener * get_next_listener() { return next_listener; }
+
+protected:
+  texture_provider * listening = nullptr;
+  texture_listener * previous_listener = nullptr;
+  texture_listener * next_listener = nullptr;
 };
 
 /////////////////////////////////////////////////
@@ -21,11 +69,23 @@ enum class provider_type {
 class texture_provider {
 public:
   ~texture_provider() {
+    while(listeners) remove_listener(listeners);
+    upload_scheduler::cancel(this);
     source = "";
     ready = false;
     texture.reset();
   }
   
+  //////////////////////////////////////////////////////
+  // static
+  //////////////////////////////////////////////////////
+  // texture changes across all providers, and the notifications they were coalesced into
+  static uint64_t get_update_count();
+  
+  static uint64_t get_notify_count();
+  
+  static void reset_update_stats();
+  
   //////////////////////////////////////////////////////
   // getters
   //////////////////////////////////////////////////////
@@ -34,12 +94,37 @@ public:
   
   bool has_new_texture();
   
+  // incremented by every texture change
+  uint64_t get_revision() { return revision; }
+  
+  texture_listener * get_first_listener() { return listeners; }
+  
   std::string get_source();
   
+  // whether a sprite drew this provider in the current or previous frame
+  bool is_visible();
+  
+  // whether changes are waiting for the next deliver_updates()
+  bool has_pending_updates() { return update_pending; }
+  
   //////////////////////////////////////////////////////
-  // properties
+  // methods
   //////////////////////////////////////////////////////
-  ci::signals::Signal<void()> texture_update;
+  // called by sprites as they draw, visible providers are uploaded first
+  void mark_visible();
+  
+  // upload the area of surface into the same area of the texture, streamed
+  // through a pbo, surface is the size of the texture and area is top-left origin
+  void update_region(const ci::Surface8u & surface, const ci::Area & area);
+  
+  // a listener hears from one provider at a time, adding it here removes it from any other
+  void add_listener(texture_listener * listener);
+  
+  void remove_listener(texture_listener * listener);
+  
+  // tell the listeners about the changes since the last call, in one notification
+  // covering them all, sprites call it as they are drawn or measured
+  void deliver_updates();
   
   //////////////////////////////////////////////////////
   // virtual methods
@@ -54,6 +139,21 @@ public:
   
   virtual provider_type get_type() { return provider_type::None; }
   
+  // providers that stream their content can render a normalized region of it
+  // themselves, returning true tells the sprite to skip its own zoom
+  virtual bool set_view_area(const ci::Rectf & normalized_area) { return false; }
+  
+  // the region of the texture holding the content, for providers that share
+  // one texture between several images (ie. the frames of an atlas)
+  virtual ci::Area get_source_area() { return ci::Area(ci::ivec2(0), ci::ivec2(get_size())); }
+  
+  // whether get_source_area() moves within a texture that stays the same, sprites
+  // that are not zoomed draw such a provider straight from its texture, uncomposited
+  virtual bool is_atlas() { return false; }
+  
+  // whether content is still arriving from another thread, ie. tiles being decoded
+  virtual bool is_loading() { return false; }
+  
 protected:
   //////////////////////////////////////////////////////
   // properties
@@ -63,11 +163,30 @@ protected:
   std::string source;
   bool texture_is_new;
   bool media_is_looping;
+  uint64_t visible_frame = 0;
+  std::vector<ci::gl::PboRef> upload_pbos;
+  size_t upload_pbo_index = 0;
+  texture_listener * listeners = nullptr;
+  uint64_t revision = 0;
+  bool update_pending = false;
+  ci::Area pending_changes = ci::Area(0, 0, 0, 0);
   
   //////////////////////////////////////////////////////
   // methods
   //////////////////////////////////////////////////////
+  // tell the listeners, a listener may remove itself but no other
+  void notify_listeners(const ci::Area & changed);
+  
+  // record a change for the next deliver_updates()
+  void queue_update(const ci::Area & changed);
+  
   void set_texture(const ci::gl::TextureRef & new_texture);
+  
+  // the texture was modified in place, only area changed
+  void set_texture_changed(const ci::Area & area);
+  
+  // hand gpu work to the upload_scheduler, or run it now if scheduling is disabled
+  void schedule(size_t bytes, upload_scheduler::work_fn work);
 };
 
 //////////////////////////////////////////////////////
@@ -87,12 +206,15 @@ public:
   //////////////////////////////////////////////////////
   typedef std::shared_ptr<image_provider> image_provider_ref;
   
+  // created from a pool, so paging through images does not touch the heap
   static image_provider_ref create(std::string filename);
   
   static image_provider_ref create(ci::gl::TextureRef tex);
   
   static image_provider_ref create();
   
+  static slab_pool::stats get_pool_stats();
+  
   //////////////////////////////////////////////////////
   // ctr(s)
   //////////////////////////////////////////////////////
@@ -118,6 +240,9 @@ public:
   // methods
   //////////////////////////////////////////////////////
   void update() override {}
+
+protected:
+  ci::vec2 pending_size = ci::vec2(0);  // of the image set_source() scheduled, until it is uploaded
 };
 //////////////////////////////////////////////////////
 // typedefs
@@ -132,17 +257,27 @@ typedef image_provider::image_provider_ref image_provider_ref;
 class graphics_provider : public texture_provider {
 public:
   typedef std::shared_ptr<graphics_provider> graphics_provider_ref;
-  graphics_provider_ref create(ci::vec2 size, bool transparent=true) {
-    return std::make_shared<graphics_provider>(size, transparent);
+  graphics_provider_ref create(ci::vec2 size, bool transparent=true, int samples=4) {
+    return std::make_shared<graphics_provider>(size, transparent, samples);
   }
 
+  // multisample resolves across all graphics providers, bytes are the multisampled storage read
+  static uint64_t get_resolve_count();
+
+  static uint64_t get_resolve_bytes();
+
+  static void reset_resolve_stats();
+
   //////////////////////////////////////////////////////
   // ctr(s)
   //////////////////////////////////////////////////////
-  graphics_provider(ci::vec2 size, bool transparent=true);
+  // samples is the msaa sample count used to draw, 0 for none,
+  // multisampled content is resolved once per update()
+  graphics_provider(ci::vec2 size, bool transparent=true, int samples=4);
   
   ~graphics_provider() {
     fbo.reset();
+    resolved.reset();
   }
   
   //////////////////////////////////////////////////////
@@ -152,6 +287,8 @@ public:
   
   provider_type get_type() override { return provider_type::Graphics; }
   
+  int get_samples() { return samples; }
+  
   //////////////////////////////////////////////////////
   // methods
   //////////////////////////////////////////////////////
@@ -161,13 +298,19 @@ public:
   
   void update() override;
   
+  // redraw just the area that changed, top-left origin
+  void update(const ci::Area & area);
+  
   virtual void draw() {};
   
   void set_background(ci::ColorA c);
   
 protected:
-  ci::gl::FboRef fbo;
+  ci::gl::FboRef fbo;         // drawn into, multisampled renderbuffers when samples > 0
+  ci::gl::FboRef resolved;    // single sampled texture the provider hands out, fbo if samples is 0
   ci::ColorA background;
+  ci::Area pending_area;
+  int samples;
 }; typedef graphics_provider::graphics_provider_ref graphics_provider_ref;
 
 // TODO: Implement platform specific provider for Quicktime & WMFVideoPlayer
@@ -1,14 +1,45 @@
+  // std
+#include <algorithm>
+
   // cinder
 #include "cinder/app/App.h"
 #include "cinder/gl/Fbo.h"
 #include "cinder/gl/gl.h"
 
   // sfmoma
+#include "cache.h"
+#include "memory.h"
+#include "profiler.h"
 #include "resizer.h"
+#include "saliency.h"
 
 using namespace ci;
 using namespace ci::app;
 
+namespace {
+  /**
+   * A small copy of the texture for saliency to measure, drawn a few
+   * times larger than the importance map so its box filter sees detail
+   * the gpu's bilinear reduction would skip
+   */
+  Surface8u read_back_small(gl::TextureRef input) {
+    float scale = std::min(1.0f, saliency::map_size * 4.0f / std::max(input->getWidth(), input->getHeight()));
+    ivec2 size = glm::max(ivec2(vec2(input->getSize()) * scale), ivec2(1));
+    gl::FboRef fbo = fbo_pool::acquire(size, gl::Fbo::Format().disableDepth(), "texture_resizer");
+    Surface8u copy;
+    {
+      gl::ScopedFramebuffer scoped_fbo(fbo);
+      gl::ScopedViewport scoped_viewport(ivec2(0), fbo->getSize());
+      gl::ScopedMatrices scoped_matrices;
+      gl::setMatricesWindow(fbo->getSize());
+      gl::draw(input, Rectf(fbo->getBounds()));
+      copy = fbo->readPixels8u(fbo->getBounds());
+    }
+    fbo_pool::release(fbo, gl::Fbo::Format().disableDepth());
+    return copy;
+  }
+}
+
 Rectf texture_resizer::createBoundingRect(float top_left[2], float bottom_right[2], vec2 screen_size) {
   Rectf bounds;
   float w = screen_size.x;
@@ -21,6 +52,7 @@ Rectf texture_resizer::createBoundingRect(float top_left[2], float bottom_right[
 
 texture_resizer::result texture_resizer::process(
   gl::TextureRef input, vec2 screen_size, float top_left[2], float bottom_right[2], texture_resizer::options options) {
+  SPRITE_PROFILE_SCOPE("texture_resizer::process");
   
   Rectf crop;
   float scale = 1.0f;
@@ -31,6 +63,7 @@ texture_resizer::result texture_resizer::process(
   
   switch (options.get_fit()){
     case options::fit::Crop:
+    case options::fit::SmartCrop:
       aspect_ratio = crop.getWidth() / crop.getHeight();
       if (aspect_ratio > 1.0f) {
           // landscape
@@ -53,6 +86,21 @@ texture_resizer::result texture_resizer::process(
         }
       }
       
+      if (options.get_fit() == options::fit::SmartCrop) {
+          // center the crop on the most important content, the cache avoids the readback
+        Rectf found;
+        float aspect = crop.getAspectRatio();
+        if (options.get_key().empty() || !saliency::get_cached(options.get_key(), aspect, found)) {
+          Surface8u copy = read_back_small(input);
+          found = saliency::find_crop(copy, aspect).scaled(1.0f / vec2(copy.getSize()));
+          if (!options.get_key().empty()) saliency::put_cached(options.get_key(), aspect, found);
+        }
+        crop.offsetCenterTo(found.getCenter() * vec2(input->getSize()));
+        crop.offset(glm::max(-crop.getUpperLeft(), vec2(0)));
+        crop.offset(glm::min(vec2(input->getSize()) - crop.getLowerRight(), vec2(0)));
+        break;
+      }
+      
         // center the crop on the image
       crop.offsetCenterTo(ivec2((float)input->getWidth() * 0.5, (float)input->getHeight() * 0.5));
       break;
@@ -82,7 +130,9 @@ texture_resizer::result texture_resizer::process(
       break;
   }
   
+  gpu_memory::reserve(gpu_memory::get_fbo_bytes(bounds.getSize(), gl::Fbo::Format().colorTexture()));
   gl::FboRef fbo = gl::Fbo::create(bounds.getWidth(), bounds.getHeight(), true);
+  gpu_memory::track(fbo, "texture_resizer");
   {
     gl::ScopedFramebuffer scoped_fbo(fbo);
     gl::ScopedViewport scoped_viewport(ivec2(0), fbo->getSize());
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <string>
+
 #include "cinder/gl/Texture.h"
 
 class texture_resizer {
@@ -8,17 +10,21 @@ public:
   public:
     enum fit {
       Scale,
-      Crop
+      Crop,
+      SmartCrop   // crop placed on the image's most important content, see saliency
     };
     
-    options(fit fit, ci::vec2 scale) : fit_type(fit), bounds_scale(scale) {};
+    // key names the asset so SmartCrop measures it once (ie. its path), none measures every time
+    options(fit fit, ci::vec2 scale, std::string key = "") : fit_type(fit), bounds_scale(scale), asset_key(key) {};
     
     fit get_fit() { return fit_type; }
     ci::vec2 get_bounds_scale() { return bounds_scale; }
+    const std::string & get_key() { return asset_key; }
     
   private:
     ci::vec2 bounds_scale;
     fit fit_type;
+    std::string asset_key;
   };
   
   class result {
@@ -0,0 +1,244 @@
+// std
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <vector>
+
+#if defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#include <emmintrin.h>
+#define SALIENCY_SSE2
+#elif defined( __ARM_NEON ) || defined( __ARM_NEON__ )
+#include <arm_neon.h>
+#define SALIENCY_NEON
+#endif
+
+// cinder
+#include "cinder/Timer.h"
+
+// sfmoma
+#include "profiler.h"
+#include "saliency.h"
+
+using namespace ci;
+
+namespace {
+  std::mutex mutex;
+  std::map<std::pair<std::string, int>, Rectf> crops;
+  saliency::stats saliency_stats = { 0, 0, 0.0 };
+
+  // aspects closer than this share a cache entry
+  int aspect_key(float aspect) {
+    return (int)std::lround(aspect * 1000.0f);
+  }
+
+  /**
+   * Box average luma and saturation into size, sampling at most four
+   * pixels per cell along each axis, which is plenty at this size
+   */
+  void downsample(const Surface8u & image, ivec2 size, Channel8u & luma, Channel8u & saturation) {
+    ivec2 source = image.getSize();
+    int step_x = std::max(1, source.x / size.x / 4);
+    int step_y = std::max(1, source.y / size.y / 4);
+
+    std::vector<int> column(source.x);
+    for(int x = 0; x < source.x; x++) column[x] = x * size.x / source.x;
+
+    const uint8_t * data = image.getData();
+    ptrdiff_t row_bytes = image.getRowBytes();
+    int inc = image.getPixelInc();
+    int r = image.getRedOffset(), g = image.getGreenOffset(), b = image.getBlueOffset();
+
+    std::vector<uint32_t> luma_sum(size.x), saturation_sum(size.x), samples(size.x);
+    for(int y = 0; y < size.y; y++) {
+      std::fill(luma_sum.begin(), luma_sum.end(), 0);
+      std::fill(saturation_sum.begin(), saturation_sum.end(), 0);
+      std::fill(samples.begin(), samples.end(), 0);
+
+      int y1 = y * source.y / size.y;
+      int y2 = std::max((y + 1) * source.y / size.y, y1 + 1);
+      for(int sy = y1; sy < y2; sy += step_y) {
+        const uint8_t * row = data + sy * row_bytes;
+        for(int sx = 0; sx < source.x; sx += step_x) {
+          const uint8_t * p = row + sx * inc;
+          int c = column[sx];
+          luma_sum[c] += (p[r] * 54 + p[g] * 183 + p[b] * 19) >> 8;
+          saturation_sum[c] += std::max({ p[r], p[g], p[b] }) - std::min({ p[r], p[g], p[b] });
+          samples[c]++;
+        }
+      }
+
+      uint8_t * luma_row = luma.getData(ivec2(0, y));
+      uint8_t * saturation_row = saturation.getData(ivec2(0, y));
+      for(int x = 0; x < size.x; x++) {
+        uint32_t n = std::max<uint32_t>(samples[x], 1);
+        luma_row[x] = (uint8_t)(luma_sum[x] / n);
+        saturation_row[x] = (uint8_t)(saturation_sum[x] / n);
+      }
+    }
+  }
+
+  /**
+   * Importance of one row, |dx| + |dy| of luma plus a quarter of the
+   * saturation, saturating at 255. out[0] and out[width - 1] are left alone
+   */
+  void importance_row(
+    const uint8_t * above, const uint8_t * row, const uint8_t * below,
+    const uint8_t * saturation, uint8_t * out, int width) {
+    int x = 1;
+#if defined( SALIENCY_SSE2 )
+    const __m128i low_bits = _mm_set1_epi8(0x3f);
+    for(; x + 16 <= width - 1; x += 16) {
+      __m128i left = _mm_loadu_si128((const __m128i *)(row + x - 1));
+      __m128i right = _mm_loadu_si128((const __m128i *)(row + x + 1));
+      __m128i up = _mm_loadu_si128((const __m128i *)(above + x));
+      __m128i down = _mm_loadu_si128((const __m128i *)(below + x));
+      __m128i s = _mm_loadu_si128((const __m128i *)(saturation + x));
+      __m128i dx = _mm_or_si128(_mm_subs_epu8(left, right), _mm_subs_epu8(right, left));
+      __m128i dy = _mm_or_si128(_mm_subs_epu8(up, down), _mm_subs_epu8(down, up));
+      __m128i quarter = _mm_and_si128(_mm_srli_epi16(s, 2), low_bits);
+      _mm_storeu_si128((__m128i *)(out + x), _mm_adds_epu8(_mm_adds_epu8(dx, dy), quarter));
+    }
+#elif defined( SALIENCY_NEON )
+    for(; x + 16 <= width - 1; x += 16) {
+      uint8x16_t dx = vabdq_u8(vld1q_u8(row + x - 1), vld1q_u8(row + x + 1));
+      uint8x16_t dy = vabdq_u8(vld1q_u8(above + x), vld1q_u8(below + x));
+      uint8x16_t quarter = vshrq_n_u8(vld1q_u8(saturation + x), 2);
+      vst1q_u8(out + x, vqaddq_u8(vqaddq_u8(dx, dy), quarter));
+    }
+#endif
+    for(; x < width - 1; x++) {
+      int dx = std::abs(row[x - 1] - row[x + 1]);
+      int dy = std::abs(above[x] - below[x]);
+      out[x] = (uint8_t)std::min(dx + dy + (saturation[x] >> 2), 255);
+    }
+  }
+
+  ivec2 get_map_size(ivec2 image_size) {
+    float scale = std::min(1.0f, (float)saliency::map_size / std::max(image_size.x, image_size.y));
+    return glm::max(ivec2(glm::round(vec2(image_size) * scale)), ivec2(1));
+  }
+}
+
+//////////////////////////////////////////////////////
+// getters
+//////////////////////////////////////////////////////
+saliency::stats saliency::get_stats() {
+  std::lock_guard<std::mutex> lock(mutex);
+  return saliency_stats;
+}
+
+Channel8u saliency::get_importance(const Surface8u & image) {
+  ivec2 size = get_map_size(image.getSize());
+  Channel8u luma(size.x, size.y), saturation(size.x, size.y), importance(size.x, size.y);
+  downsample(image, size, luma, saturation);
+
+  // the border has no neighbours on one side, keep it out of the crop's favour
+  for(int y = 0; y < size.y; y++) {
+    uint8_t * out = importance.getData(ivec2(0, y));
+    if(y == 0 || y == size.y - 1 || size.x < 3) {
+      std::fill(out, out + size.x, 0);
+      continue;
+    }
+    out[0] = out[size.x - 1] = 0;
+    importance_row(
+      luma.getData(ivec2(0, y - 1)), luma.getData(ivec2(0, y)), luma.getData(ivec2(0, y + 1)),
+      saturation.getData(ivec2(0, y)), out, size.x);
+  }
+  return importance;
+}
+
+Rectf saliency::find_crop(const Surface8u & image, float aspect) {
+  SPRITE_PROFILE_SCOPE("saliency::find_crop");
+  Timer timer(true);
+  vec2 image_size = image.getSize();
+  aspect = aspect > 0.0f ? aspect : 1.0f;
+  vec2 window = std::min(image_size.x, image_size.y * aspect) * vec2(1.0f, 1.0f / aspect);
+
+  Channel8u importance = get_importance(image);
+  ivec2 size = importance.getSize();
+  vec2 scale = vec2(size) / image_size;
+  ivec2 cells = glm::clamp(ivec2(glm::round(window * scale)), ivec2(1), size);
+
+  // sums of everything above and left of each corner, a window's sum is four lookups
+  int stride = size.x + 1;
+  std::vector<uint32_t> table(stride * (size.y + 1), 0);
+  for(int y = 0; y < size.y; y++) {
+    const uint8_t * row = importance.getData(ivec2(0, y));
+    uint32_t running = 0;
+    for(int x = 0; x < size.x; x++) {
+      running += row[x];
+      table[(y + 1) * stride + x + 1] = table[y * stride + x + 1] + running;
+    }
+  }
+
+  ivec2 best(0);
+  uint32_t best_sum = 0;
+  float best_distance = std::numeric_limits<float>::max();
+  vec2 center = vec2(size - cells) * 0.5f;
+  for(int y = 0; y <= size.y - cells.y; y++) {
+    for(int x = 0; x <= size.x - cells.x; x++) {
+      uint32_t sum = table[(y + cells.y) * stride + x + cells.x] - table[y * stride + x + cells.x]
+        - table[(y + cells.y) * stride + x] + table[y * stride + x];
+      if(sum < best_sum) continue;
+      vec2 offset = vec2(x, y) - center;
+      float distance = glm::dot(offset, offset);
+      if(sum > best_sum || distance < best_distance) {
+        best = ivec2(x, y);
+        best_sum = sum;
+        best_distance = distance;
+      }
+    }
+  }
+
+  Rectf crop(vec2(0), window);
+  crop.offsetCenterTo((vec2(best) + vec2(cells) * 0.5f) / scale);
+  crop.offset(glm::max(-crop.getUpperLeft(), vec2(0)));
+  crop.offset(glm::min(image_size - crop.getLowerRight(), vec2(0)));
+
+  std::lock_guard<std::mutex> lock(mutex);
+  saliency_stats.computed++;
+  saliency_stats.compute_ms += timer.getSeconds() * 1000.0;
+  return crop;
+}
+
+Rectf saliency::find_crop(const std::string & key, const Surface8u & image, float aspect) {
+  vec2 image_size = image.getSize();
+  Rectf cached;
+  if(get_cached(key, aspect, cached)) return cached.scaled(image_size);
+
+  Rectf crop = find_crop(image, aspect);
+  put_cached(key, aspect, crop.scaled(1.0f / image_size));
+  return crop;
+}
+
+bool saliency::get_cached(const std::string & key, float aspect, Rectf & crop) {
+  std::lock_guard<std::mutex> lock(mutex);
+  auto it = crops.find({ key, aspect_key(aspect) });
+  if(it == crops.end()) return false;
+  saliency_stats.cache_hits++;
+  crop = it->second;
+  return true;
+}
+
+//////////////////////////////////////////////////////
+// setters
+//////////////////////////////////////////////////////
+void saliency::put_cached(const std::string & key, float aspect, const Rectf & crop) {
+  std::lock_guard<std::mutex> lock(mutex);
+  crops[{ key, aspect_key(aspect) }] = crop;
+}
+
+//////////////////////////////////////////////////////
+// methods
+//////////////////////////////////////////////////////
+void saliency::clear_cache() {
+  std::lock_guard<std::mutex> lock(mutex);
+  crops.clear();
+}
+
+void saliency::reset_stats() {
+  std::lock_guard<std::mutex> lock(mutex);
+  saliency_stats = { 0, 0, 0.0 };
+}
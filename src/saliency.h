@@ -0,0 +1,67 @@
+#pragma once
+
+// std
+#include <cstdint>
+#include <string>
+
+// cinder
+#include "cinder/Channel.h"
+#include "cinder/Surface.h"
+
+/////////////////////////////////////////////////
+//
+//  saliency
+//  Where the subject of an image is, for placing
+//  crops on it rather than the image's center
+//
+//  Importance is measured on a copy no larger than
+//  map_size, as edge strength plus saturation,
+//  and the crop is the window with the most of it,
+//  found with a summed area table. Crops are kept
+//  per asset and aspect, so each image is measured
+//  once
+//
+/////////////////////////////////////////////////
+class saliency {
+public:
+  class stats {
+  public:
+    uint64_t computed;    // crops measured
+    uint64_t cache_hits;  // crops found in the cache
+    double compute_ms;    // time spent measuring
+  };
+
+  // the longest side of the importance map
+  static const int map_size = 128;
+
+  //////////////////////////////////////////////////////
+  // getters
+  //////////////////////////////////////////////////////
+  static stats get_stats();
+
+  // importance 0-255 of each pixel of a copy of image no larger than map_size
+  static ci::Channel8u get_importance(const ci::Surface8u & image);
+
+  // the largest window of aspect that fits image, placed on its most
+  // important content, ties go to the window nearest the center
+  static ci::Rectf find_crop(const ci::Surface8u & image, float aspect);
+
+  // as find_crop, cached under key (ie. the asset's path), image is only
+  // measured when the crop is not cached yet
+  static ci::Rectf find_crop(const std::string & key, const ci::Surface8u & image, float aspect);
+
+  // the cached crop for key and aspect, as a fraction of the image's size
+  static bool get_cached(const std::string & key, float aspect, ci::Rectf & crop);
+
+  //////////////////////////////////////////////////////
+  // setters
+  //////////////////////////////////////////////////////
+  static void put_cached(const std::string & key, float aspect, const ci::Rectf & crop);
+
+  //////////////////////////////////////////////////////
+  // methods
+  //////////////////////////////////////////////////////
+  static void clear_cache();
+
+  static void reset_stats();
+};
@@ -0,0 +1,429 @@
+// std
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <type_traits>
+#include <unordered_map>
+
+// cinder
+#include "cinder/Exception.h"
+#include "cinder/Log.h"
+
+// sfmoma
+#include "profiler.h"
+#include "scene.h"
+#include "text.h"
+
+using namespace ci;
+
+namespace {
+  const char scene_magic[4] = { 'C', 'S', 'P', 'S' };
+  const uint32_t scene_version = 1;
+
+#pragma pack(push, 1)
+  struct file_header {
+    char magic[4];
+    uint32_t version;
+    uint32_t node_count;
+    uint32_t action_count;
+    uint32_t strings_size;
+  };
+#pragma pack(pop)
+
+  // stored by index, new easings are only ever appended
+  const std::vector<std::pair<std::string, EaseFn>> eases = {
+    { "in_out_quad", easeInOutQuad },
+    { "linear", easeNone },
+    { "in_quad", easeInQuad },
+    { "out_quad", easeOutQuad },
+    { "in_cubic", easeInCubic },
+    { "out_cubic", easeOutCubic },
+    { "in_out_cubic", easeInOutCubic },
+    { "in_sine", easeInSine },
+    { "out_sine", easeOutSine },
+    { "in_out_sine", easeInOutSine },
+    { "in_expo", easeInExpo },
+    { "out_expo", easeOutExpo },
+    { "in_out_expo", easeInOutExpo }
+  };
+
+  const std::map<std::string, provider_type> provider_names = {
+    { "none", provider_type::None },
+    { "image", provider_type::Image },
+    { "video", provider_type::Video },
+    { "text", provider_type::Text }
+  };
+
+  const std::map<std::string, sprite::mask_type> mask_names = {
+    { "none", sprite::mask_type::None },
+    { "to_center", sprite::mask_type::ToCenter },
+    { "from_center", sprite::mask_type::FromCenter },
+    { "left_to_right", sprite::mask_type::LeftToRight },
+    { "right_to_left", sprite::mask_type::RightToLeft }
+  };
+
+  // verb and the number of values it takes, mask verbs take a mask name instead
+  const std::map<std::string, std::pair<scene::verb, int>> verb_names = {
+    { "alpha_to", { scene::AlphaTo, 1 } },
+    { "move_to", { scene::MoveTo, 2 } },
+    { "scale_to", { scene::ScaleTo, 2 } },
+    { "tint_to", { scene::TintTo, 3 } },
+    { "zoom_to", { scene::ZoomTo, 1 } },
+    { "mask_hide", { scene::MaskHide, 0 } },
+    { "mask_reveal", { scene::MaskReveal, 0 } }
+  };
+
+  typedef std::vector<std::string> tokens;
+
+  // words separated by whitespace, "quoted strings" kept whole, # starts a comment
+  tokens tokenize(const std::string & line) {
+    tokens result;
+    size_t i = 0;
+    while(i < line.size()) {
+      if(isspace((unsigned char)line[i])) {
+        i++;
+      } else if(line[i] == '#') {
+        break;
+      } else if(line[i] == '"') {
+        size_t end = line.find('"', i + 1);
+        if(end == std::string::npos) throw Exception("unterminated string");
+        result.push_back(line.substr(i + 1, end - i - 1));
+        i = end + 1;
+      } else {
+        size_t end = i;
+        while(end < line.size() && !isspace((unsigned char)line[end])) end++;
+        result.push_back(line.substr(i, end - i));
+        i = end;
+      }
+    }
+    return result;
+  }
+
+  float number(const tokens & t, size_t i) {
+    if(i >= t.size()) throw Exception(t[0] + " expects more values");
+    try {
+      size_t used = 0;
+      float value = std::stof(t[i], &used);
+      if(used == t[i].size()) return value;
+    } catch(const std::exception &) {}
+    throw Exception("'" + t[i] + "' is not a number");
+  }
+
+  template<typename T>
+  T lookup(const std::map<std::string, T> & names, const tokens & t, size_t i) {
+    if(i >= t.size()) throw Exception(t[0] + " expects a name");
+    auto it = names.find(t[i]);
+    if(it == names.end()) throw Exception("unknown " + t[0] + " '" + t[i] + "'");
+    return it->second;
+  }
+
+  scene::node default_node() {
+    scene::node n;
+    std::memset(&n, 0, sizeof(n));
+    n.provider = (uint32_t)provider_type::Image;
+    n.origin = sprite::origin_point::TopLeft;
+    n.scale[0] = n.scale[1] = 1.0f;
+    n.alpha = 1.0f;
+    n.tint[0] = n.tint[1] = n.tint[2] = 1.0f;
+    return n;
+  }
+
+  scene::action parse_action(const tokens & t, scene::verb v, int values) {
+    scene::action a;
+    std::memset(&a, 0, sizeof(a));
+    a.verb = v;
+    size_t i = 1;
+    if(v == scene::MaskHide || v == scene::MaskReveal) {
+      a.option = lookup(mask_names, t, i++);
+    }
+    for(int j = 0; j < values; j++) a.value[j] = number(t, i++);
+
+    // then an optional duration and keywords in any order
+    if(i < t.size() && t[i] != "delay" && t[i] != "ease" && t[i] != "append") a.duration = number(t, i++);
+    while(i < t.size()) {
+      if(t[i] == "delay") {
+        a.delay = number(t, i + 1);
+        i += 2;
+      } else if(t[i] == "ease") {
+        if(i + 1 >= t.size()) throw Exception("ease expects a name");
+        auto it = std::find_if(eases.begin(), eases.end(), [&](const std::pair<std::string, EaseFn> & e) { return e.first == t[i + 1]; });
+        if(it == eases.end()) throw Exception("unknown ease '" + t[i + 1] + "'");
+        a.ease = (uint32_t)(it - eases.begin());
+        i += 2;
+      } else if(t[i] == "append" && (v == scene::AlphaTo || v == scene::MoveTo)) {
+        a.option = 1;
+        i++;
+      } else {
+        throw Exception("unexpected '" + t[i] + "'");
+      }
+    }
+    return a;
+  }
+
+  /**
+   * Sprites are placed in one block, each sprite is still destroyed
+   * as soon as its own sprite_ref is released, only the memory is
+   * shared and freed with the last of them
+   */
+  class sprite_block {
+  public:
+    typedef std::aligned_storage<sizeof(sprite), alignof(sprite)>::type slot;
+
+    sprite_block(size_t size) : slots(new slot[size]), destroyed(size, false), count(0) {}
+
+    ~sprite_block() {
+      for(size_t i = 0; i < count; i++) {
+        if(!destroyed[i]) ((sprite *)&slots[i])->~sprite();
+      }
+    }
+
+    template<typename... Args>
+    sprite * emplace(Args &&... args) {
+      sprite * created = new (&slots[count]) sprite(std::forward<Args>(args)...);
+      count++;
+      return created;
+    }
+
+    void destroy(sprite * s) {
+      s->~sprite();
+      destroyed[(slot *)s - slots.get()] = true;
+    }
+
+    std::unique_ptr<slot[]> slots;
+    std::vector<bool> destroyed;
+    size_t count;
+  };
+}
+
+////////////////////////////////////////////////////
+//  static
+////////////////////////////////////////////////////
+scene_ref scene::parse(const std::string & text) {
+  SPRITE_PROFILE_SCOPE("scene::parse");
+  auto result = std::make_shared<scene>();
+  std::istringstream in(text);
+  std::string line;
+  int line_number = 0;
+
+  // repeated sources share one slice of the string table
+  std::unordered_map<std::string, uint32_t> source_offsets;
+
+  while(std::getline(in, line)) {
+    line_number++;
+    try {
+      tokens t = tokenize(line);
+      if(t.empty()) continue;
+
+      if(t[0] == "sprite") {
+        node n = default_node();
+        n.provider = (uint32_t)lookup(provider_names, t, 1);
+        if(t.size() > 2) {
+          auto known = source_offsets.find(t[2]);
+          if(known == source_offsets.end()) {
+            known = source_offsets.emplace(t[2], (uint32_t)result->strings.size()).first;
+            result->strings += t[2];
+          }
+          n.source_offset = known->second;
+          n.source_length = (uint32_t)t[2].size();
+        }
+        n.first_action = (uint32_t)result->actions.size();
+        result->nodes.push_back(n);
+        continue;
+      }
+      if(result->nodes.empty()) throw Exception(t[0] + " before the first sprite");
+      node & n = result->nodes.back();
+
+      auto v = verb_names.find(t[0]);
+      if(v != verb_names.end()) {
+        result->actions.push_back(parse_action(t, v->second.first, v->second.second));
+        n.action_count++;
+      } else if(t[0] == "at") {
+        n.position[0] = number(t, 1);
+        n.position[1] = number(t, 2);
+      } else if(t[0] == "scale") {
+        n.scale[0] = number(t, 1);
+        n.scale[1] = t.size() > 2 ? number(t, 2) : n.scale[0];
+      } else if(t[0] == "origin") {
+        if(t.size() < 2 || (t[1] != "center" && t[1] != "top_left")) throw Exception("origin is center or top_left");
+        n.origin = t[1] == "center" ? sprite::origin_point::Center : sprite::origin_point::TopLeft;
+      } else if(t[0] == "alpha") {
+        n.alpha = number(t, 1);
+      } else if(t[0] == "tint") {
+        for(int i = 0; i < 3; i++) n.tint[i] = number(t, i + 1);
+      } else if(t[0] == "zoom") {
+        n.zoom = number(t, 1);
+      } else {
+        throw Exception("unknown statement '" + t[0] + "'");
+      }
+    } catch(const std::exception & e) {
+      throw Exception("Scene line " + std::to_string(line_number) + ": " + e.what());
+    }
+  }
+  return result;
+}
+
+scene_ref scene::load_text(const fs::path & path) {
+  std::ifstream in(path.string(), std::ios::binary);
+  if(!in) throw Exception("Can not open scene " + path.string());
+  std::stringstream text;
+  text << in.rdbuf();
+  return parse(text.str());
+}
+
+scene_ref scene::load(const fs::path & path) {
+  SPRITE_PROFILE_SCOPE("scene::load");
+  std::ifstream in(path.string(), std::ios::binary | std::ios::ate);
+  if(!in) throw Exception("Can not open scene " + path.string());
+  std::vector<char> data((size_t)in.tellg());
+  in.seekg(0);
+  in.read(data.data(), data.size());
+
+  file_header header;
+  if(data.size() < sizeof(header)) throw Exception(path.string() + " is not a scene");
+  std::memcpy(&header, data.data(), sizeof(header));
+  if(std::memcmp(header.magic, scene_magic, 4) != 0) throw Exception(path.string() + " is not a scene");
+  if(header.version != scene_version) {
+    throw Exception(path.string() + " has unsupported scene version " + std::to_string(header.version));
+  }
+  uint64_t node_bytes = (uint64_t)sizeof(node) * header.node_count;
+  uint64_t action_bytes = (uint64_t)sizeof(action) * header.action_count;
+  if(data.size() < sizeof(header) + node_bytes + action_bytes + header.strings_size) {
+    throw Exception(path.string() + " is truncated");
+  }
+
+  // the arrays are stored as they are held, so each is a single copy
+  auto result = std::make_shared<scene>();
+  const char * p = data.data() + sizeof(header);
+  result->nodes.resize(header.node_count);
+  std::memcpy(result->nodes.data(), p, node_bytes);
+  p += node_bytes;
+  result->actions.resize(header.action_count);
+  std::memcpy(result->actions.data(), p, action_bytes);
+  p += action_bytes;
+  result->strings.assign(p, header.strings_size);
+
+  // fields are cast to enums and used as indices when instantiated, so nothing out of range gets that far
+  for(size_t i = 0; i < result->nodes.size(); i++) {
+    const node & n = result->nodes[i];
+    if(n.provider > (uint32_t)provider_type::Text || n.origin > sprite::origin_point::Center
+      || (uint64_t)n.source_offset + n.source_length > header.strings_size
+      || (uint64_t)n.first_action + n.action_count > header.action_count) {
+      throw Exception(path.string() + " has a corrupt sprite " + std::to_string(i));
+    }
+  }
+  for(size_t i = 0; i < result->actions.size(); i++) {
+    const action & a = result->actions[i];
+    bool masked = a.verb == MaskHide || a.verb == MaskReveal;
+    if(a.verb > MaskReveal || a.ease >= eases.size() || (masked && a.option > sprite::mask_type::RightToLeft)) {
+      throw Exception(path.string() + " has a corrupt action " + std::to_string(i));
+    }
+  }
+  return result;
+}
+
+//////////////////////////////////////////////////////
+// getters
+//////////////////////////////////////////////////////
+size_t scene::size() {
+  return nodes.size();
+}
+
+const std::vector<scene::node> & scene::get_nodes() {
+  return nodes;
+}
+
+const std::vector<scene::action> & scene::get_actions() {
+  return actions;
+}
+
+std::string scene::get_source(const node & n) {
+  if((uint64_t)n.source_offset + n.source_length > strings.size()) return "";
+  return strings.substr(n.source_offset, n.source_length);
+}
+
+//////////////////////////////////////////////////////
+// methods
+//////////////////////////////////////////////////////
+void scene::save(const fs::path & path) {
+  std::ofstream out(path.string(), std::ios::binary | std::ios::trunc);
+  if(!out) throw Exception("Can not write scene " + path.string());
+
+  file_header header;
+  std::memcpy(header.magic, scene_magic, 4);
+  header.version = scene_version;
+  header.node_count = (uint32_t)nodes.size();
+  header.action_count = (uint32_t)actions.size();
+  header.strings_size = (uint32_t)strings.size();
+  out.write((const char *)&header, sizeof(header));
+  out.write((const char *)nodes.data(), sizeof(node) * nodes.size());
+  out.write((const char *)actions.data(), sizeof(action) * actions.size());
+  out.write(strings.data(), strings.size());
+}
+
+std::vector<sprite_ref> scene::instantiate(provider_fn create_provider) {
+  SPRITE_PROFILE_SCOPE("scene::instantiate");
+  std::vector<sprite_ref> result;
+  result.reserve(nodes.size());
+  auto block = std::make_shared<sprite_block>(nodes.size());
+  SPRITE_PROFILE_ALLOC("scene", sizeof(sprite) * nodes.size());
+
+  for(auto & n : nodes) {
+    provider_type type = (provider_type)n.provider;
+    std::string source = get_source(n);
+    texture_provider_ref provider;
+    if(create_provider) {
+      provider = create_provider(type, source);
+    } else if(type == provider_type::Image) {
+      provider = source.empty() ? image_provider::create() : image_provider::create(source);
+    } else if(type == provider_type::Video) {
+      provider = source.empty() ? video_provider::create() : video_provider::create(source);
+    } else if(type == provider_type::Text) {
+      provider = text_provider::create(source);
+    }
+
+    sprite * created = provider ? block->emplace(provider) : block->emplace(provider_type::None);
+    sprite_ref sp(created, [block](sprite * s) { block->destroy(s); });
+    sp->set_origin((sprite::origin_point)n.origin);
+    sp->set_coordinates(vec2(n.position[0], n.position[1]));
+    sp->set_scale(vec2(n.scale[0], n.scale[1]));
+    sp->set_alpha(n.alpha);
+    sp->set_tint(Color(n.tint[0], n.tint[1], n.tint[2]));
+    if(n.zoom != 0.0f) sp->set_zoom(n.zoom);
+
+    for(uint32_t i = n.first_action; i < n.first_action + n.action_count && i < actions.size(); i++) {
+      const action & a = actions[i];
+      EaseFn ease = a.ease < eases.size() ? eases[a.ease].second : EaseFn(easeInOutQuad);
+      switch(a.verb) {
+        case AlphaTo:
+          sp->alpha_to(a.value[0], a.duration, a.delay, ease, a.option != 0);
+          break;
+        case MoveTo:
+          sp->move_to(vec2(a.value[0], a.value[1]), a.duration, a.delay, ease, a.option != 0);
+          break;
+        case ScaleTo:
+          sp->scale_to(vec2(a.value[0], a.value[1]), a.duration, a.delay, ease);
+          break;
+        case TintTo:
+          sp->tint_to(Color(a.value[0], a.value[1], a.value[2]), a.duration, a.delay, ease);
+          break;
+        case ZoomTo:
+          sp->zoom_to(a.value[0], a.duration, a.delay, ease);
+          break;
+        case MaskHide:
+          sp->mask_hide((sprite::mask_type)a.option, a.duration, a.delay, ease);
+          break;
+        case MaskReveal:
+          sp->mask_reveal((sprite::mask_type)a.option, a.duration, a.delay, ease);
+          break;
+        default:
+          CI_LOG_W("Skipping unknown scene verb " << a.verb);
+          break;
+      }
+    }
+    result.push_back(sp);
+  }
+  return result;
+}
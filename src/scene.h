@@ -0,0 +1,131 @@
+#pragma once
+
+// std
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// cinder
+#include "cinder/Filesystem.h"
+
+// sfmoma
+#include "provider.h"
+#include "sprite.h"
+
+/////////////////////////////////////////////////
+//
+//  scene
+//  A declarative sprite layout: providers,
+//  transforms and animation scripts using the
+//  sprite's *_to and mask_* verbs
+//
+//  The text form is for authoring, one statement
+//  per line, each applying to the sprite above it:
+//
+//    sprite image "photos/a.jpg"
+//      at 100 200
+//      origin center
+//      scale 0.5
+//      alpha 0
+//      alpha_to 1 0.5 delay 0.2 ease out_quad
+//      mask_reveal left_to_right 1.0
+//
+//  The binary form is the same records written
+//  as flat arrays, loaded with one read and one
+//  copy per array
+//
+/////////////////////////////////////////////////
+class scene {
+public:
+  //////////////////////////////////////////////////////
+  // enums
+  //////////////////////////////////////////////////////
+  enum verb : uint32_t {
+    AlphaTo,
+    MoveTo,
+    ScaleTo,
+    TintTo,
+    ZoomTo,
+    MaskHide,
+    MaskReveal
+  };
+
+#pragma pack(push, 1)
+  // an animation, option is append for *_to verbs and the mask_type for mask_*
+  class action {
+  public:
+    uint32_t verb;
+    uint32_t ease;
+    uint32_t option;
+    float duration;
+    float delay;
+    float value[3];
+  };
+
+  // a sprite, its source is a slice of the string table
+  class node {
+  public:
+    uint32_t provider;
+    uint32_t origin;
+    uint32_t source_offset;
+    uint32_t source_length;
+    float position[2];
+    float scale[2];
+    float alpha;
+    float tint[3];
+    float zoom;
+    uint32_t first_action;
+    uint32_t action_count;
+  };
+#pragma pack(pop)
+
+  //////////////////////////////////////////////////////
+  // static
+  //////////////////////////////////////////////////////
+  typedef std::shared_ptr<scene> scene_ref;
+
+  // creates the provider for a node, ie. to substitute preloaded textures
+  typedef std::function<texture_provider_ref(provider_type type, const std::string & source)> provider_fn;
+
+  // parse the text form, throws a ci::Exception naming the line of an error
+  static scene_ref parse(const std::string & text);
+
+  static scene_ref load_text(const ci::fs::path & path);
+
+  // load the binary form, throws if it can not be read
+  static scene_ref load(const ci::fs::path & path);
+
+  //////////////////////////////////////////////////////
+  // getters
+  //////////////////////////////////////////////////////
+  size_t size();
+
+  const std::vector<node> & get_nodes();
+
+  const std::vector<action> & get_actions();
+
+  std::string get_source(const node & n);
+
+  //////////////////////////////////////////////////////
+  // methods
+  //////////////////////////////////////////////////////
+  // write the binary form
+  void save(const ci::fs::path & path);
+
+  // create the scene's sprites, in one allocation, and start their animations
+  std::vector<sprite_ref> instantiate(provider_fn create_provider = nullptr);
+
+protected:
+  //////////////////////////////////////////////////////
+  // properties
+  //////////////////////////////////////////////////////
+  std::vector<node> nodes;
+  std::vector<action> actions;
+  std::string strings;
+};
+
+//////////////////////////////////////////////////////
+// typedefs
+//////////////////////////////////////////////////////
+typedef scene::scene_ref scene_ref;
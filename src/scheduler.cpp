@@ -0,0 +1,414 @@
+// std
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <vector>
+
+// cinder
+#include "cinder/Timer.h"
+#include "cinder/gl/Query.h"
+
+// sfmoma
+#include "context.h"
+#include "provider.h"
+#include "scheduler.h"
+
+using namespace ci;
+
+namespace {
+  class job {
+  public:
+    texture_provider * owner;
+    size_t bytes;
+    upload_scheduler::work_fn work;
+    double submitted;
+  };
+
+  class latency_sample {
+  public:
+    double time;
+    double latency;
+  };
+
+  std::deque<job> pending;
+  std::deque<latency_sample> latencies;
+  bool enabled = false;
+  uint64_t frame = 0;
+  double time_budget = 2.0;
+  size_t byte_budget = 0;
+  double last_frame_ms = 0.0;
+  double debt_ms = 0.0;
+  Timer clock(true);
+
+#if ! defined( CINDER_GL_ES )
+  // double buffered so reading a result never stalls the pipeline
+  gl::QueryTimeElapsedRef queries[2];
+  bool query_in_flight[2] = { false, false };
+#endif
+}
+
+//////////////////////////////////////////////////////
+// getters
+//////////////////////////////////////////////////////
+bool upload_scheduler::is_enabled() {
+  return enabled;
+}
+
+uint64_t upload_scheduler::get_frame() {
+  return frame;
+}
+
+size_t upload_scheduler::get_queue_size() {
+  return pending.size();
+}
+
+double upload_scheduler::get_average_latency() {
+  if(latencies.empty()) return 0.0;
+  double total = 0.0;
+  for(auto & sample : latencies) total += sample.latency;
+  return total / latencies.size();
+}
+
+double upload_scheduler::get_max_latency() {
+  double result = 0.0;
+  for(auto & sample : latencies) result = std::max(result, sample.latency);
+  return result;
+}
+
+double upload_scheduler::get_last_frame_ms() {
+  return last_frame_ms;
+}
+
+//////////////////////////////////////////////////////
+// setters
+//////////////////////////////////////////////////////
+void upload_scheduler::set_enabled(bool e) {
+  enabled = e;
+
+  // anything left in the queue would never run
+  if(!enabled) {
+    resource_context::scope scoped_context;
+    while(!pending.empty()) {
+      job j = pending.front();
+      pending.pop_front();
+      j.work();
+    }
+  }
+}
+
+void upload_scheduler::set_time_budget(double ms) {
+  time_budget = std::max(0.0, ms);
+}
+
+void upload_scheduler::set_byte_budget(size_t bytes) {
+  byte_budget = bytes;
+}
+
+//////////////////////////////////////////////////////
+// methods
+//////////////////////////////////////////////////////
+void upload_scheduler::submit(texture_provider * owner, size_t bytes, work_fn work) {
+  if(!enabled) {
+    resource_context::scope scoped_context;
+    work();
+    return;
+  }
+
+  // newer work from the same provider supersedes older work,
+  // but keeps its place in line so it is not starved
+  for(auto & j : pending) {
+    if(owner && j.owner == owner) {
+      j.bytes = bytes;
+      j.work = work;
+      return;
+    }
+  }
+
+  job j;
+  j.owner = owner;
+  j.bytes = bytes;
+  j.work = work;
+  j.submitted = clock.getSeconds();
+  pending.push_back(j);
+}
+
+void upload_scheduler::cancel(texture_provider * owner) {
+  pending.erase(std::remove_if(pending.begin(), pending.end(), [=](const job & j) {
+    return j.owner == owner;
+  }), pending.end());
+}
+
+void upload_scheduler::process() {
+  frame++;
+  resource_context::scope scoped_context;
+
+  int q = frame % 2;
+#if ! defined( CINDER_GL_ES )
+  // gpu time that went over budget last time around is paid back this frame
+  if(query_in_flight[q] && queries[q]->isReady()) {
+    double gpu_ms = queries[q]->getElapsedMilliseconds();
+    debt_ms = std::max(0.0, gpu_ms - time_budget);
+    last_frame_ms = gpu_ms;
+    query_in_flight[q] = false;
+  }
+#endif
+
+  if(pending.empty()) return;
+
+  // visible providers first, otherwise first come first served
+  std::stable_sort(pending.begin(), pending.end(), [](const job & a, const job & b) {
+    bool a_visible = a.owner && a.owner->is_visible();
+    bool b_visible = b.owner && b.owner->is_visible();
+    return a_visible && !b_visible;
+  });
+
+#if ! defined( CINDER_GL_ES )
+  bool timing = !query_in_flight[q];
+  if(timing) {
+    if(!queries[q]) queries[q] = gl::QueryTimeElapsed::create();
+    queries[q]->begin();
+  }
+#endif
+
+  double budget = std::max(0.0, time_budget - debt_ms);
+  double now = clock.getSeconds();
+  size_t bytes = 0;
+  int count = 0;
+  Timer timer(true);
+
+  while(!pending.empty()) {
+    // always run one job so large uploads are never starved
+    job & next = pending.front();
+    if(count > 0) {
+      if(timer.getSeconds() * 1000.0 >= budget) break;
+      if(byte_budget > 0 && bytes + next.bytes > byte_budget) break;
+    }
+
+    job j = next;
+    pending.pop_front();
+    latencies.push_back({ now, now - j.submitted });
+    bytes += j.work();
+    count++;
+  }
+
+#if ! defined( CINDER_GL_ES )
+  if(timing) {
+    queries[q]->end();
+    query_in_flight[q] = true;
+  }
+#else
+  last_frame_ms = timer.getSeconds() * 1000.0;
+  debt_ms = std::max(0.0, last_frame_ms - time_budget);
+#endif
+
+  while(!latencies.empty() && now - latencies.front().time > 1.0) {
+    latencies.pop_front();
+  }
+}
+
+namespace {
+  class scheduled {
+  public:
+    std::weak_ptr<texture_provider> provider;
+    texture_provider * key;
+    double interval;
+    int priority;
+    double next_due;
+    double last_update;
+    uint64_t jitter_samples;
+    double jitter_total;
+    provider_scheduler::stats stats;
+  };
+
+  std::vector<scheduled> providers;
+  double display_rate = 0.0;
+  double measured_period = 1.0 / 60.0;
+  double last_tick = -1.0;
+  double time_cap = 0.0;
+  double last_update_ms = 0.0;
+  bool updating = false;
+
+  double get_period() {
+    return display_rate > 0.0 ? 1.0 / display_rate : measured_period;
+  }
+
+  /**
+   * A provider whose frame fell more than an interval behind drops the
+   * frames it missed instead of catching up with a burst of updates
+   */
+  void record_update(scheduled & s, double now, double period) {
+    double target = s.interval > 0.0 ? s.interval : period;
+    if(s.last_update >= 0.0) {
+      double jitter = std::abs((now - s.last_update) - target) * 1000.0;
+      s.jitter_samples++;
+      s.jitter_total += jitter;
+      s.stats.mean_jitter_ms = s.jitter_total / s.jitter_samples;
+      s.stats.max_jitter_ms = std::max(s.stats.max_jitter_ms, jitter);
+    }
+    s.stats.updates++;
+    s.last_update = now;
+    if(s.next_due + s.interval < now) s.next_due = now;
+    s.next_due += s.interval;
+  }
+}
+
+//////////////////////////////////////////////////////
+// provider_scheduler getters
+//////////////////////////////////////////////////////
+size_t provider_scheduler::size() {
+  return providers.size();
+}
+
+double provider_scheduler::get_display_rate() {
+  return 1.0 / get_period();
+}
+
+double provider_scheduler::get_last_update_ms() {
+  return last_update_ms;
+}
+
+provider_scheduler::stats provider_scheduler::get_stats(texture_provider * provider) {
+  for(auto & s : providers) {
+    if(s.key == provider) return s.stats;
+  }
+  return stats();
+}
+
+provider_scheduler::stats provider_scheduler::get_stats() {
+  stats result;
+  uint64_t samples = 0;
+  double total = 0.0;
+  for(auto & s : providers) {
+    result.updates += s.stats.updates;
+    result.skipped += s.stats.skipped;
+    result.deferred += s.stats.deferred;
+    result.max_jitter_ms = std::max(result.max_jitter_ms, s.stats.max_jitter_ms);
+    samples += s.jitter_samples;
+    total += s.jitter_total;
+  }
+  result.mean_jitter_ms = samples > 0 ? total / samples : 0.0;
+  return result;
+}
+
+//////////////////////////////////////////////////////
+// provider_scheduler setters
+//////////////////////////////////////////////////////
+void provider_scheduler::set_display_rate(double hz) {
+  display_rate = std::max(0.0, hz);
+}
+
+void provider_scheduler::set_time_cap(double ms) {
+  time_cap = std::max(0.0, ms);
+}
+
+//////////////////////////////////////////////////////
+// provider_scheduler methods
+//////////////////////////////////////////////////////
+void provider_scheduler::add(const std::shared_ptr<texture_provider> & provider, double rate, int priority) {
+  if(!provider) return;
+  double interval = rate > 0.0 ? 1.0 / rate : 0.0;
+  for(auto & s : providers) {
+    if(s.key == provider.get()) {
+      s.interval = interval;
+      s.priority = priority;
+      return;
+    }
+  }
+
+  scheduled s;
+  s.provider = provider;
+  s.key = provider.get();
+  s.interval = interval;
+  s.priority = priority;
+  s.next_due = 0.0;  // due straight away, the first update syncs it to the clock
+  s.last_update = -1.0;
+  s.jitter_samples = 0;
+  s.jitter_total = 0.0;
+  providers.push_back(s);
+}
+
+void provider_scheduler::remove(texture_provider * provider) {
+  // a provider removing itself from its update() is dropped on the next frame
+  if(updating) {
+    for(auto & s : providers) {
+      if(s.key == provider) s.provider.reset();
+    }
+    return;
+  }
+  providers.erase(std::remove_if(providers.begin(), providers.end(), [=](const scheduled & s) {
+    return s.key == provider;
+  }), providers.end());
+}
+
+void provider_scheduler::clear() {
+  if(updating) {
+    for(auto & s : providers) s.provider.reset();
+    return;
+  }
+  providers.clear();
+}
+
+void provider_scheduler::reset_stats() {
+  for(auto & s : providers) {
+    s.stats = stats();
+    s.jitter_samples = 0;
+    s.jitter_total = 0.0;
+  }
+}
+
+/**
+ * The frame being updated is shown on the next vsync, so a provider is
+ * due when its next frame time is closer to this frame than to the next
+ * one, ie. a 24 fps video on a 60 Hz display updates in a 3:2 cadence
+ */
+void provider_scheduler::update() {
+  update(clock.getSeconds());
+}
+
+void provider_scheduler::update(double now) {
+  resource_context::scope scoped_context;
+  if(last_tick >= 0.0) {
+    // ignore stalls, they are not the display's period
+    double delta = now - last_tick;
+    if(delta > 0.0 && delta < 0.1) measured_period += (delta - measured_period) * 0.1;
+  }
+  last_tick = now;
+  double period = get_period();
+
+  providers.erase(std::remove_if(providers.begin(), providers.end(), [](const scheduled & s) {
+    return s.provider.expired();
+  }), providers.end());
+
+  std::vector<size_t> due;
+  for(size_t i = 0; i < providers.size(); i++) {
+    if(providers[i].next_due <= now + period * 0.5) {
+      due.push_back(i);
+    } else {
+      providers[i].stats.skipped++;
+    }
+  }
+
+  // highest priority first, then whichever is furthest behind
+  std::stable_sort(due.begin(), due.end(), [](size_t a, size_t b) {
+    if(providers[a].priority != providers[b].priority) return providers[a].priority > providers[b].priority;
+    return providers[a].next_due < providers[b].next_due;
+  });
+
+  // indices stay valid while providers add or remove themselves from update()
+  updating = true;
+  Timer timer(true);
+  int count = 0;
+  for(size_t index : due) {
+    if(count > 0 && time_cap > 0.0 && timer.getSeconds() * 1000.0 >= time_cap) {
+      providers[index].stats.deferred++;
+      continue;
+    }
+    auto provider = providers[index].provider.lock();
+    if(!provider) continue;
+    record_update(providers[index], now, period);
+    count++;
+    provider->update();
+  }
+  updating = false;
+  last_update_ms = timer.getSeconds() * 1000.0;
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+// std
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+class texture_provider;
+
+/////////////////////////////////////////////////
+//
+//  upload_scheduler
+//  Runs texture uploads and renders submitted by
+//  providers within a per-frame time and byte budget
+//
+/////////////////////////////////////////////////
+class upload_scheduler {
+public:
+  // a unit of gpu work, returns the number of bytes it uploaded or rendered
+  typedef std::function<size_t()> work_fn;
+
+  //////////////////////////////////////////////////////
+  // getters
+  //////////////////////////////////////////////////////
+  static bool is_enabled();
+
+  // number of times process() has been called
+  static uint64_t get_frame();
+
+  static size_t get_queue_size();
+
+  // seconds between submission and execution, averaged over the last second of work
+  static double get_average_latency();
+
+  static double get_max_latency();
+
+  // milliseconds spent by the last process(), gpu time when timer queries are available
+  static double get_last_frame_ms();
+
+  //////////////////////////////////////////////////////
+  // setters
+  //////////////////////////////////////////////////////
+  // when disabled, submitted work runs immediately
+  static void set_enabled(bool enabled);
+
+  static void set_time_budget(double ms);
+
+  // 0 = unlimited
+  static void set_byte_budget(size_t bytes);
+
+  //////////////////////////////////////////////////////
+  // methods
+  //////////////////////////////////////////////////////
+  // queue work for a provider, replacing any work the provider has pending
+  static void submit(texture_provider * owner, size_t bytes, work_fn work);
+
+  // drop any pending work for a provider
+  static void cancel(texture_provider * owner);
+
+  // run queued work, visible providers first, call once per frame from the gl thread
+  static void process();
+};
+
+/////////////////////////////////////////////////
+//
+//  provider_scheduler
+//  Calls update() on registered providers at their
+//  own target rate, aligned to the display's frame
+//  period, highest priority first and within an
+//  optional per-frame time cap
+//
+/////////////////////////////////////////////////
+class provider_scheduler {
+public:
+  class stats {
+  public:
+    uint64_t updates = 0;
+    uint64_t skipped = 0;     // frames where the next update was not yet due
+    uint64_t deferred = 0;    // frames where an update was due but over the time cap
+    double mean_jitter_ms = 0.0;  // distance of the update interval from the target interval
+    double max_jitter_ms = 0.0;
+  };
+
+  //////////////////////////////////////////////////////
+  // getters
+  //////////////////////////////////////////////////////
+  static size_t size();
+
+  // the measured frame period unless set with set_display_rate()
+  static double get_display_rate();
+
+  // milliseconds spent in provider updates by the last update()
+  static double get_last_update_ms();
+
+  static stats get_stats(texture_provider * provider);
+
+  // all providers combined
+  static stats get_stats();
+
+  //////////////////////////////////////////////////////
+  // setters
+  //////////////////////////////////////////////////////
+  // 0 = measure it from the time between update() calls
+  static void set_display_rate(double hz);
+
+  // 0 = unlimited, the highest priority due provider always runs
+  static void set_time_cap(double ms);
+
+  //////////////////////////////////////////////////////
+  // methods
+  //////////////////////////////////////////////////////
+  // schedule a provider at rate updates per second, 0 = every frame,
+  // adding it again changes its rate and priority
+  static void add(const std::shared_ptr<texture_provider> & provider, double rate, int priority = 0);
+
+  static void remove(texture_provider * provider);
+
+  static void clear();
+
+  static void reset_stats();
+
+  // update the providers that are due, call once per frame from App::update()
+  static void update();
+
+  // the same at a given time in seconds, ie. an offline renderer's virtual clock
+  static void update(double now);
+};
@@ -0,0 +1,239 @@
+// std
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+
+// cinder
+#include "cinder/Log.h"
+#include "cinder/Timer.h"
+#include "cinder/gl/gl.h"
+
+// sfmoma
+#include "memory.h"
+#include "profiler.h"
+#include "shader.h"
+
+using namespace ci;
+
+namespace {
+  std::array<gl::GlslProgRef, sprite_shader::variant_count> programs;
+  std::array<bool, sprite_shader::variant_count> variants_warmed = {};
+  bool warmed = false;
+  double warm_time = 0.0;
+  uint64_t draw_calls = 0;
+
+#if defined( CINDER_GL_ES )
+  const char * header =
+    "#version 300 es\n"
+    "precision highp float;\n";
+#else
+  const char * header =
+    "#version 150\n";
+#endif
+
+  const char * vertex_source = R"(
+    uniform mat4 ciModelViewProjection;
+    in vec4 ciPosition;
+    in vec2 ciTexCoord0;
+    in vec4 ciColor;
+    out vec2 vTexCoord;
+    out vec4 vColor;
+    out vec2 vPosition;
+    void main() {
+      vTexCoord = ciTexCoord0;
+      vColor = ciColor;
+      vPosition = ciPosition.xy;
+      gl_Position = ciModelViewProjection * ciPosition;
+    }
+  )";
+
+  const char * fragment_source = R"(
+    uniform sampler2D uTex0;
+    uniform vec4 uMask;
+    uniform float uFeather;
+    in vec2 vTexCoord;
+    in vec4 vColor;
+    in vec2 vPosition;
+    out vec4 oColor;
+
+  #ifdef BICUBIC
+    vec4 cubic(float v) {
+      vec4 n = vec4(1.0, 2.0, 3.0, 4.0) - v;
+      vec4 s = n * n * n;
+      float x = s.x;
+      float y = s.y - 4.0 * s.x;
+      float z = s.z - 4.0 * s.y + 6.0 * s.x;
+      float w = 6.0 - x - y - z;
+      return vec4(x, y, z, w) * (1.0 / 6.0);
+    }
+
+    // b-spline filter built from four bilinear taps
+    vec4 sample_texture(vec2 uv) {
+      vec2 size = vec2(textureSize(uTex0, 0));
+      vec2 inv = 1.0 / size;
+      uv = uv * size - 0.5;
+      vec2 f = fract(uv);
+      uv -= f;
+      vec4 xc = cubic(f.x);
+      vec4 yc = cubic(f.y);
+      vec4 c = uv.xxyy + vec2(-0.5, 1.5).xyxy;
+      vec4 s = vec4(xc.xz + xc.yw, yc.xz + yc.yw);
+      vec4 offset = (c + vec4(xc.yw, yc.yw) / s) * inv.xxyy;
+      vec4 s0 = texture(uTex0, offset.xz);
+      vec4 s1 = texture(uTex0, offset.yz);
+      vec4 s2 = texture(uTex0, offset.xw);
+      vec4 s3 = texture(uTex0, offset.yw);
+      float sx = s.x / (s.x + s.y);
+      float sy = s.z / (s.z + s.w);
+      return mix(mix(s3, s2, sx), mix(s1, s0, sx), sy);
+    }
+  #else
+    vec4 sample_texture(vec2 uv) {
+      return texture(uTex0, uv);
+    }
+  #endif
+
+    void main() {
+      vec4 c = sample_texture(vTexCoord);
+      float a = vColor.a;
+  #ifdef TINT
+      c.rgb *= vColor.rgb;
+  #endif
+  #ifdef FEATHER
+      vec2 d = min(vPosition - uMask.xy, uMask.zw - vPosition);
+      a *= clamp(min(d.x, d.y) / uFeather, 0.0, 1.0);
+  #endif
+  #ifdef PREMULT
+      oColor = vec4(c.rgb * c.a * a, c.a * a);
+  #else
+      oColor = vec4(c.rgb, c.a * a);
+  #endif
+    }
+  )";
+
+  std::string defines(int variant) {
+    std::string d;
+    if(variant & sprite_shader::Premult) d += "#define PREMULT\n";
+    if(variant & sprite_shader::Tint) d += "#define TINT\n";
+    if(variant & sprite_shader::Feather) d += "#define FEATHER\n";
+    if(variant & sprite_shader::Bicubic) d += "#define BICUBIC\n";
+    return d;
+  }
+}
+
+/////////////////////////////////////////////////
+//
+//  sprite_shader
+//
+/////////////////////////////////////////////////
+gl::GlslProgRef sprite_shader::build(int variant) {
+  std::string d = defines(variant);
+  try {
+    return gl::GlslProg::create(gl::GlslProg::Format()
+      .vertex(std::string(header) + d + vertex_source)
+      .fragment(std::string(header) + d + fragment_source));
+  } catch(const gl::GlslProgExc & e) {
+    CI_LOG_E("Error compiling sprite shader variant " << variant << ": " << e.what());
+    return nullptr;
+  }
+}
+
+gl::GlslProgRef sprite_shader::get(int variant) {
+  variant &= variant_count - 1;
+  if(!programs[variant]) {
+    if(warmed) CI_LOG_W("Sprite shader variant " << variant << " compiled on the hot path");
+    programs[variant] = build(variant);
+  }
+  return programs[variant];
+}
+
+void sprite_shader::warm() {
+  if(warmed) return;
+  Timer timer(true);
+  for(int variant = 0; variant < variant_count; variant++) {
+    warm(variant);
+  }
+  CI_LOG_I("Warmed " << variant_count << " sprite shader variants in " << timer.getSeconds() * 1000.0 << "ms");
+}
+
+void sprite_shader::warm(int variant) {
+  variant &= variant_count - 1;
+  if(variants_warmed[variant]) return;
+  Timer timer(true);
+  if(!programs[variant]) programs[variant] = build(variant);
+
+  // a tiny target and texture, drawing forces the driver to finish
+  // any deferred compilation for the variant's state
+  gl::FboRef target = gl::Fbo::create(4, 4, gl::Fbo::Format().disableDepth());
+  gl::TextureRef texture = gl::Texture::create(4, 4);
+  gpu_memory::track(target, "sprite_shader");
+  gpu_memory::track(texture, "sprite_shader");
+
+  gl::ScopedFramebuffer scoped_fbo(target);
+  gl::ScopedViewport scoped_viewport(ivec2(0), target->getSize());
+  gl::ScopedMatrices scoped_matrices;
+  gl::setMatricesWindow(target->getSize());
+  draw(texture, Rectf(0, 0, 4, 4), Rectf(0, 0, 4, 4), variant, 1.0f);
+  glFinish();
+
+  variants_warmed[variant] = true;
+  warmed = std::all_of(variants_warmed.begin(), variants_warmed.end(), [](bool v) { return v; });
+  warm_time += timer.getSeconds();
+}
+
+bool sprite_shader::is_warm() {
+  return warmed;
+}
+
+double sprite_shader::get_warm_time() {
+  return warm_time;
+}
+
+void sprite_shader::set_cache_directory(const std::string & path) {
+  // GlslProg can only be built from source, so rather than keeping
+  // program binaries ourselves we enable the drivers' own disk caches
+#if defined( CINDER_MSW )
+  _putenv_s("__GL_SHADER_DISK_CACHE", "1");
+  _putenv_s("__GL_SHADER_DISK_CACHE_PATH", path.c_str());
+#else
+  setenv("MESA_SHADER_CACHE_DIR", path.c_str(), 1);
+  setenv("MESA_GLSL_CACHE_DIR", path.c_str(), 1);
+  setenv("__GL_SHADER_DISK_CACHE", "1", 1);
+  setenv("__GL_SHADER_DISK_CACHE_PATH", path.c_str(), 1);
+#endif
+}
+
+void sprite_shader::draw(
+  const gl::TextureRef & texture, const Rectf & src, const Rectf & dst, int variant, float feather) {
+  if(!texture) return;
+
+  gl::GlslProgRef prog = get(variant);
+  if(!prog) return;
+
+  gl::ScopedGlslProg scoped_prog(prog);
+  gl::ScopedTextureBind scoped_texture(texture, 0);
+  prog->uniform("uTex0", 0);
+  if(variant & Feather) {
+    prog->uniform("uMask", vec4(dst.x1, dst.y1, dst.x2, dst.y2));
+    prog->uniform("uFeather", std::max(feather, 0.0001f));
+  }
+
+  // float texcoords so that masks and zoom areas animate smoothly
+  vec2 size = texture->getSize();
+  Rectf uv(src.x1 / size.x, src.y1 / size.y, src.x2 / size.x, src.y2 / size.y);
+  if(!texture->isTopDown()) {
+    uv.y1 = 1.0f - uv.y1;
+    uv.y2 = 1.0f - uv.y2;
+  }
+  gl::drawSolidRect(dst, uv.getUpperLeft(), uv.getLowerRight());
+  draw_calls++;
+  SPRITE_PROFILE_COUNT("draw_calls", 1);
+}
+
+uint64_t sprite_shader::get_draw_calls() {
+  return draw_calls;
+}
+
+void sprite_shader::count_draw_calls(uint64_t n) {
+  draw_calls += n;
+}
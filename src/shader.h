@@ -0,0 +1,74 @@
+#pragma once
+
+// std
+#include <cstdint>
+#include <string>
+
+// cinder
+#include "cinder/Area.h"
+#include "cinder/Rect.h"
+#include "cinder/gl/GlslProg.h"
+#include "cinder/gl/Texture.h"
+
+/////////////////////////////////////////////////
+//
+//  sprite_shader
+//  A library of precompiled shader variants,
+//  one for each permutation of sprite draw state
+//
+/////////////////////////////////////////////////
+class sprite_shader {
+public:
+  //////////////////////////////////////////////////////
+  // enums
+  //////////////////////////////////////////////////////
+  // feature flags, or'd together to form a variant key
+  enum feature {
+    Premult = 1 << 0,   // output premultiplied alpha (straight alpha otherwise)
+    Tint    = 1 << 1,   // multiply the sample by the vertex color
+    Feather = 1 << 2,   // soften the edges of the mask rect
+    Bicubic = 1 << 3    // bicubic sampling (bilinear otherwise)
+  };
+
+  static const int variant_count = 1 << 4;
+
+  //////////////////////////////////////////////////////
+  // static
+  //////////////////////////////////////////////////////
+  // get the program for a variant, compiling it if it has not been warmed
+  static ci::gl::GlslProgRef get(int variant);
+
+  // compile, link and draw with every variant so none are built lazily,
+  // variants that are already warm are skipped
+  static void warm();
+
+  // compile, link and draw with a single variant, once
+  static void warm(int variant);
+
+  // whether every variant has been warmed
+  static bool is_warm();
+
+  // time spent warming variants, in seconds
+  static double get_warm_time();
+
+  // point the driver's on-disk shader cache at a directory,
+  // must be called before the gl context is created (ie. in prepareSettings)
+  static void set_cache_directory(const std::string & path);
+
+  // draw a region of a texture into a rect using the given variant
+  static void draw(
+    const ci::gl::TextureRef & texture,
+    const ci::Rectf & src,
+    const ci::Rectf & dst,
+    int variant,
+    float feather = 0.0f);
+
+  // draw calls issued by the block, kept whether or not profiling is built in
+  static uint64_t get_draw_calls();
+
+  // add draws made outside of draw(), ie. by text_batch
+  static void count_draw_calls(uint64_t n);
+
+private:
+  static ci::gl::GlslProgRef build(int variant);
+};
@@ -1,5 +1,6 @@
 // std
 #include <algorithm>
+#include <vector>
 
 // cinder
 #include "cinder/app/App.h"
@@ -8,20 +9,105 @@
 
 // sfmoma
 #include "sprite.h"
+#include "color.h"
+#include "dirty.h"
+#include "profiler.h"
 #include "provider.h"
+#include "shader.h"
 
 using namespace ci;
 using namespace ci::app;
 
+namespace {
+  TimelineRef default_timeline;
+
+  // never destroyed, sprites held in statics may outlive it
+  slab_pool & get_sprite_pool() {
+    static slab_pool * pool = new slab_pool("sprite");
+    return *pool;
+  }
+
+  uint64_t fbo_render_count = 0;
+  uint64_t fbo_shared_count = 0;
+
+  // sprites with tweens running, checked for changes as each dirty_tracker frame begins
+  std::vector<sprite *> watched_sprites;
+
+  bool same_rect(const Rectf & a, const Rectf & b) {
+    return a.getUpperLeft() == b.getUpperLeft() && a.getLowerRight() == b.getLowerRight();
+  }
+
+  // with linear blending writes to sRGB targets are encoded, ES always encodes them
+  class scoped_linear_blend {
+  public:
+    scoped_linear_blend() : enabled(color_policy::is_linear_blending()) {
+#if ! defined( CINDER_GL_ES )
+      if(enabled) gl::context()->pushBoolState(GL_FRAMEBUFFER_SRGB, GL_TRUE);
+#endif
+    }
+
+    ~scoped_linear_blend() {
+#if ! defined( CINDER_GL_ES )
+      if(enabled) gl::context()->popBoolState(GL_FRAMEBUFFER_SRGB);
+#endif
+    }
+
+    bool enabled;
+  };
+}
+
 ////////////////////////////////////////////////////
 //  static
 ////////////////////////////////////////////////////
 sprite_ref sprite::create(const texture_provider_ref provider){
-  return std::make_shared<sprite>(provider);
+  return std::allocate_shared<sprite>(pool_allocator<sprite>(get_sprite_pool()), provider);
 }
 
 sprite_ref sprite::create(provider_type type) {
-  return std::make_shared<sprite>(type);
+  return std::allocate_shared<sprite>(pool_allocator<sprite>(get_sprite_pool()), type);
+}
+
+slab_pool::stats sprite::get_pool_stats() {
+  return get_sprite_pool().get_stats();
+}
+
+uint64_t sprite::get_fbo_render_count() {
+  return fbo_render_count;
+}
+
+uint64_t sprite::get_fbo_shared_count() {
+  return fbo_shared_count;
+}
+
+void sprite::reset_fbo_stats() {
+  fbo_render_count = 0;
+  fbo_shared_count = 0;
+}
+
+void sprite::init() {
+  sprite_shader::warm();
+}
+
+preloader_ref sprite::init(const preload_manifest & manifest) {
+  return preloader::create(manifest);
+}
+
+gl::Fbo::Format sprite::get_fbo_format() {
+  return color_policy::get_fbo_format(color_policy::select());
+}
+
+gl::Fbo::Format sprite::get_fbo_format(GLint input_format) {
+  return color_policy::get_fbo_format(color_policy::get_format(input_format));
+}
+
+Timeline & sprite::get_default_timeline() {
+  return default_timeline ? *default_timeline : ci::app::timeline();
+}
+
+TimelineRef sprite::set_default_timeline(TimelineRef new_timeline) {
+  TimelineRef previous = default_timeline;
+  default_timeline = new_timeline;
+  return previous;
 }
 
 //////////////////////////////////////////////////////
@@ -33,7 +119,14 @@ sprite::sprite(const texture_provider_ref texture_provider) {
   scale() = vec2(1.0f);
   tint() = Color::white();
   use_premult = true;
+  mask_feather = 0.0f;
   zoom() = 0.0f;
+  output_revision = 0;
+  damaged_bounds = Rectf(0, 0, 0, 0);
+  damaged_alpha = 0.0f;
+  damaged_zoom = 0.0f;
+  watched = false;
+  watch_index = 0;
   
   // make sure to call this at the end
   set_provider(texture_provider);
@@ -45,7 +138,14 @@ sprite::sprite(provider_type type) {
   scale() = vec2(1.0f);
   tint() = Color::white();
   use_premult = true;
+  mask_feather = 0.0f;
   zoom() = 0.0f;
+  output_revision = 0;
+  damaged_bounds = Rectf(0, 0, 0, 0);
+  damaged_alpha = 0.0f;
+  damaged_zoom = 0.0f;
+  watched = false;
+  watch_index = 0;
   
   // TODO: Create default create methods for each provider type
   switch(type) {
@@ -62,33 +162,42 @@ sprite::sprite(provider_type type) {
 //////////////////////////////////////////////////////
 void sprite::set_alpha(float new_alpha) {
   alpha = std::max(0.0f, std::min(new_alpha, 1.0f));
+  damage();
 }
 
 void sprite::set_coordinates(vec2 new_coordinates) {
   coordinates = new_coordinates;
+  damage();
+}
+
+void sprite::set_mask_feather(float new_feather) {
+  mask_feather = std::max(0.0f, new_feather);
+  damage();
 }
 
 void sprite::set_origin(origin_point new_origin) {
   origin = new_origin;
+  damage();
 }
 
-void sprite::set_premult(bool p) { use_premult = p; }
+void sprite::set_premult(bool p) {
+  use_premult = p;
+  damage();
+}
 
 void sprite::set_provider(texture_provider_ref provider_ref) {
+  if(provider) provider->remove_listener(this);
   provider = provider_ref;
   
-  if(texture_update_handler.isConnected()) {
-    texture_update_handler.disable();
-    texture_update_handler.disconnect();
-  }
-  
-  // Add a handler for texture updates from provider
-  texture_update_handler = provider->texture_update.connect(
-    std::bind(&sprite::on_provider_texture_update, this));
+  // listen for texture updates from provider
+  provider->add_listener(this);
   
+  // sprites sharing the output keep drawing the previous provider
+  unshare_fbo();
   if(provider->is_ready()) {
-    on_provider_texture_update();
+    on_provider_texture_update(Area(ivec2(0), ivec2(provider->get_size())));
   }
+  damage();
 }
 
 void sprite::set_scale(float new_scale) {
@@ -97,6 +206,7 @@ void sprite::set_scale(float new_scale) {
 
 void sprite::set_scale(vec2 new_scale) {
   scale() = vec2(std::max(0.0f, new_scale.x), std::max(0.0f, new_scale.y));
+  damage();
 }
 
 void sprite::set_source(std::string source) {
@@ -107,28 +217,49 @@ void sprite::set_source(std::string source) {
   }
 }
 
+void sprite::set_timeline(TimelineRef new_timeline) {
+  timeline = new_timeline;
+}
+
 void sprite::set_tint(Color new_color) {
   tint() = new_color;
+  damage();
 }
 
 void sprite::set_zoom_center(vec2 new_zoom_center) {
   zoom_center = new_zoom_center;
   update_zoom();
+  unshare_fbo();
+  update_fbo();
 }
 
 void sprite::set_zoom(float new_zoom) {
   zoom = new_zoom;
   update_zoom();
+  unshare_fbo();
   update_fbo();
 }
 
 //////////////////////////////////////////////////////
 // getters
 //////////////////////////////////////////////////////
+Timeline & sprite::get_timeline() {
+  return timeline ? *timeline : get_default_timeline();
+}
+
 ci::Rectf sprite::get_bounds() {
-  ci::Rectf b = Rectf(bounds);
+  if(provider) provider->deliver_updates();
+  return get_frame_bounds(bounds.getSize());
+}
+
+/**
+ * Where the sprite is for a texture of size, without delivering
+ * the provider's pending updates
+ */
+ci::Rectf sprite::get_frame_bounds(vec2 size) {
+  ci::Rectf b = Rectf(vec2(0), size);
   b.offset(coordinates());
-  if(origin == origin_point::Center) b.offset(-bounds.getSize() * 0.5f);
+  if(origin == origin_point::Center) b.offset(-size * 0.5f);
   b.scaleCentered(scale());
   return b;
 }
@@ -143,18 +274,22 @@ texture_provider_ref sprite::get_provider() {
 ci::TweenRef<float> sprite::alpha_to(float target, float duration, float delay, EaseFn ease_fn, bool append) {
   if (duration <= 0) {
     alpha = 0;
+    damage();
     return nullptr;
   } else {
-    if(append) return ci::app::timeline().appendTo(&alpha, target, duration).delay(delay).easeFn(ease_fn);
-    return ci::app::timeline().apply(&alpha, target, duration).delay(delay).easeFn(ease_fn);
+    watch();
+    if(append) return get_timeline().appendTo(&alpha, target, duration).delay(delay).easeFn(ease_fn);
+    return get_timeline().apply(&alpha, target, duration).delay(delay).easeFn(ease_fn);
   }
 }
 
 ci::TweenRef<ci::Rectf> sprite::apply_mask_animation(Rectf startMask, Rectf targetMask, float duration, float delay, EaseFn easeFn) {
-  return ci::app::timeline().apply(&mask, startMask, targetMask, duration).delay(delay).easeFn(easeFn);
+  watch();
+  return get_timeline().apply(&mask, startMask, targetMask, duration).delay(delay).easeFn(easeFn);
 }
 
 bool sprite::contains_point(const ci::vec2 & p) {
+  if(provider) provider->deliver_updates();
   ci::Rectf b(bounds);
   b.offset(coordinates());
   if(origin == origin_point::Center) b.offset(-bounds.getSize() * 0.5f);
@@ -163,17 +298,37 @@ bool sprite::contains_point(const ci::vec2 & p) {
 }
 
 void sprite::draw() {
+  // changes wait until a sprite showing the provider draws, which
+  // delivers them to every sprite listening, hidden ones included
+  if(alpha() > 0.0 && provider) provider->deliver_updates();
   if(alpha() > 0.0 && output) {
+    SPRITE_PROFILE_SCOPE("sprite::draw");
+    if(provider) provider->mark_visible();
     gl::ScopedMatrices m1;
     gl::translate(coordinates());
     gl::scale(scale());
     if(origin == origin_point::Center) {
       gl::translate(-texture_size * 0.5f);
     }
+    int variant = 0;
+    if(use_premult) variant |= sprite_shader::Premult;
+    if(tint() != Color::white()) variant |= sprite_shader::Tint;
+    if(mask_feather > 0.0f) variant |= sprite_shader::Feather;
+    
+    // drawn straight from an atlas, the mask is relative to the frame's area of it
+    Rectf source = mask;
+    if(output == input && provider) source += vec2(provider->get_source_area().getUL());
+
     gl::ScopedColor sc;
-    gl::ScopedBlendAlpha sa;
     gl::color(ColorA(tint, alpha));
-    gl::draw(output, Area(mask), mask);
+    scoped_linear_blend linear;
+    if(use_premult) {
+      gl::ScopedBlendPremult sp;
+      sprite_shader::draw(output, source, mask, variant, mask_feather);
+    } else {
+      gl::ScopedBlendAlpha sa;
+      sprite_shader::draw(output, source, mask, variant, mask_feather);
+    }
   }
 }
 
@@ -195,7 +350,8 @@ ci::TweenRef<ci::Rectf> sprite::mask_hide(mask_type type, float duration, float
           bounds.x1, bounds.y1, bounds.x1, bounds.y2), duration, delay, ease_fn);
     }
     default:
-      return ci::app::timeline().apply(&mask, Rectf(0, 0, 0, 0), 0.0f).delay(delay);
+      watch();
+      return get_timeline().apply(&mask, Rectf(0, 0, 0, 0), 0.0f).delay(delay);
   }
 }
 
@@ -217,7 +373,8 @@ ci::TweenRef<ci::Rectf> sprite::mask_reveal(mask_type type, float duration, floa
           Rectf(bounds), duration, delay, ease_fn);
     }
     default:
-      return ci::app::timeline().appendTo(&mask, Rectf(vec2(0), texture_size), 0.0f).delay(delay);
+      watch();
+      return get_timeline().appendTo(&mask, Rectf(vec2(0), texture_size), 0.0f).delay(delay);
   }
 }
 
@@ -227,10 +384,12 @@ ci::TweenRef<ci::Rectf> sprite::mask_reveal(mask_type type, float duration, floa
 ci::TweenRef<vec2> sprite::move_to(vec2 target, float duration, float delay, EaseFn ease_fn, bool append) {
   if (duration <= 0) {
     coordinates = target;
+    damage();
     return nullptr;
   } else {
-    if(append) return ci::app::timeline().appendTo(&coordinates, target, duration).delay(delay).easeFn(ease_fn);
-    return ci::app::timeline().apply(&coordinates, target, duration).delay(delay).easeFn(ease_fn);
+    watch();
+    if(append) return get_timeline().appendTo(&coordinates, target, duration).delay(delay).easeFn(ease_fn);
+    return get_timeline().apply(&coordinates, target, duration).delay(delay).easeFn(ease_fn);
   }
 }
 
@@ -240,38 +399,59 @@ ci::TweenRef<vec2> sprite::move_to(vec2 target, float duration, float delay, Eas
 ci::TweenRef<vec2> sprite::scale_to(ci::vec2 target, float duration, float delay, ci::EaseFn ease_fn) {
   if (duration <= 0) {
     scale() = target;
+    damage();
     return nullptr;
   } else {
-    return ci::app::timeline().apply(&scale, target, duration).delay(delay).easeFn(ease_fn);
+    watch();
+    return get_timeline().apply(&scale, target, duration).delay(delay).easeFn(ease_fn);
   }
 }
 
 ci::TweenRef<vec2> sprite::scale_to(float target, float duration, float delay, ci::EaseFn ease_fn) {
   if (duration <= 0) {
     scale() = vec2(target);
+    damage();
     return nullptr;
   } else {
-    return ci::app::timeline().apply(&scale, vec2(target), duration).delay(delay).easeFn(ease_fn);
+    watch();
+    return get_timeline().apply(&scale, vec2(target), duration).delay(delay).easeFn(ease_fn);
   }
 }
 
 ci::TweenRef<ci::Color> sprite::tint_to(Color target, float duration, float delay, EaseFn ease_fn) {
   if (duration <= 0) {
     tint = target;
+    damage();
     return nullptr;
   } else {
-    return ci::app::timeline().apply(&tint, target, duration).delay(delay).easeFn(ease_fn);
+    watch();
+    return get_timeline().apply(&tint, target, duration).delay(delay).easeFn(ease_fn);
   }
 }
 
 /**
  * Handles a texture change in the provider
  */
-void sprite::on_provider_texture_update() {
-  if (provider && provider->has_new_texture()) {
+void sprite::on_provider_texture_update(const Area & changed) {
+  if (provider && provider->get_revision() != output_revision) {
+    output_revision = provider->get_revision();
+
     // get the updated texture
+    gl::TextureRef previous = input;
     input = provider->get_texture();
 
+    // atlas frames are drawn straight from the atlas, see update_fbo()
+    bool direct = draws_direct();
+
+    // sprites sharing the fbo composite it once between them
+    if (!direct && texture_size == provider->get_size() && share_output()) return;
+
+    // a texture updated in place only needs the changed region recomposited
+    if (!direct && fbo && output && input == previous && texture_size == provider->get_size()) {
+      update_fbo_region(changed);
+      return;
+    }
+
     // if the size of the texture changes we need to update all size related vars
     if (texture_size != provider->get_size()) {
 
@@ -284,8 +464,13 @@ void sprite::on_provider_texture_update() {
       zoom_center = texture_size * 0.5f;
       update_zoom();
       
-      // since the size changed, we set the fbo to null, which will
-      fbo = gl::Fbo::create(texture_size.x, texture_size.y, true);
+      // since the size changed, swap the fbo for a pooled one of the new size
+      // (providers without a 2d texture, ie. array_provider, need none)
+      release_fbo();
+      output.reset();
+      if (!direct && share_output()) return;
+      fbo_format = input ? get_fbo_format(input->getInternalFormat()) : get_fbo_format();
+      fbo = input && !direct ? fbo_pool::acquire(texture_size, fbo_format, "sprite") : nullptr;
     }
     
     // ...and finally
@@ -294,49 +479,240 @@ void sprite::on_provider_texture_update() {
 }
 
 /**
- * Update the contents of this sprite
+ * Update the contents of this sprite, only region of the fbo when
+ * given, top-left origin in fbo pixels
  */
-void sprite::update_fbo() {
+void sprite::update_fbo(const Area * region) {
+  // nothing to composite, draw() offsets the mask by the source area instead
+  if (input && draws_direct()) {
+    release_fbo();
+    output = input;
+    return;
+  }
+
   if (input) {
+    SPRITE_PROFILE_SCOPE("sprite::update_fbo");
+    fbo_render_count++;
     if (!fbo) {
-      gl::Fbo::Format format;
-      format.setSamples(4);
-      format.setColorTextureFormat(gl::Fbo::Format::getDefaultDepthTextureFormat());
-      fbo = gl::Fbo::create(texture_size.x, texture_size.y, format);
+      // a textured quad has no edges to antialias, so no samples and no resolve
+      fbo_format = get_fbo_format(input->getInternalFormat());
+      fbo = fbo_pool::acquire(texture_size, fbo_format, "sprite");
     }
     
     gl::ScopedMatrices scoped_matrices;
     gl::ScopedFramebuffer scoped_fbo(fbo);
     gl::ScopedViewport scoped_viewport(ivec2(0), fbo->getSize());
     gl::setMatricesWindow(fbo->getSize());
+
+    // scissored to the fbo or the region rather than whatever window scissor is current,
+    // ie. dirty_tracker::scoped_damage's; scissor boxes are bottom-left origin
+    Area pixels = region ? *region : Area(ivec2(0), fbo->getSize());
+    gl::ScopedScissor scoped_scissor(pixels.x1, fbo->getHeight() - pixels.y2, pixels.getWidth(), pixels.getHeight());
     gl::clear(ColorA(0, 0, 0, 0));
+    scoped_linear_blend linear;
+    gl::ScopedColor scoped_color(Color::white());
+    int variant = zoom() > 0.0f ? sprite_shader::Bicubic : 0;
+    
+    // the zoom area is relative to the provider's region of the texture
+    Rectf source = Rectf(zoom_area) + (provider ? vec2(provider->get_source_area().getUL()) : vec2(0));
     if(use_premult) {
       gl::ScopedBlendPremult pre;
-      gl::draw(input, zoom_area, fbo->getBounds());
+      sprite_shader::draw(input, source, Rectf(fbo->getBounds()), variant);
       output = fbo->getColorTexture();
     } else {
-      gl::draw(input, zoom_area, fbo->getBounds());
+      sprite_shader::draw(input, source, Rectf(fbo->getBounds()), variant);
       output = fbo->getColorTexture();
     }
   }
 }
 
+/**
+ * Recomposite the part of the fbo showing the changed area of the input,
+ * padded by the bicubic filter's footprint
+ */
+void sprite::update_fbo_region(const Area & changed) {
+  Rectf area(zoom_area);
+  if (area.getWidth() <= 0 || area.getHeight() <= 0) return;
+
+  vec2 fbo_size = fbo->getSize();
+  vec2 scale = fbo_size / area.getSize();
+  Rectf region(
+    (vec2(changed.getUL()) - area.getUpperLeft()) * scale,
+    (vec2(changed.getLR()) - area.getUpperLeft()) * scale);
+  region.inflate(glm::max(scale, vec2(1.0f)) * 2.0f + vec2(1.0f));
+
+  Area pixels = Area(region).getClipBy(Area(ivec2(0), ivec2(fbo_size)));
+  if (pixels.getWidth() <= 0 || pixels.getHeight() <= 0) return;
+  update_fbo(&pixels);
+}
+
+/**
+ * Another sprite listening to the provider that composited the same
+ * revision of the same area in the same way has the output this one
+ * would render, so take that rather than render it again
+ */
+bool sprite::share_output() {
+  if (!provider || !input) return false;
+  for (texture_listener * listener = provider->get_first_listener(); listener; listener = listener->get_next_listener()) {
+    sprite * other = dynamic_cast<sprite *>(listener);
+    if (!other || other == this || !other->fbo || !other->output) continue;
+    if (other->output_revision != output_revision || other->input != input) continue;
+    if (other->texture_size != texture_size || other->zoom_area != zoom_area) continue;
+    if (other->use_premult != use_premult || (other->zoom() > 0.0f) != (zoom() > 0.0f)) continue;
+
+    if (fbo != other->fbo) {
+      release_fbo();
+      fbo = other->fbo;
+      fbo_format = other->fbo_format;
+    }
+    output = other->output;
+    fbo_shared_count++;
+    return true;
+  }
+  return false;
+}
+
+bool sprite::draws_direct() {
+  return provider && provider->is_atlas() && zoom() <= 0.0f;
+}
+
+void sprite::unshare_fbo() {
+  if (fbo && fbo.use_count() > 1) fbo.reset();
+}
+
+void sprite::release_fbo() {
+  if (fbo && fbo.use_count() == 1) fbo_pool::release(fbo, fbo_format);
+  fbo.reset();
+}
+
 void sprite::update_zoom() {
   float z = 1.0f - zoom;
   vec2 ul = zoom_center - texture_size * 0.5f * z;
   vec2 lr = zoom_center + texture_size * 0.5f * z;
   zoom_area = Area(ul, lr);
+  
+  // streaming providers render the zoomed region at full resolution themselves
+  if(provider && texture_size.x > 0 && texture_size.y > 0) {
+    if(provider->set_view_area(Rectf(ul / texture_size, lr / texture_size))) {
+      zoom_area = Area(vec2(0), texture_size);
+    }
+  }
+  damage();
+}
+
+/**
+ * Report where the sprite was and where it is now to the dirty_tracker
+ */
+void sprite::damage() {
+  if(!dirty_tracker::is_enabled()) return;
+  Rectf now = alpha() > 0.0f ? get_frame_bounds(texture_size) : Rectf(0, 0, 0, 0);
+  dirty_tracker::damage(damaged_bounds);
+  dirty_tracker::damage(now);
+  damaged_bounds = now;
+  damaged_alpha = alpha();
+  damaged_tint = tint();
+  damaged_mask = mask();
+  damaged_zoom = zoom();
+}
+
+/**
+ * Tweens change the sprite without telling it, so rather than rely
+ * on an update callback a caller could replace, each sprite with
+ * tweens running is compared with what was last damaged as the
+ * dirty_tracker's frame begins, and forgotten once they finish
+ */
+void sprite::damage_watched() {
+  for(size_t i = 0; i < watched_sprites.size();) {
+    sprite * sp = watched_sprites[i];
+    if(sp->changed_since_damage()) sp->damage();
+    if(sp->is_animating()) {
+      i++;
+      continue;
+    }
+    sp->unwatch();
+  }
+}
+
+void sprite::watch() {
+  static bool hooked = false;
+  if(!hooked) {
+    dirty_tracker::add_frame_hook(&sprite::damage_watched);
+    hooked = true;
+  }
+  if(watched) return;
+  watched = true;
+  watch_index = watched_sprites.size();
+  watched_sprites.push_back(this);
+}
+
+/**
+ * Swap the last watched sprite into this one's place,
+ * so destroying many sprites is not quadratic
+ */
+void sprite::unwatch() {
+  if(!watched) return;
+  sprite * last = watched_sprites.back();
+  watched_sprites[watch_index] = last;
+  last->watch_index = watch_index;
+  watched_sprites.pop_back();
+  watched = false;
+  watch_index = 0;
+}
+
+bool sprite::is_animating() {
+  Timeline & t = get_timeline();
+  float now = t.getCurrentTime();
+  void * targets[] = { &alpha, &coordinates, &mask, &scale, &tint, &zoom };
+  for(void * target : targets) {
+    bool found = false;
+    float end = t.findEndTimeOf(target, &found);
+    if(found && end >= now) return true;
+  }
+  return false;
+}
+
+bool sprite::changed_since_damage() {
+  Rectf now = alpha() > 0.0f ? get_frame_bounds(texture_size) : Rectf(0, 0, 0, 0);
+  return !same_rect(now, damaged_bounds) || alpha() != damaged_alpha || tint() != damaged_tint
+    || !same_rect(mask(), damaged_mask) || zoom() != damaged_zoom;
+}
+
+/**
+ * An update waiting for delivery damages the part of the sprite it
+ * changes, which is only known without the zoom; a new size damages
+ * where the sprite will be
+ */
+void sprite::on_provider_texture_queued(const Area & changed) {
+  if(!dirty_tracker::is_enabled() || alpha() <= 0.0f) return;
+  vec2 size = provider->get_size();
+  if(size != texture_size || zoom() > 0.0f || texture_size.x <= 0 || texture_size.y <= 0) {
+    dirty_tracker::damage(damaged_bounds);
+    damaged_bounds = get_frame_bounds(size);
+    dirty_tracker::damage(damaged_bounds);
+    return;
+  }
+
+  Rectf b = get_frame_bounds(texture_size);
+  vec2 pixel = b.getSize() / texture_size;
+  Rectf region(b.getUpperLeft() + vec2(changed.getUL()) * pixel, b.getUpperLeft() + vec2(changed.getLR()) * pixel);
+
+  // the bicubic filter reaches a couple of pixels past the change
+  region.inflate(pixel * 2.0f + vec2(1.0f));
+  dirty_tracker::damage(region.getClipBy(b));
 }
 
 ci::TweenRef<float> sprite::zoom_to(float target, float duration, float delay, EaseFn ease_fn) {
   if (duration <= 0) {
     zoom = target;
     update_zoom();
+    unshare_fbo();
     update_fbo();
     return nullptr;
   } else {
-    return ci::app::timeline().apply(&zoom, glm::clamp(target, 0.0f, 1.0f), duration).delay(delay).easeFn(ease_fn).updateFn([&]{
+    watch();
+    return get_timeline().apply(&zoom, glm::clamp(target, 0.0f, 1.0f), duration).delay(delay).easeFn(ease_fn).updateFn([&]{
       update_zoom();
+      unshare_fbo();
       update_fbo();
     });
   }
@@ -8,6 +8,9 @@
 #include "cinder/gl/Texture.h"
 
 // sfmoma
+#include "cache.h"
+#include "dirty.h"
+#include "preload.h"
 #include "provider.h"
 /////////////////////////////////////////////////
 //
@@ -16,7 +19,11 @@
 //  display of a gl::Texture
 //
 /////////////////////////////////////////////////
-class sprite {
+class sprite : public texture_listener {
+  friend class display_wall;
+  friend class sprite_batch;
+  friend class text_batch;
+
 public:
   //////////////////////////////////////////////////////
   // enums
@@ -39,12 +46,41 @@ public:
   //////////////////////////////////////////////////////
   typedef std::shared_ptr<sprite> sprite_ref;
 
+  // sprites are created from a pool, the sprite and its reference counts in one recycled block
   static sprite_ref create(provider_type type = provider_type::Image);
 
   static sprite_ref create(const texture_provider_ref provider_ref);
+
+  static slab_pool::stats get_pool_stats();
+
+  // fbo composites rendered, and those skipped by sharing another sprite's identical one
+  static uint64_t get_fbo_render_count();
+
+  static uint64_t get_fbo_shared_count();
+
+  static void reset_fbo_stats();
   
+  // warm every shader variant so none are compiled mid-show
   static void init();
 
+  // warm up and preload a manifest of assets, shader variants and render targets,
+  // call update() on the returned preloader each frame until it is complete
+  static preloader_ref init(const preload_manifest & manifest);
+
+  // the format of the fbo each sprite composites into, single sampled and without depth,
+  // use it to reserve render targets, for 8 bit content under the color_policy
+  static ci::gl::Fbo::Format get_fbo_format();
+
+  // the format a sprite composites a texture of input_format into, deep formats stay deep
+  static ci::gl::Fbo::Format get_fbo_format(GLint input_format);
+
+  // the timeline sprites without their own animate on, the app's unless set,
+  // ie. a stepped timeline for offline rendering
+  static ci::Timeline & get_default_timeline();
+
+  // returns the timeline it replaces, null for the app's, to hand back when done
+  static ci::TimelineRef set_default_timeline(ci::TimelineRef timeline);
+
   //////////////////////////////////////////////////////
   // ctr(s) / dctr(s)
   //////////////////////////////////////////////////////
@@ -53,11 +89,13 @@ public:
   sprite(provider_type type = provider_type::Image);
   
   ~sprite() {
-    fbo.reset();
+    if(dirty_tracker::is_enabled()) dirty_tracker::damage(damaged_bounds);
+    unwatch();
+    release_fbo();
     input.reset();
     output.reset();
+    if(provider) provider->remove_listener(this);
     provider.reset();
-    if(texture_update_handler.isConnected()) texture_update_handler.disconnect();
   }
 
   //////////////////////////////////////////////////////
@@ -67,6 +105,8 @@ public:
   
   ci::Rectf get_bounds();
 
+  ci::Timeline & get_timeline();
+
   //////////////////////////////////////////////////////
   // setters
   //////////////////////////////////////////////////////
@@ -74,6 +114,8 @@ public:
 
   void set_coordinates(ci::vec2 new_coords);
 
+  void set_mask_feather(float new_feather);
+
   void set_origin(origin_point new_origin);
   
   void set_premult(bool p);
@@ -86,6 +128,8 @@ public:
 
   void set_source(std::string);
 
+  void set_timeline(ci::TimelineRef new_timeline);
+
   void set_tint(ci::Color new_tint);
 
   void set_zoom(float new_zoom);
@@ -165,13 +209,24 @@ protected:
   // texture
   bool use_premult;            // boolean indicating whether to use premultiplied alpha
   ci::Rectf bounds;           // normalized bounds
-  ci::gl::FboRef fbo;         // an fbo used in the zoom compositing
+  ci::gl::FboRef fbo;         // an fbo used in the zoom compositing, shared by sprites showing the same
+  ci::gl::Fbo::Format fbo_format; // format of the fbo, used to return it to the pool
   origin_point origin;        // the origin by which to scale and translate this sprite
   ci::gl::TextureRef input;   // the original texture
   ci::gl::TextureRef output;  // zoomed and cropped texture
   ci::vec2 texture_size;      // width and height of the texture
   ci::Area zoom_area;         // an area used to zoom into the image
+  float mask_feather;         // width in pixels of the soft mask edge, 0 = hard edge
   ci::vec2 zoom_center;       // the point to zoom into
+  ci::TimelineRef timeline;   // the timeline tweens are applied on, null for the app's
+  uint64_t output_revision;   // the provider revision output shows
+  ci::Rectf damaged_bounds;   // where the dirty_tracker last heard the sprite was
+  float damaged_alpha;        // and how it looked there
+  ci::Color damaged_tint;
+  ci::Rectf damaged_mask;
+  float damaged_zoom;
+  bool watched;               // whether tweens may be changing the sprite
+  size_t watch_index;         // where in the watched sprites
   
   // animatables
   ci::Anim<float> alpha;          // alpha channel
@@ -183,19 +238,46 @@ protected:
   
   // provider
   texture_provider_ref provider;
-  
-  // handlers
-  ci::signals::Connection texture_update_handler;
 
   //////////////////////////////////////////////////////
   // methods
   //////////////////////////////////////////////////////
   void update_zoom();  // update the zoom area
 
-  void update_fbo();   // update the fbo
+  void update_fbo(const ci::Area * region = nullptr);  // update the fbo, or only region of it
   
-  // handle changes in provider's texture
-  void on_provider_texture_update();
+  void update_fbo_region(const ci::Area & changed);  // update the part of the fbo showing changed
+
+  // use the output of another sprite showing the same texture the same way, if one is current
+  bool share_output();
+
+  void unshare_fbo();  // before compositing differently from the sprites sharing the fbo
+
+  void release_fbo();  // back to the pool, once no sprite shares it
+
+  bool draws_direct(); // whether output is the provider's atlas, uncomposited
+
+  // where the sprite is for a texture of size, without delivering updates
+  ci::Rectf get_frame_bounds(ci::vec2 size);
+
+  void damage();  // tell the dirty_tracker the sprite changed
+
+  // damage watched sprites whose tweens changed them, as a dirty_tracker frame begins
+  static void damage_watched();
+
+  void watch();    // compare with the damage recorded each frame while tweens run
+
+  void unwatch();
+
+  bool is_animating();  // whether a tween on the sprite has not finished
+
+  bool changed_since_damage();
+  
+  // handle changes in provider's texture, changed is the area that changed
+  void on_provider_texture_update(const ci::Area & changed) override;
+
+  // damage what a queued update will change, before it is delivered
+  void on_provider_texture_queued(const ci::Area & changed) override;
 
   ci::TweenRef<ci::Rectf> apply_mask_animation(
     ci::Rectf mask_start,
@@ -0,0 +1,387 @@
+// std
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <map>
+
+// cinder
+#include "cinder/Log.h"
+#include "cinder/gl/gl.h"
+
+// sfmoma
+#include "dirty.h"
+#include "profiler.h"
+#include "shader.h"
+#include "text.h"
+
+using namespace ci;
+
+namespace {
+  std::map<std::pair<std::string, float>, gl::TextureFontRef> fonts;
+  gl::GlslProgRef program;
+
+#if defined( CINDER_GL_ES )
+  const char * header =
+    "#version 300 es\n"
+    "precision highp float;\n";
+#else
+  const char * header =
+    "#version 150\n";
+#endif
+
+  const char * vertex_source = R"(
+    uniform mat4 ciModelViewProjection;
+    uniform float uPage;
+    in vec4 ciPosition;
+    in vec2 ciTexCoord0;
+    in vec4 ciColor;
+    in float aPage;
+    out vec2 vTexCoord;
+    out vec4 vColor;
+    void main() {
+      vTexCoord = ciTexCoord0;
+      vColor = ciColor;
+      gl_Position = ciModelViewProjection * ciPosition;
+      // glyphs on other pages are drawn by their page's call, move them out of the clip volume
+      if(abs(aPage - uPage) > 0.5) gl_Position = vec4(2.0, 2.0, 2.0, 1.0);
+    }
+  )";
+
+  const char * fragment_source = R"(
+    uniform sampler2D uTex0;
+    in vec2 vTexCoord;
+    in vec4 vColor;
+    out vec4 oColor;
+    void main() {
+      oColor = vColor * texture(uTex0, vTexCoord);
+    }
+  )";
+
+  gl::GlslProgRef get_program() {
+    if(!program) {
+      try {
+        program = gl::GlslProg::create(gl::GlslProg::Format()
+          .vertex(std::string(header) + vertex_source)
+          .fragment(std::string(header) + fragment_source));
+        program->uniform("uTex0", 0);
+      } catch(const gl::GlslProgExc & e) {
+        CI_LOG_E("Error compiling text batch shader: " << e.what());
+      }
+    }
+    return program;
+  }
+
+  /**
+   * TextureFont keeps where its glyphs are in the atlas to itself,
+   * its members are reached through a pointer to member taken here
+   */
+  class glyph_atlas : public gl::TextureFont {
+  public:
+    static bool find(const gl::TextureFont & font, Font::Glyph glyph, uint8_t & page, Area & area, vec2 & origin_offset) {
+      auto & glyph_map = font.*(&glyph_atlas::mGlyphMap);
+      auto it = glyph_map.find(glyph);
+      if(it == glyph_map.end()) return false;
+      page = it->second.mTextureIndex;
+      area = it->second.mTexCoords;
+      origin_offset = it->second.mOriginOffset;
+      return true;
+    }
+
+    static const std::vector<gl::TextureRef> & get_pages(const gl::TextureFont & font) {
+      return font.*(&glyph_atlas::mTextures);
+    }
+  };
+}
+
+/////////////////////////////////////////////////
+//
+//  text_provider
+//
+/////////////////////////////////////////////////
+text_provider_ref text_provider::create(std::string text, std::string font_name, float font_size) {
+  return create(text, get_font(font_name, font_size));
+}
+
+text_provider_ref text_provider::create(std::string text, gl::TextureFontRef font) {
+  return std::make_shared<text_provider>(font, text);
+}
+
+gl::TextureFontRef text_provider::get_font(std::string font_name, float font_size) {
+  auto key = std::make_pair(font_name, font_size);
+  auto it = fonts.find(key);
+  if(it != fonts.end()) return it->second;
+
+  gl::TextureFontRef font;
+  try {
+    font = gl::TextureFont::create(Font(font_name, font_size));
+  } catch(const std::exception & e) {
+    CI_LOG_E("Error creating font " << font_name << ": " << e.what());
+  }
+  fonts[key] = font;
+  return font;
+}
+
+text_provider::text_provider(gl::TextureFontRef text_font, std::string initial_text) {
+  font = text_font;
+  size = vec2(0);
+  texture_is_new = false;
+  set_text(initial_text);
+}
+
+vec2 text_provider::get_size() {
+  return size;
+}
+
+bool text_provider::is_ready() {
+  return font != nullptr;
+}
+
+std::string text_provider::get_text() {
+  return text;
+}
+
+gl::TextureFontRef text_provider::get_font() {
+  return font;
+}
+
+const text_provider::glyph_run & text_provider::get_glyphs() {
+  return glyphs;
+}
+
+void text_provider::set_source(std::string path) {
+  set_text(path);
+}
+
+/**
+ * Lay out the text once, placements are moved from the baseline
+ * to the top left so they line up with a sprite's coordinates
+ */
+void text_provider::set_text(std::string new_text) {
+  if(new_text == text) return;
+  text = new_text;
+  source = text;
+  if(!font) return;
+
+  SPRITE_PROFILE_SCOPE("text_provider::layout");
+  glyphs = font->getGlyphPlacements(text);
+  vec2 baseline(0, font->getAscent());
+  for(auto & glyph : glyphs) glyph.second += baseline;
+  size = vec2(std::ceil(font->measureString(text).x), std::ceil(font->getAscent() + font->getDescent()));
+  set_texture_changed(Area(ivec2(0), ivec2(size)));
+}
+
+/////////////////////////////////////////////////
+//
+//  text_batch
+//
+/////////////////////////////////////////////////
+text_batch_ref text_batch::create(gl::TextureFontRef font) {
+  return std::make_shared<text_batch>(font);
+}
+
+text_batch::text_batch(gl::TextureFontRef batch_font) {
+  font = batch_font;
+  rewritten = 0;
+  draw_calls = 0;
+  layout_changed = false;
+}
+
+size_t text_batch::size() {
+  return labels.size();
+}
+
+size_t text_batch::get_glyph_count() {
+  return glyph_pages.size();
+}
+
+size_t text_batch::get_rewritten() {
+  return rewritten;
+}
+
+size_t text_batch::get_draw_calls() {
+  return draw_calls;
+}
+
+void text_batch::add(const sprite_ref & sp) {
+  labels.push_back({ sp, nullptr, 0, 0, 0, vec2(0), ColorA8u(0, 0, 0, 0), true });
+  layout_changed = true;
+  if(dirty_tracker::is_enabled()) dirty_tracker::damage(sp->get_bounds());
+}
+
+void text_batch::remove(const sprite_ref & sp) {
+  labels.erase(std::remove_if(labels.begin(), labels.end(), [&](const label & l) { return l.sp == sp; }), labels.end());
+  layout_changed = true;
+  if(dirty_tracker::is_enabled()) dirty_tracker::damage(sp->get_bounds());
+}
+
+void text_batch::clear() {
+  if(dirty_tracker::is_enabled()) {
+    for(auto & l : labels) dirty_tracker::damage(l.sp->get_bounds());
+  }
+  labels.clear();
+  layout_changed = true;
+}
+
+/**
+ * Only labels whose text, position or colour changed are rewritten and
+ * uploaded, a change in any label's glyph count moves the ones after it
+ * so everything is laid out and uploaded again
+ */
+void text_batch::draw() {
+  if(!font) return;
+  SPRITE_PROFILE_SCOPE("text_batch::draw");
+  rewritten = 0;
+  draw_calls = 0;
+
+  // texture_size, which centred labels are placed by, changes when an update is delivered
+  for(auto & l : labels) {
+    if(l.sp->provider) l.sp->provider->deliver_updates();
+  }
+
+  for(auto & l : labels) {
+    auto provider = std::dynamic_pointer_cast<text_provider>(l.sp->provider);
+    size_t count = provider && provider->get_font() == font ? provider->get_glyphs().size() : 0;
+    if(count != l.count) layout_changed = true;
+  }
+
+  bool relayout = layout_changed;
+  if(layout_changed) {
+    size_t offset = 0;
+    for(auto & l : labels) {
+      auto provider = std::dynamic_pointer_cast<text_provider>(l.sp->provider);
+      l.offset = offset;
+      l.count = provider && provider->get_font() == font ? provider->get_glyphs().size() : 0;
+      l.dirty = true;
+      offset += l.count;
+    }
+    vertices.resize(offset * 6);
+    glyph_pages.assign(offset, 0);
+    page_glyphs.assign(glyph_atlas::get_pages(*font).size(), 0);
+    page_glyphs.resize(std::max<size_t>(page_glyphs.size(), 1), 0);
+    page_glyphs[0] = offset;
+    layout_changed = false;
+  }
+
+  // neighbouring rewritten labels are uploaded together
+  size_t run_start = 0, run_count = 0;
+  for(auto & l : labels) {
+    if(l.count == 0) continue;
+    auto & sp = l.sp;
+    auto provider = std::static_pointer_cast<text_provider>(sp->provider);
+    provider->mark_visible();
+
+    vec2 offset = sp->origin == sprite::origin_point::Center ? sp->texture_size * 0.5f : vec2(0);
+    vec2 position = glm::round(sp->coordinates() - offset);
+    ColorA8u color(ColorA(sp->tint(), sp->alpha()));
+    if(!l.dirty && l.provider == provider.get() && l.revision == provider->get_revision() && l.position == position && l.color == color) continue;
+
+    l.position = position;
+    l.color = color;
+    write(l, *provider);
+    rewritten += l.count;
+
+    if(relayout) continue;
+    if(run_count > 0 && run_start + run_count != l.offset) {
+      upload(run_start, run_count);
+      run_count = 0;
+    }
+    if(run_count == 0) run_start = l.offset;
+    run_count += l.count;
+  }
+  if(run_count > 0) upload(run_start, run_count);
+  if(vertices.empty()) return;
+
+  auto prog = get_program();
+  if(!prog) return;
+
+  // a new layout replaces the whole buffer
+  size_t bytes = vertices.size() * sizeof(vertex);
+  if(relayout || !vbo) {
+    if(!vbo || vbo->getSize() < bytes) {
+      vbo = gl::Vbo::create(GL_ARRAY_BUFFER, bytes, vertices.data(), GL_DYNAMIC_DRAW);
+    } else {
+      vbo->bufferSubData(0, bytes, vertices.data());
+    }
+    SPRITE_PROFILE_COUNT("upload_bytes", bytes);
+  }
+  gl::VaoRef & vao = vaos[gl::context()];
+  if(!vao) vao = gl::Vao::create();
+
+  gl::ScopedGlslProg scoped_prog(prog);
+  gl::ScopedVao scoped_vao(vao);
+  gl::ScopedBuffer scoped_vbo(vbo);
+  gl::ScopedBlendAlpha scoped_blend;
+
+  int position = prog->getAttribSemanticLocation(geom::Attrib::POSITION);
+  int uv = prog->getAttribSemanticLocation(geom::Attrib::TEX_COORD_0);
+  int color = prog->getAttribSemanticLocation(geom::Attrib::COLOR);
+  int page = prog->getAttribLocation("aPage");
+  gl::enableVertexAttribArray(position);
+  gl::vertexAttribPointer(position, 2, GL_FLOAT, GL_FALSE, sizeof(vertex), (const GLvoid *)offsetof(vertex, position));
+  gl::enableVertexAttribArray(uv);
+  gl::vertexAttribPointer(uv, 2, GL_FLOAT, GL_FALSE, sizeof(vertex), (const GLvoid *)offsetof(vertex, uv));
+  gl::enableVertexAttribArray(color);
+  gl::vertexAttribPointer(color, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(vertex), (const GLvoid *)offsetof(vertex, color));
+  gl::enableVertexAttribArray(page);
+  gl::vertexAttribPointer(page, 1, GL_FLOAT, GL_FALSE, sizeof(vertex), (const GLvoid *)offsetof(vertex, page));
+  gl::setDefaultShaderVars();
+
+  // one call per atlas page with glyphs on it, a single page for the default character set
+  auto & pages = glyph_atlas::get_pages(*font);
+  for(size_t i = 0; i < pages.size() && i < page_glyphs.size(); i++) {
+    if(page_glyphs[i] == 0) continue;
+    gl::ScopedTextureBind scoped_texture(pages[i], 0);
+    prog->uniform("uPage", (float)i);
+    gl::drawArrays(GL_TRIANGLES, 0, (GLsizei)vertices.size());
+    draw_calls++;
+  }
+  sprite_shader::count_draw_calls(draw_calls);
+  SPRITE_PROFILE_COUNT("draw_calls", draw_calls);
+}
+
+/**
+ * Quads the way TextureFont::drawGlyphs places them, glyphs missing
+ * from the atlas are left as empty quads
+ */
+void text_batch::write(label & l, text_provider & provider) {
+  auto & pages = glyph_atlas::get_pages(*font);
+  auto & run = provider.get_glyphs();
+  for(size_t i = 0; i < l.count; i++) {
+    size_t g = l.offset + i;
+    vertex * quad = &vertices[g * 6];
+    page_glyphs[glyph_pages[g]]--;
+
+    uint8_t page = 0;
+    Area area;
+    vec2 origin_offset;
+    if(!glyph_atlas::find(*font, run[i].first, page, area, origin_offset) || page >= pages.size()) {
+      std::fill(quad, quad + 6, vertex { l.position, vec2(0), l.color, 0.0f });
+      glyph_pages[g] = 0;
+      page_glyphs[0]++;
+      continue;
+    }
+
+    vec2 ul = run[i].second + l.position + vec2(std::floor(origin_offset.x + 0.5f), std::floor(origin_offset.y));
+    Rectf rect(ul, ul + vec2(area.getSize()));
+    Rectf uv = pages[page]->getAreaTexCoords(area);
+    vertex v_ul { rect.getUpperLeft(), uv.getUpperLeft(), l.color, (float)page };
+    vertex v_ur { rect.getUpperRight(), uv.getUpperRight(), l.color, (float)page };
+    vertex v_lr { rect.getLowerRight(), uv.getLowerRight(), l.color, (float)page };
+    vertex v_ll { rect.getLowerLeft(), uv.getLowerLeft(), l.color, (float)page };
+    quad[0] = v_ul; quad[1] = v_ur; quad[2] = v_lr;
+    quad[3] = v_ul; quad[4] = v_lr; quad[5] = v_ll;
+    glyph_pages[g] = page;
+    page_glyphs[page]++;
+  }
+  l.provider = &provider;
+  l.revision = provider.get_revision();
+  l.dirty = false;
+}
+
+void text_batch::upload(size_t first_glyph, size_t count) {
+  if(!vbo) return;
+  size_t offset = first_glyph * 6 * sizeof(vertex);
+  size_t bytes = count * 6 * sizeof(vertex);
+  vbo->bufferSubData(offset, bytes, &vertices[first_glyph * 6]);
+  SPRITE_PROFILE_COUNT("upload_bytes", bytes);
+}
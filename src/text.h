@@ -0,0 +1,193 @@
+#pragma once
+
+// std
+#include <map>
+#include <vector>
+
+// cinder
+#include "cinder/Font.h"
+#include "cinder/gl/Context.h"
+#include "cinder/gl/TextureFont.h"
+#include "cinder/gl/Vao.h"
+#include "cinder/gl/Vbo.h"
+
+// sfmoma
+#include "provider.h"
+#include "sprite.h"
+
+/////////////////////////////////////////////////
+//
+//  text_provider
+//  A single line of text laid out against a glyph
+//  atlas shared by every label using the same font,
+//  the layout is cached until the text changes
+//
+//  There is no 2d texture, sprites using a
+//  text_provider are drawn with a text_batch
+//
+/////////////////////////////////////////////////
+class text_provider : public texture_provider {
+public:
+  //////////////////////////////////////////////////////
+  // static
+  //////////////////////////////////////////////////////
+  typedef std::shared_ptr<text_provider> text_provider_ref;
+  typedef std::vector<std::pair<ci::Font::Glyph, ci::vec2>> glyph_run;
+
+  static text_provider_ref create(std::string text, std::string font_name = "Arial", float font_size = 24.0f);
+
+  static text_provider_ref create(std::string text, ci::gl::TextureFontRef font);
+
+  // the shared atlas for a font, rasterized the first time it is asked for
+  static ci::gl::TextureFontRef get_font(std::string font_name, float font_size);
+
+  //////////////////////////////////////////////////////
+  // ctr(s) / dctr(s)
+  //////////////////////////////////////////////////////
+  text_provider(ci::gl::TextureFontRef font, std::string text);
+
+  //////////////////////////////////////////////////////
+  // getters
+  //////////////////////////////////////////////////////
+  ci::vec2 get_size() override;
+
+  provider_type get_type() override { return provider_type::Text; }
+
+  bool is_ready() override;
+
+  std::string get_text();
+
+  ci::gl::TextureFontRef get_font();
+
+  // glyph placements relative to the top left of the label
+  const glyph_run & get_glyphs();
+
+  //////////////////////////////////////////////////////
+  // setters
+  //////////////////////////////////////////////////////
+  // the source of a text provider is its text
+  void set_source(std::string text) override;
+
+  void set_text(std::string text);
+
+  //////////////////////////////////////////////////////
+  // methods
+  //////////////////////////////////////////////////////
+  void update() override {}
+
+protected:
+  //////////////////////////////////////////////////////
+  // properties
+  //////////////////////////////////////////////////////
+  ci::gl::TextureFontRef font;
+  std::string text;
+  glyph_run glyphs;
+  ci::vec2 size;
+};
+
+//////////////////////////////////////////////////////
+// typedefs
+//////////////////////////////////////////////////////
+typedef text_provider::text_provider_ref text_provider_ref;
+
+/////////////////////////////////////////////////
+//
+//  text_batch
+//  Draws sprites whose providers are text_providers
+//  of one font as quads from the font's atlas, with
+//  one draw call per atlas page
+//
+//  Glyph quads are kept between frames in a vbo,
+//  a label's quads are only rewritten and uploaded
+//  when its text, position or colour changed.
+//  Position, origin, alpha and tint are honoured;
+//  labels draw at the font size, unmasked
+//
+/////////////////////////////////////////////////
+class text_batch {
+public:
+  //////////////////////////////////////////////////////
+  // static
+  //////////////////////////////////////////////////////
+  typedef std::shared_ptr<text_batch> text_batch_ref;
+
+  static text_batch_ref create(ci::gl::TextureFontRef font);
+
+  //////////////////////////////////////////////////////
+  // ctr(s) / dctr(s)
+  //////////////////////////////////////////////////////
+  text_batch(ci::gl::TextureFontRef font);
+
+  //////////////////////////////////////////////////////
+  // getters
+  //////////////////////////////////////////////////////
+  size_t size();
+
+  size_t get_glyph_count();
+
+  // glyphs rewritten by the last draw()
+  size_t get_rewritten();
+
+  // draw calls made by the last draw(), one per atlas page in use
+  size_t get_draw_calls();
+
+  //////////////////////////////////////////////////////
+  // methods
+  //////////////////////////////////////////////////////
+  void add(const sprite_ref & sp);
+
+  void remove(const sprite_ref & sp);
+
+  void clear();
+
+  void draw();
+
+protected:
+  //////////////////////////////////////////////////////
+  // properties
+  //////////////////////////////////////////////////////
+  class label {
+  public:
+    sprite_ref sp;
+    text_provider * provider;  // the provider last written, sprites can swap theirs
+    size_t offset;
+    size_t count;
+    uint64_t revision;  // the provider's revision when written
+    ci::vec2 position;
+    ci::ColorA8u color;
+    bool dirty;
+  };
+
+  class vertex {
+  public:
+    ci::vec2 position;
+    ci::vec2 uv;
+    ci::ColorA8u color;
+    float page;        // the atlas page, quads of other pages are culled
+  };
+
+  ci::gl::TextureFontRef font;
+  std::vector<label> labels;
+  std::vector<vertex> vertices;        // six per glyph
+  std::vector<uint8_t> glyph_pages;    // the atlas page of each glyph
+  std::vector<size_t> page_glyphs;     // glyphs on each atlas page
+  ci::gl::VboRef vbo;
+  std::map<ci::gl::Context *, ci::gl::VaoRef> vaos;  // vaos are not shared between contexts
+  size_t rewritten;
+  size_t draw_calls;
+  bool layout_changed;
+
+  //////////////////////////////////////////////////////
+  // methods
+  //////////////////////////////////////////////////////
+  // write a label's quads at its position and colour
+  void write(label & l, text_provider & provider);
+
+  // bufferSubData the quads of count glyphs
+  void upload(size_t first_glyph, size_t count);
+};
+
+//////////////////////////////////////////////////////
+// typedefs
+//////////////////////////////////////////////////////
+typedef text_batch::text_batch_ref text_batch_ref;
@@ -0,0 +1,394 @@
+// std
+#include <algorithm>
+#include <cmath>
+
+// cinder
+#include "cinder/ImageIo.h"
+#include "cinder/Json.h"
+#include "cinder/Log.h"
+#include "cinder/gl/gl.h"
+#include "cinder/ip/Resize.h"
+
+// sfmoma
+#include "color.h"
+#include "memory.h"
+#include "profiler.h"
+#include "tiled.h"
+
+using namespace ci;
+
+namespace {
+  const int max_uploads_per_frame = 8;
+}
+
+////////////////////////////////////////////////////
+//  static
+////////////////////////////////////////////////////
+tiled_image_provider_ref tiled_image_provider::create(fs::path pyramid, ivec2 output_size) {
+  return std::make_shared<tiled_image_provider>(pyramid, output_size);
+}
+
+void tiled_image_provider::generate(fs::path image, fs::path pyramid, int tile_size, std::string extension) {
+  Surface8u level_surface = Surface8u(loadImage(loadFile(image)));
+  ivec2 size = level_surface.getSize();
+
+  int levels = 1;
+  while(std::max(size.x, size.y) > (tile_size << (levels - 1))) levels++;
+
+  fs::create_directories(pyramid);
+  JsonTree descriptor;
+  descriptor.addChild(JsonTree("width", size.x));
+  descriptor.addChild(JsonTree("height", size.y));
+  descriptor.addChild(JsonTree("tile_size", tile_size));
+  descriptor.addChild(JsonTree("levels", levels));
+  descriptor.addChild(JsonTree("extension", extension));
+  descriptor.write(pyramid / "pyramid.json");
+
+  for(int level = 0; level < levels; level++) {
+    fs::path level_dir = pyramid / std::to_string(level);
+    fs::create_directories(level_dir);
+
+    ivec2 level_size = level_surface.getSize();
+    int cols = (level_size.x + tile_size - 1) / tile_size;
+    int rows = (level_size.y + tile_size - 1) / tile_size;
+    for(int row = 0; row < rows; row++) {
+      for(int col = 0; col < cols; col++) {
+        Area area(col * tile_size, row * tile_size,
+          std::min((col + 1) * tile_size, level_size.x),
+          std::min((row + 1) * tile_size, level_size.y));
+        writeImage(level_dir / (std::to_string(col) + "_" + std::to_string(row) + "." + extension),
+          level_surface.clone(area));
+      }
+    }
+
+    CI_LOG_I("Generated level " << level << " (" << cols << "x" << rows << " tiles)");
+
+    if(level + 1 < levels) {
+      ivec2 next_size = glm::max(ivec2(1), (level_size + ivec2(1)) / 2);
+      level_surface = ip::resize(level_surface, next_size, FilterBox());
+    }
+  }
+}
+
+uint64_t tiled_image_provider::make_key(int level, int col, int row) {
+  return ((uint64_t)level << 48) | ((uint64_t)col << 24) | (uint64_t)row;
+}
+
+//////////////////////////////////////////////////////
+// ctr(s) / dctr(s)
+//////////////////////////////////////////////////////
+tiled_image_provider::tiled_image_provider(fs::path pyramid, ivec2 size) {
+  output_size = size;
+  cache_bytes = 0;
+  cache_budget = 256 * 1024 * 1024;
+  stopping = false;
+  decoding = 0;
+  texture_is_new = false;
+  set_source(pyramid.string());
+
+  // tiles are refetched from disk, so they go after the pooled fbos and cached textures
+  evictor = gpu_memory::add_evictor(2, [this](size_t bytes) {
+    evict(cache_bytes > bytes ? cache_bytes - bytes : 0);
+  });
+}
+
+tiled_image_provider::~tiled_image_provider() {
+  gpu_memory::remove_evictor(evictor);
+  stop();
+}
+
+//////////////////////////////////////////////////////
+// getters
+//////////////////////////////////////////////////////
+vec2 tiled_image_provider::get_size() {
+  return output_size;
+}
+
+ivec2 tiled_image_provider::get_image_size() {
+  return image_size;
+}
+
+size_t tiled_image_provider::get_cache_bytes() {
+  return cache_bytes;
+}
+
+size_t tiled_image_provider::get_resident_tiles() {
+  return tiles.size();
+}
+
+bool tiled_image_provider::is_ready() {
+  return texture != nullptr;
+}
+
+bool tiled_image_provider::is_loading() {
+  std::lock_guard<std::mutex> lock(mutex);
+  return !requests.empty() || !decoded.empty() || decoding > 0;
+}
+
+ivec2 tiled_image_provider::get_level_size(int level) {
+  return glm::max(ivec2(1), (image_size + ivec2((1 << level) - 1)) / (1 << level));
+}
+
+fs::path tiled_image_provider::get_tile_path(uint64_t key) {
+  int level = (int)(key >> 48);
+  int col = (int)((key >> 24) & 0xffffff);
+  int row = (int)(key & 0xffffff);
+  return directory / std::to_string(level) / (std::to_string(col) + "_" + std::to_string(row) + "." + extension);
+}
+
+Area tiled_image_provider::get_visible_tiles(int level) {
+  vec2 level_size = get_level_size(level);
+  int cols = ((int)level_size.x + tile_size - 1) / tile_size;
+  int rows = ((int)level_size.y + tile_size - 1) / tile_size;
+  int x1 = (int)std::floor(view.x1 * level_size.x / tile_size);
+  int y1 = (int)std::floor(view.y1 * level_size.y / tile_size);
+  int x2 = (int)std::ceil(view.x2 * level_size.x / tile_size);
+  int y2 = (int)std::ceil(view.y2 * level_size.y / tile_size);
+  return Area(glm::clamp(x1, 0, cols), glm::clamp(y1, 0, rows), glm::clamp(x2, 0, cols), glm::clamp(y2, 0, rows));
+}
+
+/**
+ * The finest level needed to show the view at output resolution
+ */
+int tiled_image_provider::get_target_level() {
+  float image_pixels_per_output_pixel = view.getWidth() * image_size.x / (float)output_size.x;
+  int level = (int)std::floor(std::log2(std::max(image_pixels_per_output_pixel, 1.0f)));
+  return glm::clamp(level, 0, levels - 1);
+}
+
+//////////////////////////////////////////////////////
+// setters
+//////////////////////////////////////////////////////
+void tiled_image_provider::set_cache_budget(size_t bytes) {
+  cache_budget = bytes;
+  evict(cache_budget);
+}
+
+void tiled_image_provider::set_source(std::string path) {
+  stop();
+  tiles.clear();
+  lru.clear();
+  cache_bytes = 0;
+  texture.reset();
+
+  source = path;
+  directory = path;
+  try {
+    JsonTree descriptor(loadFile(directory / "pyramid.json"));
+    image_size.x = descriptor.getValueForKey<int>("width");
+    image_size.y = descriptor.getValueForKey<int>("height");
+    tile_size = descriptor.getValueForKey<int>("tile_size");
+    levels = descriptor.getValueForKey<int>("levels");
+    extension = descriptor.getValueForKey<std::string>("extension");
+  } catch(const std::exception & e) {
+    CI_LOG_E("Error loading tile pyramid " << path << ": " << e.what());
+    return;
+  }
+
+  if(output_size.x <= 0 || output_size.y <= 0) {
+    float fit = 2048.0f / std::max(image_size.x, image_size.y);
+    output_size = glm::max(ivec2(1), ivec2(vec2(image_size) * std::min(fit, 1.0f)));
+  }
+  gl::Fbo::Format format = gl::Fbo::Format().disableDepth();
+  gpu_memory::reserve(gpu_memory::get_fbo_bytes(output_size, format));
+  fbo = gl::Fbo::create(output_size.x, output_size.y, format);
+  gpu_memory::track(fbo, "tiled_image_provider");
+
+  view = Rectf(0, 0, 1, 1);
+  view_changed = true;
+  start();
+}
+
+bool tiled_image_provider::set_view_area(const Rectf & normalized_area) {
+  Rectf clamped(
+    glm::clamp(normalized_area.x1, 0.0f, 1.0f), glm::clamp(normalized_area.y1, 0.0f, 1.0f),
+    glm::clamp(normalized_area.x2, 0.0f, 1.0f), glm::clamp(normalized_area.y2, 0.0f, 1.0f));
+  if(clamped.getUpperLeft() != view.getUpperLeft() || clamped.getLowerRight() != view.getLowerRight()) {
+    view = clamped;
+    view_changed = true;
+
+    // requests for the old view are stale, anything still needed is requested again
+    std::lock_guard<std::mutex> lock(mutex);
+    for(auto key : requests) requested.erase(key);
+    requests.clear();
+  }
+  return true;
+}
+
+//////////////////////////////////////////////////////
+// methods
+//////////////////////////////////////////////////////
+void tiled_image_provider::start() {
+  stopping = false;
+  decoding = 0;
+  int thread_count = std::max(1, std::min(4, (int)std::thread::hardware_concurrency() - 1));
+  for(int i = 0; i < thread_count; i++) {
+    workers.emplace_back(&tiled_image_provider::decode, this);
+  }
+}
+
+void tiled_image_provider::stop() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+    requests.clear();
+    requested.clear();
+    decoded.clear();
+    decoding = 0;
+  }
+  wake.notify_all();
+  for(auto & worker : workers) {
+    if(worker.joinable()) worker.join();
+  }
+  workers.clear();
+}
+
+/**
+ * Worker loop, decodes requested tiles
+ */
+void tiled_image_provider::decode() {
+  while(true) {
+    uint64_t key;
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      wake.wait(lock, [&] { return stopping || !requests.empty(); });
+      if(stopping) return;
+      key = requests.back();
+      requests.pop_back();
+      decoding++;
+    }
+
+    decoded_tile d;
+    d.key = key;
+    try {
+      d.surface = Surface8u::create(loadImage(loadFile(get_tile_path(key))));
+    } catch(const std::exception & e) {
+      CI_LOG_E("Error decoding tile " << get_tile_path(key) << ": " << e.what());
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if(stopping) return;
+    decoding--;
+    decoded.push_back(d);
+  }
+}
+
+/**
+ * Drop least recently used tiles until the cache fits in limit bytes,
+ * the coarsest level is never evicted so there is always something to show
+ */
+void tiled_image_provider::evict(size_t limit) {
+  auto it = lru.end();
+  while(cache_bytes > limit && it != lru.begin()) {
+    --it;
+    if((int)(*it >> 48) == levels - 1) continue;
+    auto found = tiles.find(*it);
+    cache_bytes -= found->second.bytes;
+    tiles.erase(found);
+    it = lru.erase(it);
+  }
+}
+
+void tiled_image_provider::update() {
+  if(!fbo) return;
+
+  // upload a few decoded tiles per frame
+  bool uploaded = false;
+  for(int i = 0; i < max_uploads_per_frame; i++) {
+    decoded_tile d;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if(decoded.empty()) break;
+      d = decoded.front();
+      decoded.pop_front();
+
+      // a tile that failed to decode stays requested so it is not retried
+      if(d.surface) requested.erase(d.key);
+    }
+    if(!d.surface || tiles.count(d.key)) continue;
+
+    tile t;
+    gl::Texture::Format format = color_policy::get_texture_format()
+      .minFilter(GL_LINEAR).magFilter(GL_LINEAR).wrap(GL_CLAMP_TO_EDGE);
+    t.bytes = gpu_memory::get_texture_bytes(d.surface->getSize(), format.getInternalFormat());
+    gpu_memory::reserve(t.bytes);
+    t.texture = gl::Texture::create(*d.surface, format);
+    gpu_memory::track(t.texture, "tiled_image_provider");
+    lru.push_front(d.key);
+    t.lru = lru.begin();
+    tiles[d.key] = t;
+    cache_bytes += t.bytes;
+    uploaded = true;
+  }
+
+  // request what the view needs, coarse to fine so something shows quickly
+  int target = get_target_level();
+  std::vector<uint64_t> missing;
+  for(int level = levels - 1; level >= target; level--) {
+    Area visible = get_visible_tiles(level);
+    for(int row = visible.y1; row < visible.y2; row++) {
+      for(int col = visible.x1; col < visible.x2; col++) {
+        uint64_t key = make_key(level, col, row);
+        auto found = tiles.find(key);
+        if(found != tiles.end()) {
+          lru.splice(lru.begin(), lru, found->second.lru);
+        } else {
+          missing.push_back(key);
+        }
+      }
+    }
+  }
+
+  if(!missing.empty()) {
+    std::lock_guard<std::mutex> lock(mutex);
+    // requests are taken from the back, so coarse levels decode first
+    for(auto key : missing) {
+      if(requested.insert(key).second) requests.insert(requests.begin(), key);
+    }
+  }
+  if(!missing.empty()) wake.notify_all();
+
+  evict(cache_budget);
+
+  if(uploaded || view_changed) {
+    render();
+    view_changed = false;
+  }
+}
+
+/**
+ * Composite resident tiles into the output, coarse levels first
+ * so finer tiles refine them as they arrive
+ */
+void tiled_image_provider::render() {
+  SPRITE_PROFILE_SCOPE("tiled_image_provider::render");
+  gl::ScopedFramebuffer scoped_fbo(fbo);
+  gl::ScopedMatrices scoped_matrices;
+  gl::ScopedViewport scoped_viewport(ivec2(0), fbo->getSize());
+  gl::setMatricesWindow(fbo->getSize());
+  gl::ScopedColor scoped_color(Color::white());
+  gl::clear(ColorA(0, 0, 0, 0));
+
+  vec2 out = output_size;
+  int target = get_target_level();
+  for(int level = levels - 1; level >= target; level--) {
+    vec2 level_size = get_level_size(level);
+    Area visible = get_visible_tiles(level);
+    for(int row = visible.y1; row < visible.y2; row++) {
+      for(int col = visible.x1; col < visible.x2; col++) {
+        auto found = tiles.find(make_key(level, col, row));
+        if(found == tiles.end()) continue;
+
+        // tile rect normalized to the image, then mapped into the view
+        vec2 ul = vec2(col, row) * (float)tile_size / level_size;
+        vec2 lr = ul + vec2(found->second.texture->getSize()) / level_size;
+        vec2 dst_ul = (ul - view.getUpperLeft()) / view.getSize() * out;
+        vec2 dst_lr = (lr - view.getUpperLeft()) / view.getSize() * out;
+        gl::draw(found->second.texture, Rectf(dst_ul, dst_lr));
+        SPRITE_PROFILE_COUNT("draw_calls", 1);
+      }
+    }
+  }
+
+  set_texture(fbo->getColorTexture());
+}
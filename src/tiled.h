@@ -0,0 +1,164 @@
+#pragma once
+
+// std
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// cinder
+#include "cinder/Filesystem.h"
+#include "cinder/Surface.h"
+#include "cinder/gl/Fbo.h"
+
+// sfmoma
+#include "provider.h"
+
+/////////////////////////////////////////////////
+//
+//  tiled_image_provider
+//  Streams the visible tiles of a multi-resolution
+//  tile pyramid, for images larger than a texture
+//
+//  A pyramid is a directory containing pyramid.json
+//  and one folder per level, level 0 being full
+//  resolution: <level>/<col>_<row>.<extension>
+//
+/////////////////////////////////////////////////
+class tiled_image_provider : public texture_provider {
+public:
+  //////////////////////////////////////////////////////
+  // static
+  //////////////////////////////////////////////////////
+  typedef std::shared_ptr<tiled_image_provider> tiled_image_provider_ref;
+
+  static tiled_image_provider_ref create(ci::fs::path pyramid, ci::ivec2 output_size = ci::ivec2(0));
+
+  // cut an image into a pyramid of tiles, halving the resolution each level
+  static void generate(
+    ci::fs::path image,
+    ci::fs::path pyramid,
+    int tile_size = 512,
+    std::string extension = "jpg");
+
+  //////////////////////////////////////////////////////
+  // ctr(s) / dctr(s)
+  //////////////////////////////////////////////////////
+  // output_size is the resolution of the provider's texture,
+  // by default the image's aspect fit within 2048 x 2048
+  tiled_image_provider(ci::fs::path pyramid, ci::ivec2 output_size = ci::ivec2(0));
+
+  ~tiled_image_provider();
+
+  //////////////////////////////////////////////////////
+  // getters
+  //////////////////////////////////////////////////////
+  ci::vec2 get_size() override;
+
+  // full resolution size of the image
+  ci::ivec2 get_image_size();
+
+  // bytes of tile textures currently resident
+  size_t get_cache_bytes();
+
+  size_t get_resident_tiles();
+
+  provider_type get_type() override { return provider_type::Image; }
+
+  bool is_ready() override;
+
+  // whether tiles are waiting to be decoded or uploaded
+  bool is_loading() override;
+
+  //////////////////////////////////////////////////////
+  // setters
+  //////////////////////////////////////////////////////
+  void set_cache_budget(size_t bytes);
+
+  void set_source(std::string path) override;
+
+  bool set_view_area(const ci::Rectf & normalized_area) override;
+
+  //////////////////////////////////////////////////////
+  // methods
+  //////////////////////////////////////////////////////
+  // upload decoded tiles, request missing ones and recomposite
+  void update() override;
+
+protected:
+  //////////////////////////////////////////////////////
+  // properties
+  //////////////////////////////////////////////////////
+  class tile {
+  public:
+    ci::gl::TextureRef texture;
+    std::list<uint64_t>::iterator lru;
+    size_t bytes;
+  };
+
+  class decoded_tile {
+  public:
+    uint64_t key;
+    ci::Surface8uRef surface;
+  };
+
+  ci::fs::path directory;
+  std::string extension;
+  ci::ivec2 image_size;
+  ci::ivec2 output_size;
+  int tile_size;
+  int levels;
+  ci::Rectf view;
+  bool view_changed;
+  ci::gl::FboRef fbo;
+
+  // lru tile cache, most recently used at the front
+  std::unordered_map<uint64_t, tile> tiles;
+  std::list<uint64_t> lru;
+  size_t cache_bytes;
+  size_t cache_budget;
+  int evictor;
+
+  // decode requests, taken from the back by the workers
+  std::vector<uint64_t> requests;
+  std::set<uint64_t> requested;
+  std::deque<decoded_tile> decoded;
+  int decoding;  // requests taken by a worker and not yet decoded
+  std::mutex mutex;
+  std::condition_variable wake;
+  std::vector<std::thread> workers;
+  bool stopping;
+
+  //////////////////////////////////////////////////////
+  // methods
+  //////////////////////////////////////////////////////
+  static uint64_t make_key(int level, int col, int row);
+
+  ci::ivec2 get_level_size(int level);
+
+  ci::fs::path get_tile_path(uint64_t key);
+
+  // tiles of a level that intersect the view
+  ci::Area get_visible_tiles(int level);
+
+  int get_target_level();
+
+  void decode();
+
+  void evict(size_t limit);
+
+  void start();
+
+  void stop();
+
+  void render();
+};
+
+//////////////////////////////////////////////////////
+// typedefs
+//////////////////////////////////////////////////////
+typedef tiled_image_provider::tiled_image_provider_ref tiled_image_provider_ref;